@@ -1,8 +1,10 @@
-QT       += core gui widgets qml testlib
+QT       += core gui widgets qml testlib concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17 debug
+# Трассировка интервалов (tracing.h) собирается только в отладочной сборке
+CONFIG(debug, debug|release): DEFINES += TASKM_TRACING
 QMAKE_CXXFLAGS += -fprofile-arcs -ftest-coverage
 QMAKE_LFLAGS += -fprofile-arcs -lgcov
 # You can make your code fail to compile if it uses deprecated APIs.
@@ -21,6 +23,26 @@ SOURCES += \
     customdatamanager.cpp \
     namecolordialog.cpp \
     namedialog.cpp \
+    perfmonitor.cpp \
+    perfdialog.cpp \
+    stallwatchdog.cpp \
+    tracing.cpp \
+    schedulelayout.cpp \
+    taskweekview.cpp \
+    taskheatmapview.cpp \
+    taskintervalindex.cpp \
+    freeslotdialog.cpp \
+    autoscheduler.cpp \
+    autoscheduledialog.cpp \
+    recurrence.cpp \
+    tasktreemodel.cpp \
+    taskdependencygraph.cpp \
+    rowbitmap.cpp \
+    taskundostack.cpp \
+    taskhistory.cpp \
+    taskfilewatcher.cpp \
+    lockedsavefile.cpp \
+    tasksync.cpp \
 
 
 HEADERS += \
@@ -34,7 +56,27 @@ HEADERS += \
     taskslot.h \
     customdatamanager.h \
     namecolordialog.h \
-    namedialog.h
+    namedialog.h \
+    perfmonitor.h \
+    perfdialog.h \
+    stallwatchdog.h \
+    tracing.h \
+    schedulelayout.h \
+    taskweekview.h \
+    taskheatmapview.h \
+    taskintervalindex.h \
+    freeslotdialog.h \
+    autoscheduler.h \
+    autoscheduledialog.h \
+    recurrence.h \
+    tasktreemodel.h \
+    taskdependencygraph.h \
+    rowbitmap.h \
+    taskundostack.h \
+    taskhistory.h \
+    taskfilewatcher.h \
+    lockedsavefile.h \
+    tasksync.h
 
 
 # Default rules for deployment.
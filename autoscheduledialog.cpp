@@ -0,0 +1,169 @@
+/**
+ * @file autoscheduledialog.cpp
+ * @brief Реализация диалога автопланирования.
+ */
+#include "autoscheduledialog.h"
+#include "autoscheduler.h"
+#include "taskmodel.h"
+#include "perfmonitor.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QListWidget>
+#include <QTimeEdit>
+#include <QCheckBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <limits>
+
+AutoScheduleDialog::AutoScheduleDialog(TaskModel *model, QWidget *parent)
+    : QDialog(parent), m_model(model)
+{
+    setWindowTitle("Автопланирование");
+    resize(520, 560);
+
+    m_taskList = new QListWidget(this);
+    m_workStartEdit = new QTimeEdit(QTime(9, 0), this);
+    m_workEndEdit = new QTimeEdit(QTime(18, 0), this);
+    m_localSearchCheck = new QCheckBox("Улучшать порядок перестановками", this);
+    m_localSearchCheck->setChecked(true);
+
+    QHBoxLayout *hoursLayout = new QHBoxLayout;
+    hoursLayout->addWidget(m_workStartEdit);
+    hoursLayout->addWidget(new QLabel("—", this));
+    hoursLayout->addWidget(m_workEndEdit);
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow("Рабочее время:", hoursLayout);
+    formLayout->addRow(m_localSearchCheck);
+
+    m_resultList = new QListWidget(this);
+    m_statusLabel = new QLabel(this);
+    QPushButton *calculateButton = new QPushButton("Рассчитать", this);
+    m_applyButton = new QPushButton("Применить", this);
+    m_applyButton->setEnabled(false);
+    QPushButton *cancelButton = new QPushButton("Отмена", this);
+    connect(calculateButton, &QPushButton::clicked, this, &AutoScheduleDialog::calculate);
+    connect(m_applyButton, &QPushButton::clicked, this, &QDialog::accept);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+
+    // Изменение выбора делает предпросмотр устаревшим
+    connect(m_taskList, &QListWidget::itemChanged, this, [this]() {
+        if (m_scheduled.isEmpty())
+            return;
+        m_scheduled.clear();
+        m_resultList->clear();
+        m_applyButton->setEnabled(false);
+        emit previewChanged(m_scheduled);
+    });
+    connect(m_resultList, &QListWidget::currentRowChanged, this, [this](int row) {
+        if (row >= 0 && row < m_scheduled.size())
+            emit dayActivated(m_scheduled[row].startDateTime().date());
+    });
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(calculateButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(m_applyButton);
+    buttonLayout->addWidget(cancelButton);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(new QLabel("Задачи без времени:", this));
+    mainLayout->addWidget(m_taskList, 1);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addWidget(new QLabel("Предлагаемое расписание:", this));
+    mainLayout->addWidget(m_resultList, 1);
+    mainLayout->addWidget(m_statusLabel);
+    mainLayout->addLayout(buttonLayout);
+
+    populateTasks();
+}
+
+void AutoScheduleDialog::populateTasks()
+{
+    QVector<Task> candidates;
+    for (int row = 0; row < m_model->rowCount(); ++row) {
+        const Task task = m_model->getTask(row);
+        if (!task.isProjectTask() && !task.isRecurring() && task.status() != "Выполнено")
+            candidates.append(task);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Task &a, const Task &b) {
+        return a.dueDateTime() < b.dueDateTime();
+    });
+
+    // По умолчанию отмечены задачи, срок которых ещё не прошёл
+    const QDate today = QDate::currentDate();
+    for (const Task &task : std::as_const(candidates)) {
+        QListWidgetItem *item = new QListWidgetItem(QString("%1 — до %2, %3 мин, %4")
+                                                        .arg(task.title())
+                                                        .arg(task.dueDateTime().date().toString("dd.MM.yyyy"))
+                                                        .arg(task.estimatedMinutes())
+                                                        .arg(task.priority()),
+                                                    m_taskList);
+        item->setData(Qt::UserRole, task.uid());
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(task.dueDateTime().date() >= today ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void AutoScheduleDialog::calculate()
+{
+    PerfMonitor::Scope perfScope("autoSchedule");
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<Task> selected;
+    QDate lastDue = QDate::currentDate();
+    int shortest = 24 * 60;
+    for (int i = 0; i < m_taskList->count(); ++i) {
+        QListWidgetItem *item = m_taskList->item(i);
+        if (item->checkState() != Qt::Checked)
+            continue;
+        int row = m_model->findTask(item->data(Qt::UserRole).toUuid());
+        if (row < 0)
+            continue;
+        Task task = m_model->getTask(row);
+        selected.append(task);
+        lastDue = std::max(lastDue, task.dueDateTime().date());
+        shortest = std::min(shortest, task.estimatedMinutes());
+    }
+
+    // Начинаем с ближайших 10 минут, как округляет TaskDialog
+    const QDateTime now = QDateTime::currentDateTime();
+    const int minute = now.time().hour() * 60 + now.time().minute();
+    const int rounded = (minute / 10 + 1) * 10;
+    AutoScheduleOptions options;
+    options.notBefore = QDateTime(now.date(), QTime(0, 0)).addSecs(static_cast<qint64>(rounded) * 60);
+    options.localSearch = m_localSearchCheck->isChecked();
+
+    QVector<FreeSlot> freeSlots;
+    if (!selected.isEmpty()) {
+        freeSlots = m_model->findFreeSlots(shortest, now.date(), lastDue, m_workStartEdit->time(),
+                                           m_workEndEdit->time(), std::numeric_limits<int>::max());
+    }
+    AutoScheduleResult result = AutoScheduler::plan(selected, freeSlots, options);
+    m_scheduled = result.scheduled;
+
+    m_resultList->clear();
+    for (const Task &task : std::as_const(m_scheduled)) {
+        m_resultList->addItem(QString("%1, %2 – %3  %4")
+                                  .arg(task.startDateTime().date().toString("ddd dd.MM"))
+                                  .arg(task.startDateTime().toString("HH:mm"))
+                                  .arg(task.endDateTime().toString("HH:mm"))
+                                  .arg(task.title()));
+    }
+    for (const Task &task : std::as_const(result.unscheduled)) {
+        QListWidgetItem *item = new QListWidgetItem(QString("Не помещается до срока: %1").arg(task.title()), m_resultList);
+        item->setForeground(Qt::red);
+        item->setFlags(Qt::NoItemFlags);
+    }
+    m_applyButton->setEnabled(!m_scheduled.isEmpty());
+    m_statusLabel->setText(QString("Размещено: %1 из %2 (%3 мс, пересчётов: %4)")
+                               .arg(m_scheduled.size())
+                               .arg(selected.size())
+                               .arg(timer.elapsed())
+                               .arg(result.evaluations));
+    emit previewChanged(m_scheduled);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file autoscheduledialog.h
+ * @brief Диалог автопланирования задач без времени.
+ */
+
+#ifndef AUTOSCHEDULEDIALOG_H
+#define AUTOSCHEDULEDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+#include "task.h"
+
+class TaskModel;
+class QListWidget;
+class QTimeEdit;
+class QCheckBox;
+class QLabel;
+class QPushButton;
+
+/**
+ * @class AutoScheduleDialog
+ * @brief Выбор задач без времени, расчёт расписания через AutoScheduler и его предпросмотр.
+ *
+ * Сам диалог модель не меняет: расписание отдаётся сигналом previewChanged
+ * для оверлея, а после подтверждения — через scheduledTasks().
+ */
+class AutoScheduleDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Конструктор AutoScheduleDialog.
+     * @param model Модель задач.
+     * @param parent Родительский виджет.
+     */
+    explicit AutoScheduleDialog(TaskModel *model, QWidget *parent = nullptr);
+
+    /**
+     * @brief Рассчитанное расписание: задачи модели с новым временем.
+     */
+    QVector<Task> scheduledTasks() const { return m_scheduled; }
+
+signals:
+    /**
+     * @brief Расписание пересчитано (пустой список — предпросмотр снят).
+     * @param tasks Задачи с предлагаемым временем.
+     */
+    void previewChanged(const QVector<Task> &tasks);
+    /**
+     * @brief Пользователь выбрал задачу в результатах — показать её день.
+     * @param date День задачи.
+     */
+    void dayActivated(const QDate &date);
+
+private slots:
+    /**
+     * @brief Пересчитать расписание для отмеченных задач.
+     */
+    void calculate();
+
+private:
+    TaskModel *m_model;
+    QListWidget *m_taskList;
+    QTimeEdit *m_workStartEdit;
+    QTimeEdit *m_workEndEdit;
+    QCheckBox *m_localSearchCheck;
+    QListWidget *m_resultList;
+    QLabel *m_statusLabel;
+    QPushButton *m_applyButton;
+    QVector<Task> m_scheduled;
+
+    /**
+     * @brief Заполнить список задач без времени, которые ещё не выполнены.
+     */
+    void populateTasks();
+};
+
+#endif // AUTOSCHEDULEDIALOG_H
@@ -0,0 +1,174 @@
+/**
+ * @file autoscheduler.cpp
+ * @brief Реализация автопланировщика задач без времени.
+ */
+#include "autoscheduler.h"
+#include "tracing.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace AutoScheduler {
+
+namespace {
+
+struct Job {
+    qint64 durationMs = 0;
+    qint64 deadlineMs = 0;
+    int weight = 1;
+};
+
+struct Evaluation {
+    QVector<qint64> startMs;       // -1 — задача не поместилась
+    qint64 missedWeight = 0;
+    qint64 weightedCompletion = 0; // сумма вес × минуты до завершения
+};
+
+bool isBetter(const Evaluation &a, const Evaluation &b)
+{
+    if (a.missedWeight != b.missedWeight)
+        return a.missedWeight < b.missedWeight;
+    return a.weightedCompletion < b.weightedCompletion;
+}
+
+// Жадное размещение в заданном порядке: каждая задача — в начало самого раннего подходящего промежутка
+Evaluation simulate(const QVector<Job> &jobs, const QVector<int> &order,
+                    const QVector<QPair<qint64, qint64>> &freeMs, qint64 originMs)
+{
+    QVector<QPair<qint64, qint64>> gaps = freeMs;
+    Evaluation evaluation;
+    evaluation.startMs.fill(-1, jobs.size());
+    for (int j : order) {
+        const Job &job = jobs[j];
+        bool placed = false;
+        for (int g = 0; g < gaps.size() && gaps[g].first < job.deadlineMs; ++g) {
+            const qint64 end = gaps[g].first + job.durationMs;
+            if (end > gaps[g].second || end > job.deadlineMs)
+                continue;
+            evaluation.startMs[j] = gaps[g].first;
+            evaluation.weightedCompletion += job.weight * ((end - originMs) / 60000);
+            gaps[g].first = end;
+            if (gaps[g].first >= gaps[g].second)
+                gaps.remove(g);
+            placed = true;
+            break;
+        }
+        if (!placed)
+            evaluation.missedWeight += job.weight;
+    }
+    return evaluation;
+}
+
+} // namespace
+
+int priorityWeight(const QString &priority)
+{
+    if (priority == "Высокий")
+        return 3;
+    if (priority == "Низкий")
+        return 1;
+    return 2;
+}
+
+AutoScheduleResult plan(const QVector<Task> &tasks, const QVector<FreeSlot> &freeSlots,
+                        const AutoScheduleOptions &options)
+{
+    TRACE_SCOPE("AutoScheduler::plan");
+    AutoScheduleResult result;
+    if (tasks.isEmpty())
+        return result;
+
+    // Промежутки в миллисекундах, обрезанные по notBefore
+    const qint64 notBeforeMs = options.notBefore.isValid() ? options.notBefore.toMSecsSinceEpoch()
+                                                           : std::numeric_limits<qint64>::min();
+    QVector<QPair<qint64, qint64>> freeMs;
+    freeMs.reserve(freeSlots.size());
+    for (const FreeSlot &slot : freeSlots) {
+        const qint64 start = std::max(slot.start.toMSecsSinceEpoch(), notBeforeMs);
+        const qint64 end = slot.end.toMSecsSinceEpoch();
+        if (start < end)
+            freeMs.append(qMakePair(start, end));
+    }
+    const qint64 originMs = freeMs.isEmpty() ? 0 : freeMs.first().first;
+
+    QVector<Job> jobs(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i) {
+        const Task &task = tasks[i];
+        const QDate due = task.dueDateTime().date();
+        jobs[i].durationMs = static_cast<qint64>(std::max(1, task.estimatedMinutes())) * 60 * 1000;
+        jobs[i].deadlineMs = due.isValid() ? QDateTime(due.addDays(1), QTime(0, 0)).toMSecsSinceEpoch()
+                                           : std::numeric_limits<qint64>::max();
+        jobs[i].weight = priorityWeight(task.priority());
+    }
+
+    // Жадный порядок: ранний срок, затем важнее, затем длиннее (короткие проще доставить в остатки)
+    QVector<int> order(tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&jobs](int a, int b) {
+        if (jobs[a].deadlineMs != jobs[b].deadlineMs)
+            return jobs[a].deadlineMs < jobs[b].deadlineMs;
+        if (jobs[a].weight != jobs[b].weight)
+            return jobs[a].weight > jobs[b].weight;
+        return jobs[a].durationMs > jobs[b].durationMs;
+    });
+
+    Evaluation best = simulate(jobs, order, freeMs, originMs);
+    result.evaluations = 1;
+
+    if (options.localSearch) {
+        bool improved = true;
+        while (improved && result.evaluations < options.maxEvaluations) {
+            improved = false;
+
+            // Не поместившуюся задачу пробуем поставить раньше в очереди
+            for (int pos = 1; pos < order.size() && result.evaluations < options.maxEvaluations; ++pos) {
+                if (best.startMs[order[pos]] >= 0)
+                    continue;
+                for (int target = 0; target < pos && result.evaluations < options.maxEvaluations; ++target) {
+                    QVector<int> candidate = order;
+                    const int job = candidate.takeAt(pos);
+                    candidate.insert(target, job);
+                    Evaluation evaluation = simulate(jobs, candidate, freeMs, originMs);
+                    ++result.evaluations;
+                    if (isBetter(evaluation, best)) {
+                        order = candidate;
+                        best = evaluation;
+                        improved = true;
+                        break;
+                    }
+                }
+            }
+
+            // Перестановки соседей
+            for (int pos = 0; pos + 1 < order.size() && result.evaluations < options.maxEvaluations; ++pos) {
+                std::swap(order[pos], order[pos + 1]);
+                Evaluation evaluation = simulate(jobs, order, freeMs, originMs);
+                ++result.evaluations;
+                if (isBetter(evaluation, best)) {
+                    best = evaluation;
+                    improved = true;
+                } else {
+                    std::swap(order[pos], order[pos + 1]);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < tasks.size(); ++i) {
+        if (best.startMs[i] < 0) {
+            result.unscheduled.append(tasks[i]);
+            continue;
+        }
+        Task task = tasks[i];
+        task.setIsProjectTask(true);
+        task.setStartDateTime(QDateTime::fromMSecsSinceEpoch(best.startMs[i]));
+        task.setEndDateTime(QDateTime::fromMSecsSinceEpoch(best.startMs[i] + jobs[i].durationMs));
+        result.scheduled.append(task);
+    }
+    std::sort(result.scheduled.begin(), result.scheduled.end(), [](const Task &a, const Task &b) {
+        return a.startDateTime() < b.startDateTime();
+    });
+    return result;
+}
+
+} // namespace AutoScheduler
@@ -0,0 +1,64 @@
+/**
+ * @file autoscheduler.h
+ * @brief Автоматическое размещение задач без времени в свободных промежутках.
+ */
+
+#ifndef AUTOSCHEDULER_H
+#define AUTOSCHEDULER_H
+
+#include <QDateTime>
+#include <QVector>
+#include "task.h"
+#include "taskintervalindex.h"
+
+/**
+ * @struct AutoScheduleOptions
+ * @brief Параметры автопланирования.
+ */
+struct AutoScheduleOptions {
+    QDateTime notBefore;       ///< Раньше этого момента задачи не ставятся (обычно — текущее время)
+    bool localSearch = true;   ///< Улучшать жадный порядок перестановками
+    int maxEvaluations = 500;  ///< Предел числа пересчётов расписания при улучшении
+};
+
+/**
+ * @struct AutoScheduleResult
+ * @brief Результат автопланирования.
+ */
+struct AutoScheduleResult {
+    QVector<Task> scheduled;   ///< Копии задач, ставшие задачами по времени, по возрастанию начала
+    QVector<Task> unscheduled; ///< Задачи, которые не поместились до своего срока
+    int evaluations = 0;       ///< Сколько раз пересчитывалось расписание
+};
+
+/**
+ * @brief Функции планировщика не зависят от модели и виджетов: свободные
+ * промежутки передаются снаружи (TaskModel::findFreeSlots), результат
+ * применяется вызывающим одной пачкой.
+ */
+namespace AutoScheduler {
+
+/**
+ * @brief Вес приоритета: «Высокий» — 3, «Низкий» — 1, остальные — 2.
+ */
+int priorityWeight(const QString &priority);
+
+/**
+ * @brief Размещает задачи в свободных промежутках до конца дня их срока.
+ *
+ * Жадный проход берёт задачи по возрастанию срока, затем по убыванию
+ * приоритета и длительности, и ставит каждую в самый ранний подходящий
+ * промежуток. Локальный поиск меняет местами соседние задачи в этом
+ * порядке и поднимает не поместившиеся вперёд, пока это уменьшает вес
+ * непоставленных задач, а при равенстве — взвешенное время завершения.
+ * @param tasks Задачи; длительность берётся из Task::estimatedMinutes.
+ * @param freeSlots Свободные промежутки по возрастанию начала, без пересечений.
+ * @param options Параметры.
+ * @return Размещённые и не поместившиеся задачи.
+ */
+AutoScheduleResult plan(const QVector<Task> &tasks, const QVector<FreeSlot> &freeSlots,
+                        const AutoScheduleOptions &options = AutoScheduleOptions());
+
+} // namespace AutoScheduler
+
+#endif // AUTOSCHEDULER_H
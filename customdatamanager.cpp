@@ -10,6 +10,8 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QDebug>
+#include "lockedsavefile.h"
+#include <algorithm>
 
 // Helper functions for JSON conversion
 QJsonObject colorToJson(const QColor& color) {
@@ -24,6 +26,55 @@ QColor colorFromJson(const QJsonObject& obj) {
     return QColor(obj["r"].toInt(), obj["g"].toInt(), obj["b"].toInt());
 }
 
+/**
+ * @brief Трёхстороннее слияние списка {name, color}: записи, изменённые у нас после прочтения, побеждают.
+ */
+static QJsonArray mergeNamed(const QJsonArray &base, const QJsonArray &ours, const QJsonArray &theirs)
+{
+    auto byName = [](const QJsonArray &array) {
+        QMap<QString, QJsonObject> map;
+        for (const QJsonValue &val : array)
+            map.insert(val.toObject()["name"].toString(), val.toObject());
+        return map;
+    };
+    const QMap<QString, QJsonObject> baseMap = byName(base);
+    const QMap<QString, QJsonObject> ourMap = byName(ours);
+    QMap<QString, QJsonObject> result = byName(theirs);
+    for (auto it = ourMap.constBegin(); it != ourMap.constEnd(); ++it) {
+        if (baseMap.value(it.key()) != it.value())
+            result.insert(it.key(), it.value());
+    }
+    for (auto it = baseMap.constBegin(); it != baseMap.constEnd(); ++it) {
+        if (!ourMap.contains(it.key()))
+            result.remove(it.key());
+    }
+    QJsonArray merged;
+    for (const QJsonObject &obj : std::as_const(result))
+        merged.append(obj);
+    return merged;
+}
+
+/**
+ * @brief Трёхстороннее слияние списка строк: к чужому списку применяются наши добавления и удаления.
+ */
+static QJsonArray mergeList(const QJsonArray &base, const QJsonArray &ours, const QJsonArray &theirs)
+{
+    QJsonArray merged = theirs;
+    for (const QJsonValue &val : ours) {
+        if (!base.contains(val) && !merged.contains(val))
+            merged.append(val);
+    }
+    for (const QJsonValue &val : base) {
+        if (ours.contains(val))
+            continue;
+        for (int i = merged.size() - 1; i >= 0; --i) {
+            if (merged[i] == val)
+                merged.removeAt(i);
+        }
+    }
+    return merged;
+}
+
 
 CustomDataManager::CustomDataManager(QObject *parent) : QObject(parent)
 {
@@ -62,19 +113,41 @@ void CustomDataManager::initializeDefaultData()
 }
 
 
+QJsonObject CustomDataManager::readFile() const
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
 void CustomDataManager::loadData()
 {
     QFile file(m_filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QFile previous(LockedSaveFile::previousPath(m_filePath));
+    // Пропавший файл при целом предыдущем поколении — не повод затирать справочники умолчаниями
+    const bool usePrevious = !file.open(QIODevice::ReadOnly | QIODevice::Text);
+    if (usePrevious && !previous.open(QIODevice::ReadOnly | QIODevice::Text)) {
         qDebug() << "Could not open custom data file for reading, using defaults.";
         saveData(); // Save defaults if file doesn't exist
         return;
     }
+    if (usePrevious)
+        qWarning() << "Custom data file is missing, loading the previous generation.";
 
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(usePrevious ? previous.readAll() : file.readAll(), &parseError);
     file.close();
+    // Испорченный файл — берётся предыдущее поколение (см. LockedSaveFile)
+    if (parseError.error != QJsonParseError::NoError && !usePrevious) {
+        qWarning() << "Custom data file is damaged, loading the previous generation.";
+        if (previous.open(QIODevice::ReadOnly | QIODevice::Text))
+            doc = QJsonDocument::fromJson(previous.readAll());
+    }
 
     QJsonObject rootObj = doc.object();
+    m_base = rootObj;
+    m_version = rootObj["version"].toInteger();
 
     if (rootObj.contains("projects")) {
         QJsonArray projectsArray = rootObj["projects"].toArray();
@@ -97,10 +170,97 @@ void CustomDataManager::loadData()
             m_priorities[obj["name"].toString()] = colorFromJson(obj["color"].toObject());
         }
     }
+    if (rootObj.contains("tags")) {
+        // Порядок тегов в файле задаёт их ID
+        m_tags.clear();
+        m_tagIds.clear();
+        for (const QJsonValue& val : rootObj["tags"].toArray()) {
+            m_tagIds.insert(val.toString(), m_tags.size());
+            m_tags.append(val.toString());
+        }
+    }
     emit dataChanged();
 }
 
 void CustomDataManager::saveData()
+{
+    for (int attempt = 0; attempt < MaxSaveAttempts; ++attempt) {
+        // Файл записал кто-то другой — вливаем его изменения, наши поверх
+        const QJsonObject disk = readFile();
+        const qint64 diskVersion = disk["version"].toInteger();
+        if (!disk.isEmpty() && diskVersion != m_version)
+            applyJson(mergeJson(m_base, toJson(), disk));
+
+        QJsonObject rootObj = toJson();
+        const qint64 version = std::max(diskVersion, m_version) + 1;
+        rootObj["version"] = version;
+        const LockedSaveFile::Result result = LockedSaveFile::write(
+            m_filePath, QJsonDocument(rootObj).toJson(),
+            [&]() { return readFile()["version"].toInteger() == diskVersion; });
+        if (result == LockedSaveFile::Stale)
+            continue;
+        if (result == LockedSaveFile::Failed) {
+            qDebug() << "Could not open custom data file for writing.";
+            return;
+        }
+        m_base = rootObj;
+        m_version = version;
+        return;
+    }
+    qDebug() << "Custom data file keeps changing, giving up on save.";
+}
+
+QJsonObject CustomDataManager::mergeJson(const QJsonObject &base, const QJsonObject &ours, const QJsonObject &theirs)
+{
+    QJsonObject merged;
+    merged["projects"] = mergeNamed(base["projects"].toArray(), ours["projects"].toArray(), theirs["projects"].toArray());
+    merged["priorities"] = mergeNamed(base["priorities"].toArray(), ours["priorities"].toArray(), theirs["priorities"].toArray());
+    merged["statuses"] = mergeList(base["statuses"].toArray(), ours["statuses"].toArray(), theirs["statuses"].toArray());
+    // ID тега — его номер в списке, поэтому теги только дописываются в конец
+    QJsonArray tags = theirs["tags"].toArray();
+    for (const QJsonValue &val : ours["tags"].toArray()) {
+        if (!tags.contains(val))
+            tags.append(val);
+    }
+    merged["tags"] = tags;
+    return merged;
+}
+
+void CustomDataManager::applyJson(const QJsonObject &rootObj)
+{
+    m_projects.clear();
+    for (const QJsonValue& val : rootObj["projects"].toArray()) {
+        QJsonObject obj = val.toObject();
+        m_projects[obj["name"].toString()] = colorFromJson(obj["color"].toObject());
+    }
+    m_priorities.clear();
+    for (const QJsonValue& val : rootObj["priorities"].toArray()) {
+        QJsonObject obj = val.toObject();
+        m_priorities[obj["name"].toString()] = colorFromJson(obj["color"].toObject());
+    }
+    m_statuses.clear();
+    for (const QJsonValue& val : rootObj["statuses"].toArray())
+        m_statuses.append(val.toString());
+    const QStringList oldTags = m_tags;
+    m_tags.clear();
+    m_tagIds.clear();
+    for (const QJsonValue& val : rootObj["tags"].toArray()) {
+        m_tagIds.insert(val.toString(), m_tags.size());
+        m_tags.append(val.toString());
+    }
+    // Теги, заведённые здесь одновременно с чужими, сдвигаются в конец — задачам нужны новые ID
+    QHash<int, int> remapped;
+    for (int id = 0; id < oldTags.size(); ++id) {
+        const int newId = m_tagIds.value(oldTags[id], -1);
+        if (newId >= 0 && newId != id)
+            remapped.insert(id, newId);
+    }
+    if (!remapped.isEmpty())
+        emit tagsRemapped(remapped);
+    emit dataChanged();
+}
+
+QJsonObject CustomDataManager::toJson() const
 {
     QJsonObject rootObj;
 
@@ -124,20 +284,32 @@ void CustomDataManager::saveData()
         prioritiesArray.append(obj);
     }
     rootObj["priorities"] = prioritiesArray;
-
-    QFile file(m_filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qDebug() << "Could not open custom data file for writing.";
-        return;
-    }
-    file.write(QJsonDocument(rootObj).toJson());
-    file.close();
+    rootObj["tags"] = QJsonArray::fromStringList(m_tags);
+    return rootObj;
 }
 
 
 const QMap<QString, QColor>& CustomDataManager::getProjects() const { return m_projects; }
 const QStringList& CustomDataManager::getStatuses() const { return m_statuses; }
 const QMap<QString, QColor>& CustomDataManager::getPriorities() const { return m_priorities; }
+const QStringList& CustomDataManager::getTags() const { return m_tags; }
+
+int CustomDataManager::tagId(const QString& name) const { return m_tagIds.value(name, -1); }
+QString CustomDataManager::tagName(int id) const { return m_tags.value(id); }
+
+int CustomDataManager::internTag(const QString& name) {
+    const QString trimmed = name.trimmed();
+    if (trimmed.isEmpty()) return -1;
+    auto it = m_tagIds.constFind(trimmed);
+    if (it != m_tagIds.constEnd()) return it.value();
+    const int id = m_tags.size();
+    m_tags.append(trimmed);
+    m_tagIds.insert(trimmed, id);
+    saveData();
+    emit dataChanged();
+    // Слияние при сохранении могло сдвинуть новый тег за чужие
+    return m_tagIds.value(trimmed, id);
+}
 
 QColor CustomDataManager::getProjectColor(const QString& name) const { return m_projects.value(name, QColor(100, 100, 100)); }
 QColor CustomDataManager::getPriorityColor(const QString& name) const { return m_priorities.value(name, Qt::gray); }
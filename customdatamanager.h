@@ -6,6 +6,8 @@
 #include <QColor>
 #include <QMap>
 #include <QStringList>
+#include <QHash>
+#include <QJsonObject>
 
 /**
  * @file customdatamanager.h
@@ -28,6 +30,11 @@ public:
     void loadData();
     /**
      * @brief Сохраняет пользовательские данные в файл.
+     *
+     * Если файл с последнего чтения записал другой процесс (номер записи
+     * «version» другой), его изменения сначала вливаются: по имени проекта,
+     * статуса или приоритета, изменённое у нас побеждает. Файл заменяется
+     * атомарно под блокировкой (LockedSaveFile).
      */
     void saveData();
 
@@ -47,6 +54,32 @@ public:
      */
     const QMap<QString, QColor>& getPriorities() const;
 
+    /**
+     * @brief Возвращает список тегов; номер в списке — ID тега.
+     * @return QStringList тегов.
+     */
+    const QStringList& getTags() const;
+    /**
+     * @brief ID тега по имени.
+     * @param name Имя тега.
+     * @return ID или -1, если такого тега нет.
+     */
+    int tagId(const QString& name) const;
+    /**
+     * @brief Имя тега по ID.
+     * @param id ID тега.
+     * @return Имя или пустая строка.
+     */
+    QString tagName(int id) const;
+    /**
+     * @brief Получить ID тега, добавив тег при первом использовании.
+     *
+     * ID не переиспользуются: задачи хранят их, а не имена.
+     * @param name Имя тега.
+     * @return ID или -1 для пустого имени.
+     */
+    int internTag(const QString& name);
+
     /**
      * @brief Получить цвет проекта по имени.
      * @param name Имя проекта.
@@ -121,18 +154,38 @@ public:
 
 signals:
     void dataChanged();
+    /**
+     * @brief После слияния с файлом наши новые теги получили другие ID (старый → новый).
+     */
+    void tagsRemapped(const QHash<int, int> &ids);
 
 private:
+    static constexpr int MaxSaveAttempts = 5;
+
     void initializeDefaultData();
+    QJsonObject readFile() const;
+    QJsonObject toJson() const;
+    /**
+     * @brief Заменить данные содержимым JSON-объекта файла.
+     */
+    void applyJson(const QJsonObject &rootObj);
+    /**
+     * @brief Трёхстороннее слияние: base — файл при последнем чтении или записи.
+     */
+    static QJsonObject mergeJson(const QJsonObject &base, const QJsonObject &ours, const QJsonObject &theirs);
 
     QMap<QString, QColor> m_projects;
     QStringList m_statuses;
     QMap<QString, QColor> m_priorities;
+    QStringList m_tags;
+    QHash<QString, int> m_tagIds;
     QStringList m_systemProjects;
     QStringList m_systemStatuses;
     QStringList m_systemPriorities;
 
     QString m_filePath;
+    QJsonObject m_base;  // файл в том виде, в каком мы его последний раз читали или писали
+    qint64 m_version = 0; // номер записи этого файла
 };
 
 #endif // CUSTOMDATAMANAGER_H
@@ -0,0 +1,133 @@
+/**
+ * @file freeslotdialog.cpp
+ * @brief Реализация диалога поиска свободного времени.
+ */
+#include "freeslotdialog.h"
+#include "taskmodel.h"
+#include "perfmonitor.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSpinBox>
+#include <QDateEdit>
+#include <QTimeEdit>
+#include <QCheckBox>
+#include <QListWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QElapsedTimer>
+#include <algorithm>
+
+FreeSlotDialog::FreeSlotDialog(TaskModel *model, QWidget *parent)
+    : QDialog(parent), m_model(model)
+{
+    setWindowTitle("Свободное время");
+    resize(460, 420);
+
+    m_durationSpin = new QSpinBox(this);
+    m_durationSpin->setRange(5, 24 * 60);
+    m_durationSpin->setSingleStep(15);
+    m_durationSpin->setValue(90);
+    m_durationSpin->setSuffix(" мин");
+
+    const QDate today = QDate::currentDate();
+    m_fromEdit = new QDateEdit(today, this);
+    m_fromEdit->setCalendarPopup(true);
+    m_toEdit = new QDateEdit(today.addDays(7 - today.dayOfWeek()), this);
+    m_toEdit->setCalendarPopup(true);
+
+    m_workHoursCheck = new QCheckBox("Только рабочее время", this);
+    m_workHoursCheck->setChecked(true);
+    m_workStartEdit = new QTimeEdit(QTime(9, 0), this);
+    m_workEndEdit = new QTimeEdit(QTime(18, 0), this);
+    connect(m_workHoursCheck, &QCheckBox::toggled, m_workStartEdit, &QWidget::setEnabled);
+    connect(m_workHoursCheck, &QCheckBox::toggled, m_workEndEdit, &QWidget::setEnabled);
+
+    QHBoxLayout *hoursLayout = new QHBoxLayout;
+    hoursLayout->addWidget(m_workStartEdit);
+    hoursLayout->addWidget(new QLabel("—", this));
+    hoursLayout->addWidget(m_workEndEdit);
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow("Длительность:", m_durationSpin);
+    formLayout->addRow("С:", m_fromEdit);
+    formLayout->addRow("По:", m_toEdit);
+    formLayout->addRow(m_workHoursCheck, hoursLayout);
+
+    m_resultList = new QListWidget(this);
+    m_statusLabel = new QLabel(this);
+    QPushButton *searchButton = new QPushButton("Найти", this);
+    QPushButton *createButton = new QPushButton("Создать задачу", this);
+    QPushButton *closeButton = new QPushButton("Закрыть", this);
+    connect(searchButton, &QPushButton::clicked, this, &FreeSlotDialog::search);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+
+    auto chooseCurrent = [this]() {
+        int row = m_resultList->currentRow();
+        if (row < 0 || row >= m_slots.size())
+            return;
+        const QDateTime start = m_slots[row].start;
+        emit slotChosen(start, start.addSecs(static_cast<qint64>(durationMinutes()) * 60));
+        accept();
+    };
+    connect(createButton, &QPushButton::clicked, this, chooseCurrent);
+    connect(m_resultList, &QListWidget::itemDoubleClicked, this, chooseCurrent);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(searchButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(createButton);
+    buttonLayout->addWidget(closeButton);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addWidget(m_resultList, 1);
+    mainLayout->addWidget(m_statusLabel);
+    mainLayout->addLayout(buttonLayout);
+
+    search();
+}
+
+int FreeSlotDialog::durationMinutes() const
+{
+    return m_durationSpin->value();
+}
+
+void FreeSlotDialog::search()
+{
+    PerfMonitor::Scope perfScope("freeSlots");
+    QElapsedTimer timer;
+    timer.start();
+
+    QTime workStart;
+    QTime workEnd;
+    if (m_workHoursCheck->isChecked()) {
+        workStart = m_workStartEdit->time();
+        workEnd = m_workEndEdit->time();
+    }
+
+    // Прошедшее время не предлагаем: сегодняшние промежутки обрезаются текущим моментом
+    const QDateTime now = QDateTime::currentDateTime();
+    const int duration = durationMinutes();
+    const int maxResults = 20;
+    QVector<FreeSlot> found = m_model->findFreeSlots(duration, std::max(m_fromEdit->date(), now.date()),
+                                                     m_toEdit->date(), workStart, workEnd, maxResults + 1);
+    m_slots.clear();
+    for (FreeSlot slot : found) {
+        if (slot.start < now)
+            slot.start = QDateTime(now.date(), QTime(now.time().hour(), now.time().minute())).addSecs(60);
+        if (slot.start.secsTo(slot.end) >= static_cast<qint64>(duration) * 60 && m_slots.size() < maxResults)
+            m_slots.append(slot);
+    }
+
+    m_resultList->clear();
+    for (const FreeSlot &slot : std::as_const(m_slots)) {
+        m_resultList->addItem(QString("%1, %2 – %3")
+                                  .arg(slot.start.date().toString("ddd dd.MM.yyyy"))
+                                  .arg(slot.start.toString("HH:mm"))
+                                  .arg(slot.end.toString("HH:mm")));
+    }
+    if (!m_slots.isEmpty())
+        m_resultList->setCurrentRow(0);
+    m_statusLabel->setText(QString("Найдено: %1 (%2 мс)").arg(m_slots.size()).arg(timer.elapsed()));
+}
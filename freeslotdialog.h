@@ -0,0 +1,68 @@
+/**
+ * @file freeslotdialog.h
+ * @brief Диалог поиска свободного времени в расписании.
+ */
+
+#ifndef FREESLOTDIALOG_H
+#define FREESLOTDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+#include "taskintervalindex.h"
+
+class TaskModel;
+class QSpinBox;
+class QDateEdit;
+class QTimeEdit;
+class QCheckBox;
+class QListWidget;
+class QLabel;
+
+/**
+ * @class FreeSlotDialog
+ * @brief Ищет самые ранние свободные промежутки заданной длины через TaskModel::findFreeSlots.
+ */
+class FreeSlotDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Конструктор FreeSlotDialog.
+     * @param model Модель задач.
+     * @param parent Родительский виджет.
+     */
+    explicit FreeSlotDialog(TaskModel *model, QWidget *parent = nullptr);
+
+    /**
+     * @brief Длительность, заданная пользователем, в минутах.
+     */
+    int durationMinutes() const;
+
+signals:
+    /**
+     * @brief Пользователь выбрал промежуток для новой задачи.
+     * @param start Начало задачи.
+     * @param end Конец задачи (начало + длительность).
+     */
+    void slotChosen(const QDateTime &start, const QDateTime &end);
+
+private slots:
+    /**
+     * @brief Выполнить поиск с текущими параметрами.
+     */
+    void search();
+
+private:
+    TaskModel *m_model;
+    QSpinBox *m_durationSpin;
+    QDateEdit *m_fromEdit;
+    QDateEdit *m_toEdit;
+    QCheckBox *m_workHoursCheck;
+    QTimeEdit *m_workStartEdit;
+    QTimeEdit *m_workEndEdit;
+    QListWidget *m_resultList;
+    QLabel *m_statusLabel;
+    QVector<FreeSlot> m_slots;
+};
+
+#endif // FREESLOTDIALOG_H
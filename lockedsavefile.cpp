@@ -0,0 +1,56 @@
+/**
+ * @file lockedsavefile.cpp
+ * @brief Реализация атомарной записи файла под межпроцессной блокировкой.
+ */
+#include "lockedsavefile.h"
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+
+LockedSaveFile::Result LockedSaveFile::write(const QString &filePath, const QByteArray &data,
+                                             const std::function<bool()> &isCurrent)
+{
+    TRACE_SCOPE("LockedSaveFile::write");
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        qWarning() << "Couldn't write" << filePath;
+        file.cancelWriting();
+        return Failed;
+    }
+    return commit(file, isCurrent);
+}
+
+LockedSaveFile::Result LockedSaveFile::commit(QSaveFile &file, const std::function<bool()> &isCurrent)
+{
+    const QString filePath = file.fileName();
+    // Копия для предыдущего поколения снимается до блокировки: время под ней не зависит
+    // от размера файла. Что копия совпадает с заменяемым файлом, подтверждает isCurrent
+    const QString previous = previousPath(filePath);
+    const QString staged = previous + QString(".%1").arg(QCoreApplication::applicationPid());
+    QFile::remove(staged);
+    const bool hasStaged = QFile::exists(filePath) && QFile::copy(filePath, staged);
+
+    QLockFile lock(lockPath(filePath));
+    if (!lock.tryLock(LockTimeoutMs)) {
+        qWarning() << "Couldn't lock" << filePath;
+        file.cancelWriting();
+        QFile::remove(staged);
+        return Failed;
+    }
+    if (isCurrent && !isCurrent()) {
+        file.cancelWriting();
+        QFile::remove(staged);
+        return Stale;
+    }
+
+    // Под блокировкой — только переименования: копия становится предыдущим поколением,
+    // новый файл встаёт поверх прежнего, и читатель ни в какой момент не видит его отсутствующим
+    if (hasStaged && (!QFile::exists(previous) || QFile::remove(previous)) && !QFile::rename(staged, previous)) {
+        qWarning() << "Couldn't keep the previous generation of" << filePath;
+        QFile::remove(staged);
+    }
+    return file.commit() ? Written : Failed;
+}
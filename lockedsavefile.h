@@ -0,0 +1,63 @@
+/**
+ * @file lockedsavefile.h
+ * @brief Атомарная запись файла, согласованная между процессами через QLockFile.
+ */
+
+#ifndef LOCKEDSAVEFILE_H
+#define LOCKEDSAVEFILE_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+class QSaveFile;
+
+/**
+ * @class LockedSaveFile
+ * @brief Запись «временный файл + переименование» под блокировкой filePath.lock.
+ *
+ * Данные пишутся во временный файл рядом с целевым без блокировки; блокировка
+ * берётся только на проверку версии и переименование, поэтому другие окна
+ * TaskM и скрипты ждут её миллисекунды. Читателям блокировка не нужна:
+ * после переименования они видят либо старый, либо новый файл целиком.
+ *
+ * QSaveFile сбрасывает временный файл на диск до переименования, поэтому
+ * сбой питания оставляет целым либо старый, либо новый файл. Копия прежнего
+ * файла снимается ещё до блокировки и под ней переименовывается в filePath.prev —
+ * предыдущее поколение, к которому можно вернуться, если текущее всё же окажется
+ * повреждённым. Сама замена — одно атомарное переименование поверх файла.
+ */
+class LockedSaveFile
+{
+public:
+    static constexpr int LockTimeoutMs = 2000;
+
+    enum Result {
+        Written, ///< Файл заменён
+        Stale,   ///< Файл успел измениться после чтения — нужно влить изменения и повторить
+        Failed   ///< Не удалось записать или дождаться блокировки
+    };
+
+    /**
+     * @brief Заменить filePath данными data.
+     * @param isCurrent Проверка под блокировкой, что на диске всё ещё прочитанная версия;
+     *        пустая функция — без проверки.
+     */
+    static Result write(const QString &filePath, const QByteArray &data,
+                        const std::function<bool()> &isCurrent = {});
+    /**
+     * @brief Завершить запись, которую вызывающий вёл в file сам (большие файлы пишутся потоком).
+     *
+     * file должен быть открыт и дописан; блокировка, проверка isCurrent и
+     * предыдущее поколение — как у write. При Stale и Failed запись отменяется.
+     */
+    static Result commit(QSaveFile &file, const std::function<bool()> &isCurrent = {});
+
+    static QString lockPath(const QString &filePath) { return filePath + ".lock"; }
+    /**
+     * @brief Предыдущее поколение файла: его содержимое до последней записи.
+     */
+    static QString previousPath(const QString &filePath) { return filePath + ".prev"; }
+};
+
+#endif // LOCKEDSAVEFILE_H
@@ -39,25 +39,55 @@
 #include <QCloseEvent>
 #include <QTimer>
 #include <QTime>
+#include "perfmonitor.h"
+#include "tracing.h"
+#include <QScrollBar>
+#include <algorithm>
+#include "perfdialog.h"
+#include "stallwatchdog.h"
+#include "taskweekview.h"
+#include "taskheatmapview.h"
+#include "freeslotdialog.h"
+#include "autoscheduledialog.h"
+#include "tasktreemodel.h"
+#include "taskundostack.h"
+#include "taskhistory.h"
+#include "taskfilewatcher.h"
+#include "tasksync.h"
+#include "lockedsavefile.h"
+#include <QTreeView>
+#include <QListWidget>
+#include <QTreeWidget>
+#include <QJsonArray>
+#include <QDateTimeEdit>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
     m_dataManager(new CustomDataManager(this)),
     taskModel(new TaskModel(this, m_dataManager)),
+    undoStack(new TaskUndoStack(taskModel, this)),
+    taskHistory(new TaskHistory(taskModel, QString(), this)),
+    fileWatcher(new TaskFileWatcher(taskModel, QString(), this)),
     proxyModel(new TaskFilterProxyModel(this)),
     allTasksView(nullptr),
+    taskDelegate(nullptr),
     timeSlotsTable(nullptr),
     dateFilterEdit(nullptr),
     taskTypeCombo(nullptr),
     filterTitleLabel(nullptr),
     titleFilterEdit(nullptr),
+    tagFilterEdit(nullptr),
     statusFilterCombo(nullptr),
     priorityFilterCombo(nullptr),
     deadlineFilterCombo(nullptr),
     projectFilterCombo(nullptr),
     isProjectTaskFilterCombo(nullptr),
     todayButton(nullptr),
-    overlay(nullptr)
+    overlay(nullptr),
+    m_stallWatchdog(new StallWatchdog(200, this))
 {
     proxyModel->setSourceModel(taskModel);
     setupUI();
@@ -65,11 +95,25 @@ MainWindow::MainWindow(QWidget *parent)
     loadTasks();
     refreshAllViews();
 
+    // Чужие изменения файла влиты в модель (при слежении за файлом или перед сохранением) поштучно,
+    // выделение в списке сохраняется
+    connect(taskModel, &TaskModel::tasksFileApplied, this, [this](int changes) {
+        if (changes == 0)
+            return;
+        updateTimeSlotsTable();
+        if (overlay)
+            overlay->updateOverlay();
+        resizeVisibleRows();
+        statusBar()->showMessage(QString("Задачи обновлены из файла: изменений — %1").arg(changes), 5000);
+    });
+
     m_overdueTaskTimer = new QTimer(this);
     connect(m_overdueTaskTimer, &QTimer::timeout, this, &MainWindow::checkForOverdueTasks);
     m_overdueTaskTimer->start(60000); // Check every minute
     checkForOverdueTasks(); // Initial check on startup
 
+    m_stallWatchdog->startWatching();
+
     // Scroll to current time
     int currentHour = QTime::currentTime().hour();
     if (timeSlotsTable && timeSlotsTable->rowCount() > currentHour) {
@@ -95,7 +139,12 @@ void MainWindow::setupUI() {
     allTasksView->setWordWrap(true);
     allTasksView->verticalHeader()->setVisible(false);
     allTasksView->setColumnWidth(1, 240); // Сделать столбец даты шире для полной даты и времени
-    allTasksView->resizeRowsToContents();
+    // Строки вне экрана остаются высоты по умолчанию и измеряются при прокрутке
+    allTasksView->verticalHeader()->setDefaultSectionSize(40);
+    taskDelegate = new TaskDelegate(allTasksView);
+    taskDelegate->watchModel(taskModel);
+    allTasksView->setItemDelegate(taskDelegate);
+    connect(allTasksView->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::resizeVisibleRows);
 
     timeSlotsTable = new QTableWidget(24, 1, this);
     timeSlotsTable->setHorizontalHeaderLabels({"Задачи"});
@@ -134,6 +183,7 @@ void MainWindow::setupUI() {
     connect(quickAddEdit, &QLineEdit::returnPressed, this, [this, quickAddEdit]() {
         QString text = quickAddEdit->text().trimmed();
         if (text.isEmpty()) return;
+        PerfMonitor::Scope perfScope("add");
 
         QString title = text;
         QString project = "Обычная задача";
@@ -183,6 +233,10 @@ void MainWindow::setupUI() {
     titleFilterEdit = new QLineEdit(this);
     titleFilterEdit->setPlaceholderText("Фильтр по названию...");
 
+    tagFilterEdit = new QLineEdit(this);
+    tagFilterEdit->setPlaceholderText("срочно отчёт|план -дом");
+    tagFilterEdit->setToolTip("Пробел — «и», «|» — «или», «-» — без тега");
+
     dateFilterEdit = new QDateEdit(QDate::currentDate(), this);
     dateFilterEdit->setCalendarPopup(true);
     todayButton = new QPushButton("Сегодня", this);
@@ -220,6 +274,9 @@ void MainWindow::setupUI() {
     filterLayout->addWidget(new QLabel("Название:", this));
     filterLayout->addWidget(titleFilterEdit);
     filterLayout->addSpacing(10);
+    filterLayout->addWidget(new QLabel("Теги:", this));
+    filterLayout->addWidget(tagFilterEdit);
+    filterLayout->addSpacing(10);
     filterLayout->addWidget(new QLabel("Дата:", this));
     QHBoxLayout *dateLayout = new QHBoxLayout;
     dateLayout->addWidget(dateFilterEdit);
@@ -254,10 +311,52 @@ void MainWindow::setupUI() {
 
     // Панель инструментов
     QToolBar *toolBar = addToolBar("Действия");
+    QAction *undoAction = toolBar->addAction("Отменить", this, [this]() {
+        PerfMonitor::Scope perfScope("undo");
+        undoStack->undo();
+        refreshAllViews();
+        saveTasks();
+    });
+    undoAction->setShortcut(QKeySequence::Undo);
+    QAction *redoAction = toolBar->addAction("Повторить", this, [this]() {
+        PerfMonitor::Scope perfScope("undo");
+        undoStack->redo();
+        refreshAllViews();
+        saveTasks();
+    });
+    redoAction->setShortcut(QKeySequence::Redo);
+    auto updateUndoActions = [this, undoAction, redoAction]() {
+        undoAction->setEnabled(undoStack->canUndo());
+        undoAction->setToolTip(undoStack->canUndo() ? "Отменить: " + undoStack->undoText() : "Нечего отменять");
+        redoAction->setEnabled(undoStack->canRedo());
+        redoAction->setToolTip(undoStack->canRedo() ? "Повторить: " + undoStack->redoText() : "Нечего повторять");
+    };
+    connect(undoStack, &TaskUndoStack::changed, this, updateUndoActions);
+    updateUndoActions();
     toolBar->addAction("Добавить задачу", this, &MainWindow::addTask);
     toolBar->addAction("Редактировать", this, &MainWindow::editTask);
     toolBar->addAction("Удалить", this, &MainWindow::deleteTask);
+    toolBar->addAction("История", this, &MainWindow::showTaskHistory);
+    toolBar->addAction("На дату", this, &MainWindow::showTaskListAsOf);
+    QAction *trashAction = toolBar->addAction("Корзина", this, &MainWindow::showTrash);
+    auto updateTrashAction = [this, trashAction]() {
+        trashAction->setText(taskModel->deletedCount() > 0
+                                 ? QString("Корзина (%1)").arg(taskModel->deletedCount())
+                                 : QString("Корзина"));
+    };
+    connect(taskModel, &TaskModel::trashChanged, this, updateTrashAction);
+    updateTrashAction();
     toolBar->addAction("Экспорт в CSV", this, &MainWindow::exportToCSV);
+    toolBar->addAction("Синхронизация", this, &MainWindow::syncTasks);
+    toolBar->addAction("Подзадачи", this, &MainWindow::showTaskTree);
+    toolBar->addAction("Неделя", this, &MainWindow::showWeekView);
+    toolBar->addAction("Загрузка", this, &MainWindow::showHeatmap);
+    toolBar->addAction("Свободное время", this, &MainWindow::showFreeSlotFinder);
+    toolBar->addAction("Автопланирование", this, &MainWindow::showAutoScheduler);
+    toolBar->addAction("Диагностика", this, [this]() {
+        PerfDialog dialog(this);
+        dialog.exec();
+    });
 
     // Статус бар
     QPushButton *addButton = new QPushButton("Добавить", this);
@@ -293,21 +392,40 @@ void MainWindow::setupUI() {
 
     // Подключаем сигналы для обновления оверлея
     connect(overlay, &TaskScheduleOverlay::editTaskRequested, this, [this](const Task &task, int proxyRow) {
+        if (task.isOccurrence()) {
+            editOccurrence(task);
+            return;
+        }
         if (task.startDateTime().isValid() && proxyRow >= 0) {
             qDebug() << "Edit task requested for time:" << task.startDateTime();
-            TaskDialog dialog(m_dataManager, this, task);
+            TaskDialog dialog(m_dataManager, this, task, taskModel);
             if (dialog.exec() == QDialog::Accepted) {
-                Task editedTask = dialog.getTask();
-                QModelIndex idx = proxyModel->index(proxyRow, 0);
-                QModelIndex sourceIdx = proxyModel->mapToSource(idx);
-                taskModel->updateTask(sourceIdx.row(), editedTask);
+                // Пока диалог открыт, файл могли перечитать — применяются только изменённые поля
+                PerfMonitor::Scope perfScope("edit");
+                if (taskModel->applyEdit(task, dialog.getTask()) < 0)
+                    return;
                 refreshAllViews();
             }
         }
     });
 
+    // Перетаскивание в оверлее: одна фиксация в модели и одно сохранение на отпускание
+    connect(overlay, &TaskScheduleOverlay::taskTimeChanged, this, [this](const Task &task) {
+        PerfMonitor::Scope perfScope("drag");
+        int row = taskModel->findTask(task.uid());
+        if (row < 0)
+            return;
+        if (task.isOccurrence())
+            taskModel->setOccurrenceOverride(task.uid(), task.occurrenceDate(), task);
+        else
+            taskModel->updateTask(row, task);
+        refreshAllViews();
+        saveTasks();
+    });
+
     // --- Connections ---
     connect(todayButton, &QPushButton::clicked, this, [this]() {
+        PerfMonitor::Scope perfScope("date");
         // Set date in widget
         dateFilterEdit->setDate(QDate::currentDate());
         // Directly set filter in model to ensure it always applies
@@ -315,42 +433,57 @@ void MainWindow::setupUI() {
         refreshAllViews();
     });
     connect(allDatesButton, &QPushButton::clicked, this, [this]() {
+        PerfMonitor::Scope perfScope("date");
         // Clear the filter in the model
         proxyModel->setFilterDate(QDate());
         refreshAllViews();
     });
     connect(projectFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+        PerfMonitor::Scope perfScope("filter");
         proxyModel->setFilterProjectType(projectFilterCombo->currentData().toString());
         refreshAllViews();
     });
     connect(titleFilterEdit, &QLineEdit::textChanged, [this]() {
+        PerfMonitor::Scope perfScope("filter");
         proxyModel->setFilterTitle(titleFilterEdit->text());
         refreshAllViews();
     });
+    connect(tagFilterEdit, &QLineEdit::textChanged, [this]() {
+        PerfMonitor::Scope perfScope("filter");
+        proxyModel->setFilterTags(TagFilter::parse(tagFilterEdit->text(), m_dataManager));
+        refreshAllViews();
+    });
     connect(dateFilterEdit, &QDateEdit::dateChanged, [this]() {
+        PerfMonitor::Scope perfScope("date");
         proxyModel->setFilterDate(dateFilterEdit->date());
         refreshAllViews();
     });
     connect(statusFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+        PerfMonitor::Scope perfScope("filter");
         proxyModel->setFilterStatus(statusFilterCombo->currentData().toString());
         refreshAllViews();
     });
     connect(priorityFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+        PerfMonitor::Scope perfScope("filter");
         proxyModel->setFilterPriority(priorityFilterCombo->currentData().toString());
         refreshAllViews();
     });
     connect(deadlineFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+        PerfMonitor::Scope perfScope("filter");
         proxyModel->setFilterDeadlineType(deadlineFilterCombo->currentData().toInt());
         refreshAllViews();
     });
     connect(isProjectTaskFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+        PerfMonitor::Scope perfScope("filter");
         proxyModel->setFilterIsProjectTask(isProjectTaskFilterCombo->currentData().toInt());
         refreshAllViews();
     });
     connect(resetFiltersButton, &QPushButton::clicked, this, [this]() {
+        PerfMonitor::Scope perfScope("filter");
         // Сбросить все фильтры
         projectFilterCombo->setCurrentIndex(0); // Все проекты
         titleFilterEdit->clear();
+        tagFilterEdit->clear();
         dateFilterEdit->setDate(QDate::currentDate());
         statusFilterCombo->setCurrentIndex(0); // Любой статус
         priorityFilterCombo->setCurrentIndex(0); // Любой приоритет
@@ -358,6 +491,7 @@ void MainWindow::setupUI() {
         isProjectTaskFilterCombo->setCurrentIndex(0); // Все
         proxyModel->setFilterProjectType("");
         proxyModel->setFilterTitle("");
+        proxyModel->setFilterTags(TagFilter());
         proxyModel->setFilterStatus("");
         proxyModel->setFilterPriority("");
         proxyModel->setFilterDeadlineType(0);
@@ -367,10 +501,15 @@ void MainWindow::setupUI() {
     });
 
     connect(allTasksView->horizontalHeader(), &QHeaderView::sectionResized, this, [this]() {
-        allTasksView->resizeRowsToContents();
+        resizeVisibleRows();
     });
 
     connect(m_dataManager, &CustomDataManager::dataChanged, this, &MainWindow::updateCombos);
+    connect(m_dataManager, &CustomDataManager::tagsRemapped, this, [this](const QHash<int, int> &ids) {
+        taskModel->remapTags(ids);
+        proxyModel->setFilterTags(TagFilter::parse(tagFilterEdit->text(), m_dataManager));
+        refreshAllViews();
+    });
     updateCombos();
 }
 
@@ -381,22 +520,32 @@ void MainWindow::setupConnections() {
             // Редактирование существующей задачи
             QModelIndex sourceIndex = proxyModel->mapToSource(index);
             Task originalTask = taskModel->getTask(sourceIndex.row());
-            TaskDialog dialog(m_dataManager, this, originalTask);
-            connect(&dialog, &TaskDialog::taskDeleted, this, [this, sourceIndex]() {
-                taskModel->removeTask(sourceIndex.row());
+            // Строки могут сдвинуться, пока открыт диалог (перечитан файл), поэтому держится UID
+            const QUuid uid = originalTask.uid();
+            TaskDialog dialog(m_dataManager, this, originalTask, taskModel);
+            connect(&dialog, &TaskDialog::taskDeleted, this, [this, uid]() {
+                const int row = taskModel->findTask(uid);
+                if (row < 0)
+                    return;
+                PerfMonitor::Scope perfScope("delete");
+                // Вместе с удалением отменяется и перенос подзадач
+                TaskUndoStack::Group group(undoStack, "Удаление задачи");
+                taskModel->removeTask(row);
                 refreshAllViews();
                 saveTasks();
             });
             if (dialog.exec() == QDialog::Accepted) {
-                Task updatedTask = dialog.getTask();
-                taskModel->updateTask(sourceIndex.row(), updatedTask);
+                PerfMonitor::Scope perfScope("edit");
+                if (taskModel->applyEdit(originalTask, dialog.getTask()) < 0)
+                    return;
                 refreshAllViews();
                 saveTasks();
             }
         } else {
             // Двойной клик по пустому месту — создание новой задачи
-            TaskDialog dialog(m_dataManager, this);
+            TaskDialog dialog(m_dataManager, this, Task(), taskModel);
             if (dialog.exec() == QDialog::Accepted) {
+                PerfMonitor::Scope perfScope("add");
                 Task newTask = dialog.getTask();
                 taskModel->addTask(newTask);
                 refreshAllViews();
@@ -421,10 +570,11 @@ void MainWindow::setupConnections() {
 }
 
 void MainWindow::refreshAllViews() {
-    qDebug() << "Refreshing all views...";
+    TRACE_SCOPE("MainWindow::refreshAllViews");
+    qCDebug(lcTaskHotPath) << "Refreshing all views...";
     updateTimeSlotsTable();
     if (overlay) {
-        qDebug() << "Updating overlay...";
+        qCDebug(lcTaskHotPath) << "Updating overlay...";
         QDate dateForOverlay = proxyModel->filterDate();
         if (!dateForOverlay.isValid()) {
             dateForOverlay = QDate::currentDate();
@@ -436,14 +586,30 @@ void MainWindow::refreshAllViews() {
     allTasksView->clearSelection();
     allTasksView->setCurrentIndex(QModelIndex());
     allTasksView->clearFocus();
-    allTasksView->resizeRowsToContents();
+    resizeVisibleRows();
+}
+
+void MainWindow::resizeVisibleRows() {
+    if (!allTasksView) return;
+    PerfMonitor::Scope perfScope("resizeRowsToContents");
+    TRACE_SCOPE("MainWindow::resizeVisibleRows");
+
+    // Высоты считаются только для строк в видимой области; TaskDelegate кэширует их по UID
+    int viewportHeight = allTasksView->viewport()->height();
+    int rowCount = proxyModel->rowCount();
+    for (int row = std::max(0, allTasksView->rowAt(0)); row >= 0 && row < rowCount; ++row) {
+        if (allTasksView->rowViewportPosition(row) >= viewportHeight)
+            break;
+        allTasksView->resizeRowToContents(row);
+    }
 }
 
 void MainWindow::addTask() {
     qDebug() << "Adding new task...";
-    TaskDialog dialog(m_dataManager, this);
+    TaskDialog dialog(m_dataManager, this, Task(), taskModel);
     dialog.setDueDateTime(QDateTime(QDate::currentDate(), QTime(0, 0)));
     if (dialog.exec() == QDialog::Accepted) {
+        PerfMonitor::Scope perfScope("add");
         Task task = dialog.getTask();
         qDebug() << "Task dialog accepted, adding task to model:"
                  << "title:" << task.title()
@@ -467,10 +633,11 @@ void MainWindow::addTaskForTime(int hour) {
         );
     QDateTime endDateTime = startDateTime.addSecs(3600); // По умолчанию 1 час
 
-    TaskDialog dialog(m_dataManager, this, Task("", "Работа", startDateTime, endDateTime, "В работе", ""));
+    TaskDialog dialog(m_dataManager, this, Task("", "Работа", startDateTime, endDateTime, "В работе", ""), taskModel);
     dialog.setDueDateTime(startDateTime);
 
     if (dialog.exec() == QDialog::Accepted) {
+        PerfMonitor::Scope perfScope("add");
         Task task = dialog.getTask();
         qDebug() << "Task dialog accepted, adding task to model:"
                  << "title:" << task.title()
@@ -496,7 +663,7 @@ void MainWindow::editTask() {
 
     // Преобразуем индекс прокси-модели в индекс исходной модели
     QModelIndex sourceIndex = proxyModel->mapToSource(index);
-    int taskIndex = sourceIndex.row();
+    const int taskIndex = sourceIndex.row();
 
     Task originalTask = taskModel->getTask(taskIndex);
     qDebug() << "Editing task:"
@@ -506,9 +673,10 @@ void MainWindow::editTask() {
              << "start:" << originalTask.startDateTime()
              << "end:" << originalTask.endDateTime();
 
-    TaskDialog dialog(m_dataManager, this, originalTask);
+    TaskDialog dialog(m_dataManager, this, originalTask, taskModel);
 
     if (dialog.exec() == QDialog::Accepted) {
+        PerfMonitor::Scope perfScope("edit");
         Task updatedTask = dialog.getTask();
         qDebug() << "Task dialog accepted, updating task in model:"
                  << "title:" << updatedTask.title()
@@ -516,7 +684,9 @@ void MainWindow::editTask() {
                  << "projectType:" << updatedTask.projectType()
                  << "start:" << updatedTask.startDateTime()
                  << "end:" << updatedTask.endDateTime();
-        taskModel->updateTask(taskIndex, updatedTask);
+        // Пока диалог открыт, файл могли перечитать — применяются только изменённые поля
+        if (taskModel->applyEdit(originalTask, updatedTask) < 0)
+            return;
         refreshAllViews();
         saveTasks();
     } else {
@@ -530,10 +700,15 @@ void MainWindow::deleteTask() {
 
     // Преобразуем индекс прокси-модели в индекс исходной модели
     QModelIndex sourceIndex = proxyModel->mapToSource(index);
-    int taskIndex = sourceIndex.row();
+    const QUuid uid = taskModel->getTask(sourceIndex.row()).uid();
 
     if (QMessageBox::question(this, "Удаление",
-                              "Вы уверены, что хотите удалить задачу?") == QMessageBox::Yes) {
+                              "Переместить задачу в корзину?") == QMessageBox::Yes) {
+        const int taskIndex = taskModel->findTask(uid);
+        if (taskIndex < 0)
+            return;
+        PerfMonitor::Scope perfScope("delete");
+        TaskUndoStack::Group group(undoStack, "Удаление задачи");
         taskModel->removeTask(taskIndex);
         refreshAllViews();
         saveTasks();
@@ -597,7 +772,12 @@ void MainWindow::onRemoveProject()
         }
     }
 
-    taskModel->replaceProjectInTasks(affectedTasks, "Обычная задача");
+    {
+        TaskUndoStack::Group group(undoStack, QString("Удаление проекта «%1»").arg(projectToDelete));
+        // Номера строк, найденные до подтверждения, могли устареть
+        affectedTasks = taskModel->findTasksUsingProject(projectToDelete);
+        taskModel->replaceProjectInTasks(affectedTasks, "Обычная задача");
+    }
     m_dataManager->removeProject(projectToDelete);
     // updateCombos is called automatically via signal from dataManager
     refreshAllViews();
@@ -637,7 +817,12 @@ void MainWindow::onRemoveStatus()
         }
     }
 
-    taskModel->replaceStatusInTasks(affectedTasks, "Не начато");
+    {
+        TaskUndoStack::Group group(undoStack, QString("Удаление статуса «%1»").arg(statusToDelete));
+        // Номера строк, найденные до подтверждения, могли устареть
+        affectedTasks = taskModel->findTasksUsingStatus(statusToDelete);
+        taskModel->replaceStatusInTasks(affectedTasks, "Не начато");
+    }
     m_dataManager->removeStatus(statusToDelete);
     refreshAllViews();
     saveTasks();
@@ -676,7 +861,12 @@ void MainWindow::onRemovePriority()
         }
     }
 
-    taskModel->replacePriorityInTasks(affectedTasks, "Средний");
+    {
+        TaskUndoStack::Group group(undoStack, QString("Удаление приоритета «%1»").arg(priorityToDelete));
+        // Номера строк, найденные до подтверждения, могли устареть
+        affectedTasks = taskModel->findTasksUsingPriority(priorityToDelete);
+        taskModel->replacePriorityInTasks(affectedTasks, "Средний");
+    }
     m_dataManager->removePriority(priorityToDelete);
     refreshAllViews();
     saveTasks();
@@ -727,7 +917,8 @@ void MainWindow::updateCombos()
 }
 
 void MainWindow::updateTimeSlotsTable() {
-    qDebug() << "Updating time slots table...";
+    TRACE_SCOPE("MainWindow::updateTimeSlotsTable");
+    qCDebug(lcTaskHotPath) << "Updating time slots table...";
     // Отключаем обновление виджета для оптимизации
     timeSlotsTable->setUpdatesEnabled(false);
 
@@ -752,7 +943,7 @@ void MainWindow::updateTimeSlotsTable() {
     timeSlotsTable->setUpdatesEnabled(true);
 
     if (overlay) {
-        qDebug() << "Updating overlay after time slots table update..."
+        qCDebug(lcTaskHotPath) << "Updating overlay after time slots table update..."
                  << "Overlay geometry:" << overlay->geometry()
                  << "Table viewport geometry:" << timeSlotsTable->viewport()->rect();
         overlay->setGeometry(timeSlotsTable->viewport()->rect());
@@ -785,6 +976,433 @@ void MainWindow::showTaskDetails(const QModelIndex &index) {
     QMessageBox::information(this, "Детали задачи", details);
 }
 
+void MainWindow::showWeekView() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Неделя");
+
+    TaskWeekView *weekView = new TaskWeekView(taskModel, m_dataManager, &dialog);
+    QPushButton *prevButton = new QPushButton("<", &dialog);
+    QPushButton *currentButton = new QPushButton("Сегодня", &dialog);
+    QPushButton *nextButton = new QPushButton(">", &dialog);
+    QLabel *weekLabel = new QLabel(&dialog);
+
+    QHBoxLayout *navLayout = new QHBoxLayout();
+    navLayout->addWidget(prevButton);
+    navLayout->addWidget(currentButton);
+    navLayout->addWidget(nextButton);
+    navLayout->addWidget(weekLabel, 1);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addLayout(navLayout);
+    layout->addWidget(weekView, 1);
+
+    auto updateWeekLabel = [weekLabel](const QDate &monday) {
+        weekLabel->setText(QString("%1 — %2").arg(monday.toString("dd.MM.yyyy"),
+                                                  monday.addDays(6).toString("dd.MM.yyyy")));
+    };
+    connect(weekView, &TaskWeekView::visibleWeekChanged, weekLabel, updateWeekLabel);
+    connect(prevButton, &QPushButton::clicked, weekView, [weekView]() { weekView->scrollWeeks(-1); });
+    connect(nextButton, &QPushButton::clicked, weekView, [weekView]() { weekView->scrollWeeks(1); });
+    connect(currentButton, &QPushButton::clicked, weekView, [weekView]() { weekView->setWeek(QDate::currentDate()); });
+    connect(weekView, &TaskWeekView::editTaskRequested, this, [this](const QUuid &uid) {
+        const int row = taskModel->findTask(uid);
+        if (row < 0)
+            return;
+        const Task original = taskModel->getTask(row);
+        TaskDialog taskDialog(m_dataManager, this, original, taskModel);
+        if (taskDialog.exec() == QDialog::Accepted) {
+            PerfMonitor::Scope perfScope("edit");
+            if (taskModel->applyEdit(original, taskDialog.getTask()) < 0)
+                return;
+            refreshAllViews();
+            saveTasks();
+        }
+    });
+
+    weekView->setWeek(dateFilterEdit->date());
+    updateWeekLabel(weekView->visibleWeekStart());
+    dialog.resize(1000, 650);
+    dialog.exec();
+}
+
+void MainWindow::showTaskTree() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Подзадачи");
+
+    // Дерево загружает уровни по мере разворачивания; фильтр оставляет видимыми предков подходящих подзадач
+    TaskTreeModel *treeModel = new TaskTreeModel(taskModel, &dialog);
+    TaskFilterProxyModel *treeProxy = new TaskFilterProxyModel(&dialog);
+    treeProxy->setSourceModel(treeModel);
+    treeProxy->setHierarchyModel(taskModel);
+    // Фильтры списка, кроме даты: подзадачи обычно разнесены по разным дням
+    treeProxy->setFilterProjectType(projectFilterCombo->currentData().toString());
+    treeProxy->setFilterTitle(titleFilterEdit->text());
+    treeProxy->setFilterStatus(statusFilterCombo->currentData().toString());
+    treeProxy->setFilterPriority(priorityFilterCombo->currentData().toString());
+    treeProxy->setFilterDeadlineType(deadlineFilterCombo->currentData().toInt());
+    treeProxy->setFilterIsProjectTask(isProjectTaskFilterCombo->currentData().toInt());
+    treeProxy->setFilterTags(TagFilter::parse(tagFilterEdit->text(), m_dataManager));
+
+    QLineEdit *filterEdit = new QLineEdit(titleFilterEdit->text(), &dialog);
+    filterEdit->setPlaceholderText("Фильтр по названию...");
+    QTreeView *treeView = new QTreeView(&dialog);
+    treeView->setModel(treeProxy);
+    treeView->setUniformRowHeights(true);
+    treeView->header()->setSectionResizeMode(TaskModel::TitleColumn, QHeaderView::Stretch);
+    treeView->header()->setStretchLastSection(false);
+    QPushButton *addChildButton = new QPushButton("Добавить подзадачу", &dialog);
+    QPushButton *editButton = new QPushButton("Редактировать", &dialog);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(addChildButton);
+    buttonLayout->addWidget(editButton);
+    buttonLayout->addStretch(1);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(filterEdit);
+    layout->addWidget(treeView, 1);
+    layout->addLayout(buttonLayout);
+
+    auto currentUid = [treeModel, treeProxy, treeView]() {
+        return treeModel->uidForIndex(treeProxy->mapToSource(treeView->currentIndex()));
+    };
+    auto editCurrent = [this, &dialog, currentUid]() {
+        const QUuid uid = currentUid();
+        const int row = taskModel->findTask(uid);
+        if (row < 0)
+            return;
+        const Task original = taskModel->getTask(row);
+        TaskDialog taskDialog(m_dataManager, &dialog, original, taskModel);
+        if (taskDialog.exec() == QDialog::Accepted) {
+            PerfMonitor::Scope perfScope("edit");
+            if (taskModel->applyEdit(original, taskDialog.getTask()) < 0)
+                return;
+            refreshAllViews();
+            saveTasks();
+        }
+    };
+    connect(filterEdit, &QLineEdit::textChanged, treeProxy, &TaskFilterProxyModel::setFilterTitle);
+    connect(treeView, &QTreeView::doubleClicked, &dialog, editCurrent);
+    connect(editButton, &QPushButton::clicked, &dialog, editCurrent);
+    connect(addChildButton, &QPushButton::clicked, &dialog, [this, &dialog, currentUid]() {
+        Task child;
+        child.setParentUid(currentUid());
+        TaskDialog taskDialog(m_dataManager, &dialog, child, taskModel);
+        if (taskDialog.exec() == QDialog::Accepted) {
+            PerfMonitor::Scope perfScope("add");
+            taskModel->addTask(taskDialog.getTask());
+            refreshAllViews();
+            saveTasks();
+        }
+    });
+
+    dialog.resize(800, 550);
+    dialog.exec();
+}
+
+void MainWindow::showTaskHistory() {
+    QModelIndex index = allTasksView->currentIndex();
+    if (!index.isValid()) return;
+    const Task task = taskModel->getTask(proxyModel->mapToSource(index).row());
+
+    PerfMonitor::Scope perfScope("history");
+    const QVector<TaskHistory::Revision> revisions = taskHistory->revisions(task.uid());
+
+    auto valueText = [](const QJsonValue &value) -> QString {
+        if (value.isNull() || value.isUndefined())
+            return "—";
+        if (value.isBool())
+            return value.toBool() ? "да" : "нет";
+        if (value.isDouble())
+            return QString::number(value.toDouble());
+        if (value.isArray())
+            return QString("%1 знач.").arg(value.toArray().size());
+        if (value.isObject())
+            return "…";
+        const QDateTime dateTime = QDateTime::fromString(value.toString(), Qt::ISODate);
+        return dateTime.isValid() ? dateTime.toString("dd.MM.yyyy HH:mm") : value.toString();
+    };
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("История «%1»").arg(task.title()));
+    QTreeWidget *tree = new QTreeWidget(&dialog);
+    tree->setHeaderLabels({"Когда", "Кто", "Изменение"});
+    // Новые ревизии сверху
+    for (auto it = revisions.crbegin(); it != revisions.crend(); ++it) {
+        static const char *kinds[] = {"Создана", "Изменена", "Удалена"};
+        QTreeWidgetItem *item = new QTreeWidgetItem(tree, {it->at.toString("dd.MM.yyyy HH:mm:ss"),
+                                                           it->fromFile ? QString("из файла") : it->user,
+                                                           kinds[it->kind]});
+        if (it->kind != TaskHistory::Revision::Updated)
+            continue;
+        QStringList fields;
+        for (auto field = it->after.constBegin(); field != it->after.constEnd(); ++field) {
+            if (field.key() == "wasModified")
+                continue;
+            fields.append(TaskHistory::fieldTitle(field.key()));
+            new QTreeWidgetItem(item, {QString(), QString(),
+                                       QString("%1: %2 → %3").arg(TaskHistory::fieldTitle(field.key()),
+                                                                  valueText(it->before.value(field.key())),
+                                                                  valueText(field.value()))});
+        }
+        item->setText(2, QString("Изменена: %1").arg(fields.join(", ")));
+    }
+    if (revisions.isEmpty())
+        new QTreeWidgetItem(tree, {QString(), QString(), "Изменений пока не было"});
+    tree->header()->setSectionResizeMode(2, QHeaderView::Stretch);
+
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(tree);
+    dialog.resize(650, 450);
+    dialog.exec();
+}
+
+void MainWindow::showTaskListAsOf() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Задачи на дату");
+
+    QDateTimeEdit *atEdit = new QDateTimeEdit(QDateTime::currentDateTime().addDays(-7), &dialog);
+    atEdit->setCalendarPopup(true);
+    atEdit->setDisplayFormat("dd.MM.yyyy HH:mm");
+    atEdit->setMaximumDateTime(QDateTime::currentDateTime());
+    QPushButton *showButton = new QPushButton("Показать", &dialog);
+    QLabel *infoLabel = new QLabel(&dialog);
+
+    // Отдельная модель только для чтения: текущие задачи и журнал не меняются
+    TaskModel *snapshot = new TaskModel(&dialog, m_dataManager);
+    QTableView *view = new QTableView(&dialog);
+    view->setModel(snapshot);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setSelectionMode(QAbstractItemView::SingleSelection);
+    view->setWordWrap(true);
+    view->verticalHeader()->setVisible(false);
+    view->verticalHeader()->setDefaultSectionSize(40);
+    view->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    TaskDelegate *delegate = new TaskDelegate(view);
+    delegate->watchModel(snapshot);
+    view->setItemDelegate(delegate);
+
+    QHBoxLayout *topLayout = new QHBoxLayout();
+    topLayout->addWidget(new QLabel("Состояние на:", &dialog));
+    topLayout->addWidget(atEdit);
+    topLayout->addWidget(showButton);
+    topLayout->addStretch(1);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addLayout(topLayout);
+    layout->addWidget(view, 1);
+    layout->addWidget(infoLabel);
+
+    auto rebuild = [this, atEdit, snapshot, infoLabel]() {
+        PerfMonitor::Scope perfScope("asOf");
+        QElapsedTimer timer;
+        timer.start();
+        snapshot->setTasks(taskHistory->tasksAsOf(atEdit->dateTime()));
+        infoLabel->setText(QString("Задач: %1, восстановлено за %2 мс")
+                               .arg(snapshot->rowCount()).arg(timer.elapsed()));
+    };
+    connect(showButton, &QPushButton::clicked, &dialog, rebuild);
+    connect(atEdit, &QDateTimeEdit::editingFinished, &dialog, rebuild);
+    rebuild();
+
+    dialog.resize(800, 550);
+    dialog.exec();
+}
+
+void MainWindow::showTrash() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Корзина");
+
+    QListWidget *list = new QListWidget(&dialog);
+    list->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    QLabel *hint = new QLabel(QString("Задачи хранятся в корзине %1 дней после удаления.")
+                                  .arg(TaskModel::TrashRetentionDays), &dialog);
+    QPushButton *restoreButton = new QPushButton("Восстановить", &dialog);
+    QPushButton *deleteButton = new QPushButton("Удалить навсегда", &dialog);
+    QPushButton *emptyButton = new QPushButton("Очистить корзину", &dialog);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(restoreButton);
+    buttonLayout->addWidget(deleteButton);
+    buttonLayout->addStretch(1);
+    buttonLayout->addWidget(emptyButton);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(hint);
+    layout->addWidget(list, 1);
+    layout->addLayout(buttonLayout);
+
+    auto fill = [this, list, restoreButton, deleteButton, emptyButton]() {
+        list->clear();
+        for (const TaskModel::DeletedTask &deleted : taskModel->deletedTasks()) {
+            QListWidgetItem *item = new QListWidgetItem(
+                QString("%1 — удалена %2").arg(deleted.task.title(),
+                                               deleted.deletedAt.toString("dd.MM.yyyy HH:mm")), list);
+            item->setData(Qt::UserRole, deleted.task.uid());
+        }
+        restoreButton->setEnabled(list->count() > 0);
+        deleteButton->setEnabled(list->count() > 0);
+        emptyButton->setEnabled(list->count() > 0);
+    };
+    auto selectedUids = [list]() {
+        QVector<QUuid> uids;
+        for (const QListWidgetItem *item : list->selectedItems())
+            uids.append(item->data(Qt::UserRole).toUuid());
+        return uids;
+    };
+    auto restoreSelected = [this, selectedUids, fill]() {
+        const QVector<QUuid> uids = selectedUids();
+        if (uids.isEmpty())
+            return;
+        PerfMonitor::Scope perfScope("restore");
+        TaskUndoStack::Group group(undoStack, "Восстановление из корзины");
+        for (const QUuid &uid : uids)
+            taskModel->restoreTask(uid);
+        refreshAllViews();
+        saveTasks();
+        fill();
+    };
+    connect(list, &QListWidget::itemDoubleClicked, &dialog, restoreSelected);
+    connect(restoreButton, &QPushButton::clicked, &dialog, restoreSelected);
+    connect(deleteButton, &QPushButton::clicked, &dialog, [this, &dialog, selectedUids, fill]() {
+        const QVector<QUuid> uids = selectedUids();
+        if (uids.isEmpty()
+            || QMessageBox::question(&dialog, "Удаление",
+                                     "Удалить выбранные задачи без возможности восстановления?") != QMessageBox::Yes)
+            return;
+        for (const QUuid &uid : uids)
+            taskModel->deletePermanently(uid);
+        saveTasks();
+        fill();
+    });
+    connect(emptyButton, &QPushButton::clicked, &dialog, [this, &dialog, fill]() {
+        if (QMessageBox::question(&dialog, "Очистка корзины",
+                                  "Удалить все задачи из корзины без возможности восстановления?") != QMessageBox::Yes)
+            return;
+        taskModel->purgeTrash(QDateTime::currentDateTime().addSecs(1));
+        saveTasks();
+        fill();
+    });
+
+    fill();
+    dialog.resize(500, 400);
+    dialog.exec();
+}
+
+void MainWindow::showHeatmap() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Загрузка по дням");
+
+    TaskHeatmapView *heatmap = new TaskHeatmapView(taskModel, &dialog);
+    QPushButton *prevButton = new QPushButton("<", &dialog);
+    QPushButton *nextButton = new QPushButton(">", &dialog);
+    QLabel *yearLabel = new QLabel(QString::number(heatmap->year()), &dialog);
+    QComboBox *metricCombo = new QComboBox(&dialog);
+    metricCombo->addItem("Число задач", TaskHeatmapView::TaskCountMetric);
+    metricCombo->addItem("Занятое время", TaskHeatmapView::BookedMinutesMetric);
+
+    QHBoxLayout *navLayout = new QHBoxLayout();
+    navLayout->addWidget(prevButton);
+    navLayout->addWidget(yearLabel);
+    navLayout->addWidget(nextButton);
+    navLayout->addStretch(1);
+    navLayout->addWidget(metricCombo);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addLayout(navLayout);
+    layout->addWidget(heatmap, 1);
+
+    auto stepYear = [heatmap, yearLabel](int delta) {
+        heatmap->setYear(heatmap->year() + delta);
+        yearLabel->setText(QString::number(heatmap->year()));
+    };
+    connect(prevButton, &QPushButton::clicked, heatmap, [stepYear]() { stepYear(-1); });
+    connect(nextButton, &QPushButton::clicked, heatmap, [stepYear]() { stepYear(1); });
+    connect(metricCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), heatmap, [heatmap, metricCombo]() {
+        heatmap->setMetric(static_cast<TaskHeatmapView::Metric>(metricCombo->currentData().toInt()));
+    });
+    // Выбор дня на карте применяет фильтр по дате один раз
+    connect(heatmap, &TaskHeatmapView::dateActivated, &dialog, [this, &dialog](const QDate &date) {
+        dateFilterEdit->setDate(date);
+        dialog.accept();
+    });
+
+    dialog.resize(950, 220);
+    dialog.exec();
+}
+
+void MainWindow::showFreeSlotFinder() {
+    FreeSlotDialog finder(taskModel, this);
+    QDateTime chosenStart;
+    QDateTime chosenEnd;
+    connect(&finder, &FreeSlotDialog::slotChosen, this, [&chosenStart, &chosenEnd](const QDateTime &start, const QDateTime &end) {
+        chosenStart = start;
+        chosenEnd = end;
+    });
+    if (finder.exec() != QDialog::Accepted || !chosenStart.isValid())
+        return;
+
+    TaskDialog dialog(m_dataManager, this, Task("", "Работа", chosenStart, chosenEnd, "В работе", ""), taskModel);
+    if (dialog.exec() == QDialog::Accepted) {
+        PerfMonitor::Scope perfScope("add");
+        taskModel->addTask(dialog.getTask());
+        refreshAllViews();
+        saveTasks();
+    }
+}
+
+void MainWindow::showAutoScheduler() {
+    AutoScheduleDialog dialog(taskModel, this);
+    connect(&dialog, &AutoScheduleDialog::previewChanged, overlay, &TaskScheduleOverlay::setPreviewTasks);
+    connect(&dialog, &AutoScheduleDialog::dayActivated, this, [this](const QDate &date) {
+        dateFilterEdit->setDate(date);
+    });
+    const bool accepted = dialog.exec() == QDialog::Accepted;
+    overlay->setPreviewTasks(QVector<Task>());
+    if (!accepted)
+        return;
+
+    // Всё расписание применяется одной пачкой: одно обновление видов и одно сохранение
+    PerfMonitor::Scope perfScope("edit");
+    TaskUndoStack::Group group(undoStack, "Автопланирование");
+    for (const Task &task : dialog.scheduledTasks()) {
+        int row = taskModel->findTask(task.uid());
+        if (row >= 0)
+            taskModel->updateTask(row, task);
+    }
+    refreshAllViews();
+    saveTasks();
+}
+
+void MainWindow::editOccurrence(const Task &occurrence) {
+    QMessageBox choice(this);
+    choice.setWindowTitle("Повторяющаяся задача");
+    choice.setText(QString("«%1» повторяется. Что изменить?").arg(occurrence.title()));
+    QPushButton *occurrenceButton = choice.addButton("Только это вхождение", QMessageBox::ActionRole);
+    QPushButton *seriesButton = choice.addButton("Всю серию", QMessageBox::ActionRole);
+    QPushButton *skipButton = choice.addButton("Пропустить вхождение", QMessageBox::DestructiveRole);
+    choice.addButton(QMessageBox::Cancel);
+    choice.exec();
+
+    const int row = taskModel->findTask(occurrence.uid());
+    if (row < 0)
+        return;
+    if (choice.clickedButton() == occurrenceButton) {
+        // Изменение вхождения хранится в серии как разреженное исключение
+        TaskDialog dialog(m_dataManager, this, occurrence, taskModel);
+        if (dialog.exec() != QDialog::Accepted)
+            return;
+        taskModel->setOccurrenceOverride(occurrence.uid(), occurrence.occurrenceDate(), dialog.getTask());
+    } else if (choice.clickedButton() == seriesButton) {
+        const Task series = taskModel->getTask(row);
+        TaskDialog dialog(m_dataManager, this, series, taskModel);
+        if (dialog.exec() != QDialog::Accepted || taskModel->applyEdit(series, dialog.getTask()) < 0)
+            return;
+    } else if (choice.clickedButton() == skipButton) {
+        taskModel->skipOccurrence(occurrence.uid(), occurrence.occurrenceDate());
+    } else {
+        return;
+    }
+    PerfMonitor::Scope perfScope("edit");
+    refreshAllViews();
+    saveTasks();
+}
+
 bool MainWindow::showTaskDialog(const Task &task, bool isEditMode) {
     // Проверяем, нет ли уже открытого диалога
     for (QWidget *widget : QApplication::topLevelWidgets()) {
@@ -793,15 +1411,13 @@ bool MainWindow::showTaskDialog(const Task &task, bool isEditMode) {
         }
     }
 
-    TaskDialog dialog(m_dataManager, this, task);
+    TaskDialog dialog(m_dataManager, this, task, taskModel);
     if (dialog.exec() == QDialog::Accepted) {
         Task updatedTask = dialog.getTask();
         if (isEditMode) {
-            QModelIndex index = allTasksView->currentIndex();
-            if (index.isValid()) {
-                QModelIndex sourceIndex = proxyModel->mapToSource(index);
-                taskModel->updateTask(sourceIndex.row(), updatedTask);
-            }
+            // Редактируется переданная задача, а не та, что стала текущей за время диалога;
+            // поля, влитые из файла за это время, не откатываются
+            taskModel->applyEdit(task, updatedTask);
         } else {
             updatedTask.setUid(QUuid::createUuid());
             taskModel->addTask(updatedTask);
@@ -829,6 +1445,68 @@ void MainWindow::exportToCSV() {
     }
 }
 
+void MainWindow::syncTasks()
+{
+    // Файла может ещё не быть: первая синхронизация в новое место просто копирует задачи
+    const QString otherPath = QFileDialog::getSaveFileName(this, "Синхронизация с файлом задач", "tasks.json",
+                                                           "Файлы задач (*.json)", nullptr,
+                                                           QFileDialog::DontConfirmOverwrite);
+    const QString ownPath = TaskModel::tasksFilePath();
+    if (otherPath.isEmpty() || QFileInfo(otherPath) == QFileInfo(ownPath))
+        return;
+
+    PerfMonitor::Scope perfScope("sync");
+    QElapsedTimer timer;
+    timer.start();
+    const QString reportPath = QFileInfo(ownPath).dir().filePath("sync-conflicts.jsonl");
+    TaskSync::Result result;
+    // Файл, изменённый другим окном или машиной во время слияния, — повод слить заново, а не затереть его
+    for (int attempt = 0; attempt < TaskModel::MaxSaveAttempts; ++attempt) {
+        // Сливаются файлы, поэтому сначала на диск — всё, что есть в модели
+        if (!taskModel->saveTasks()) {
+            QMessageBox::warning(this, "Синхронизация", "Не удалось сохранить задачи.");
+            return;
+        }
+        result = TaskSync::merge(ownPath, otherPath, ownPath, reportPath);
+        if (result.stale)
+            continue;
+        if (!result.ok) {
+            QMessageBox::warning(this, "Синхронизация", result.error);
+            return;
+        }
+        taskModel->applyTasksFile(TaskModel::readTasksFile(ownPath));
+
+        QFile merged(ownPath);
+        const LockedSaveFile::Result written = merged.open(QIODevice::ReadOnly)
+            ? LockedSaveFile::write(otherPath, merged.readAll(), [&]() {
+                  return TaskModel::readTasksFileVersion(otherPath) == result.rightVersion;
+              })
+            : LockedSaveFile::Failed;
+        if (written == LockedSaveFile::Stale) {
+            result.stale = true;
+            continue;
+        }
+        if (written == LockedSaveFile::Failed) {
+            QMessageBox::warning(this, "Синхронизация", QString("Не удалось записать %1").arg(otherPath));
+            return;
+        }
+        break;
+    }
+    if (result.stale) {
+        QMessageBox::warning(this, "Синхронизация", "Файлы задач всё время меняются, синхронизация не выполнена.");
+        return;
+    }
+
+    QString text = QString("Задач всего: %1\nЕсть в обоих файлах: %2\nТолько здесь: %3\nТолько там: %4\n"
+                           "Время: %5 мс")
+                       .arg(result.tasks).arg(result.merged).arg(result.onlyLeft).arg(result.onlyRight)
+                       .arg(timer.elapsed());
+    if (result.conflicts > 0)
+        text += QString("\n\nКонфликтов: %1 — победили более поздние правки.\nОтчёт: %2")
+                    .arg(result.conflicts).arg(reportPath);
+    QMessageBox::information(this, "Синхронизация", text);
+}
+
 void MainWindow::performExport(bool exportAll)
 {
     QString fileName = QFileDialog::getSaveFileName(this, "Экспорт в CSV", "tasks.csv", "CSV Files (*.csv)");
@@ -1045,8 +1723,9 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
             if (endTime.hour() > 23) endTime.setHMS(23, 59, 0); // не выходить за пределы суток
             QDateTime startDT(date, startTime);
             QDateTime endDT(date, endTime);
-            TaskDialog dialog(m_dataManager, this, Task("", "Работа", startDT, endDT, "В работе", ""));
+            TaskDialog dialog(m_dataManager, this, Task("", "Работа", startDT, endDT, "В работе", ""), taskModel);
             if (dialog.exec() == QDialog::Accepted) {
+                PerfMonitor::Scope perfScope("add");
                 Task task = dialog.getTask();
                 taskModel->addTask(task);
                 if (overlay) overlay->ignoreNextClick();
@@ -1063,7 +1742,7 @@ void MainWindow::resizeEvent(QResizeEvent *event)
 {
     QMainWindow::resizeEvent(event);
     if (allTasksView) {
-        allTasksView->resizeRowsToContents();
+        resizeVisibleRows();
     }
 }
 
@@ -1075,6 +1754,9 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
 void MainWindow::saveTasks()
 {
+    PerfMonitor::Scope perfScope("saveTasks");
+    // Файл всё равно переписывается целиком — заодно из корзины уходят старые записи
+    taskModel->purgeTrash(QDateTime::currentDateTime().addDays(-TaskModel::TrashRetentionDays));
     if (!taskModel->saveTasks()) {
         QMessageBox::warning(this, "Ошибка сохранения", "Не удалось сохранить задачи.");
     }
@@ -1082,8 +1764,42 @@ void MainWindow::saveTasks()
 
 void MainWindow::loadTasks()
 {
-    if (!taskModel->loadTasks()) {
+    taskModel->loadTasks();
+    switch (taskModel->loadStatus()) {
+    case TaskModel::FileLoaded:
+        break;
+    case TaskModel::FileMissing:
         QMessageBox::information(this, "Загрузка задач", "Файл с задачами не найден. Будет создан новый.");
+        break;
+    case TaskModel::PreviousLoaded:
+        QMessageBox::warning(this, "Загрузка задач",
+                             "Файл с задачами повреждён — загружено предыдущее сохранение.\n"
+                             "Повреждённый файл сохранён как tasks.json.damaged.");
+        saveTasks();
+        break;
+    case TaskModel::PreviousLoadedMissing:
+        QMessageBox::warning(this, "Загрузка задач",
+                             "Файл с задачами не найден — загружено предыдущее сохранение.");
+        saveTasks();
+        break;
+    case TaskModel::FileDamaged: {
+        // Целого поколения файла нет — задачи восстанавливаются по журналу изменений.
+        // Корзины в журнале нет: удалённые задачи остаются только в tasks.json.damaged
+        const QVector<Task> tasks = taskHistory->tasksAsOf(QDateTime::currentDateTime());
+        if (tasks.isEmpty()) {
+            QMessageBox::critical(this, "Загрузка задач",
+                                  "Файл с задачами повреждён, восстановить задачи не удалось.\n"
+                                  "Повреждённый файл сохранён как tasks.json.damaged.");
+            break;
+        }
+        taskModel->setTasks(tasks);
+        QMessageBox::warning(this, "Загрузка задач",
+                             QString("Файл с задачами повреждён — задачи (%1) восстановлены по журналу изменений.\n"
+                                     "Корзина не восстановлена: удалённые задачи остались только в повреждённом "
+                                     "файле, сохранённом как tasks.json.damaged.").arg(tasks.size()));
+        saveTasks();
+        break;
+    }
     }
 }
 
@@ -1091,10 +1807,13 @@ void MainWindow::checkForOverdueTasks()
 {
     QDateTime now = QDateTime::currentDateTime();
     bool changed = false;
+    // Автоматическая пометка просрочки — не действие пользователя, отменять её нечего
+    TaskUndoStack::Pause pause(undoStack);
     for (int i = 0; i < taskModel->rowCount(); ++i) {
         Task task = taskModel->getTask(i);
 
-        if (task.isProjectTask() && task.dueDateTime() < now &&
+        // Серия не просрачивается целиком — её вхождения повторяются дальше
+        if (task.isProjectTask() && !task.isRecurring() && task.dueDateTime() < now &&
             (task.status() == "Не начато" || task.status() == "В процессе")) {
 
             task.setStatus("Просрочено");
@@ -22,6 +22,11 @@ class QTableView;
 class QPushButton;
 class TaskScheduleOverlay;
 class QTimer;
+class StallWatchdog;
+class TaskDelegate;
+class TaskUndoStack;
+class TaskHistory;
+class TaskFileWatcher;
 
 /**
  * @class MainWindow
@@ -141,6 +146,47 @@ private:
      * @brief Обновить все представления.
      */
     void refreshAllViews();
+    /**
+     * @brief Подогнать высоту только видимых строк списка задач.
+     */
+    void resizeVisibleRows();
+    /**
+     * @brief Открыть недельный вид задач по времени.
+     */
+    void showWeekView();
+    /**
+     * @brief Открыть дерево задач и подзадач с прогрессом выполнения.
+     */
+    void showTaskTree();
+    /**
+     * @brief Показать ревизии выбранной задачи (журнал читается только здесь).
+     */
+    void showTaskHistory();
+    /**
+     * @brief Показать список задач в том виде, каким он был в выбранный момент (только чтение).
+     */
+    void showTaskListAsOf();
+    /**
+     * @brief Открыть корзину: восстановление и окончательное удаление задач.
+     */
+    void showTrash();
+    /**
+     * @brief Открыть тепловую карту загрузки по дням года.
+     */
+    void showHeatmap();
+    /**
+     * @brief Найти свободное время и создать в нём задачу.
+     */
+    void showFreeSlotFinder();
+    /**
+     * @brief Разместить задачи без времени в свободных промежутках с предпросмотром в оверлее.
+     */
+    void showAutoScheduler();
+    /**
+     * @brief Изменить или пропустить одно вхождение повторяющейся задачи либо всю серию.
+     * @param occurrence Вхождение (UID совпадает с серией).
+     */
+    void editOccurrence(const Task &occurrence);
     /**
      * @brief Показать диалог задачи.
      * @param task Задача.
@@ -156,6 +202,10 @@ private:
      * @brief Экспортировать задачи в CSV.
      */
     void exportToCSV();
+    /**
+     * @brief Синхронизировать задачи с другим файлом задач (TaskSync); оба файла получают результат.
+     */
+    void syncTasks();
     /**
      * @brief Выполнить экспорт задач.
      * @param exportAll Экспортировать все или только отфильтрованные.
@@ -172,13 +222,18 @@ private:
 
     CustomDataManager *m_dataManager;
     TaskModel *taskModel;
+    TaskUndoStack *undoStack; // отмена и повтор изменений задач
+    TaskHistory *taskHistory; // журнал ревизий задач в history.jsonl
+    TaskFileWatcher *fileWatcher; // подхват изменений tasks.json другими процессами
     TaskFilterProxyModel *proxyModel;
     QTableView *allTasksView;
+    TaskDelegate *taskDelegate;
     QTableWidget *timeSlotsTable;
     QDateEdit *dateFilterEdit;
     QComboBox *taskTypeCombo;
     QLabel *filterTitleLabel;
     QLineEdit *titleFilterEdit;
+    QLineEdit *tagFilterEdit;
     QComboBox *statusFilterCombo;
     QComboBox *priorityFilterCombo;
     QComboBox *deadlineFilterCombo;
@@ -188,6 +243,7 @@ private:
     TaskScheduleOverlay *overlay; // overlay для задач по времени
     bool blockEditOnAdd = false;
     QTimer *m_overdueTaskTimer;
+    StallWatchdog *m_stallWatchdog; // сторожевой поток для поиска зависаний UI
 };
 
 #endif // MAINWINDOW_H
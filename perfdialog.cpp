@@ -0,0 +1,81 @@
+/**
+ * @file perfdialog.cpp
+ * @brief Реализация отладочной панели производительности.
+ */
+#include "perfdialog.h"
+#include "perfmonitor.h"
+#include "tracing.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFontDatabase>
+
+PerfDialog::PerfDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Диагностика производительности");
+    resize(720, 480);
+
+    m_reportEdit = new QPlainTextEdit(this);
+    m_reportEdit->setReadOnly(true);
+    m_reportEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    QPushButton *refreshButton = new QPushButton("Обновить", this);
+    QPushButton *saveButton = new QPushButton("Сохранить в файл...", this);
+    QPushButton *resetButton = new QPushButton("Сбросить", this);
+    QPushButton *traceButton = new QPushButton("Экспорт трассировки...", this);
+    // В релизной сборке интервалы не собираются
+    traceButton->setEnabled(Tracing::isCompiledIn());
+    QPushButton *closeButton = new QPushButton("Закрыть", this);
+    connect(refreshButton, &QPushButton::clicked, this, &PerfDialog::refreshReport);
+    connect(saveButton, &QPushButton::clicked, this, &PerfDialog::saveReport);
+    connect(resetButton, &QPushButton::clicked, this, &PerfDialog::resetStats);
+    connect(traceButton, &QPushButton::clicked, this, &PerfDialog::exportTrace);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(refreshButton);
+    buttonLayout->addWidget(saveButton);
+    buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(traceButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(m_reportEdit);
+    mainLayout->addLayout(buttonLayout);
+
+    refreshReport();
+}
+
+void PerfDialog::refreshReport()
+{
+    m_reportEdit->setPlainText(PerfMonitor::instance()->report());
+}
+
+void PerfDialog::saveReport()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить отчёт", "taskm_perf.txt", "Text Files (*.txt)");
+    if (fileName.isEmpty()) return;
+    if (!PerfMonitor::instance()->dumpToFile(fileName)) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить отчёт.");
+    }
+}
+
+void PerfDialog::resetStats()
+{
+    PerfMonitor::instance()->reset();
+    refreshReport();
+}
+
+void PerfDialog::exportTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт трассировки", "taskm_trace.json", "JSON Files (*.json)");
+    if (fileName.isEmpty()) return;
+    if (!Tracing::exportChromeTrace(fileName)) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить трассировку.");
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * @file perfdialog.h
+ * @brief Отладочная панель с задержками операций и журналом зависаний.
+ */
+
+#ifndef PERFDIALOG_H
+#define PERFDIALOG_H
+
+#include <QDialog>
+
+class QPlainTextEdit;
+
+/**
+ * @class PerfDialog
+ * @brief Показывает отчёт PerfMonitor и позволяет сохранить его в файл.
+ */
+class PerfDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit PerfDialog(QWidget *parent = nullptr);
+
+private slots:
+    /**
+     * @brief Перечитать отчёт из PerfMonitor.
+     */
+    void refreshReport();
+    /**
+     * @brief Сохранить отчёт в выбранный файл.
+     */
+    void saveReport();
+    /**
+     * @brief Сбросить собранную статистику.
+     */
+    void resetStats();
+    /**
+     * @brief Сохранить трассировку в формате Chrome Trace.
+     */
+    void exportTrace();
+
+private:
+    QPlainTextEdit *m_reportEdit;
+};
+
+#endif // PERFDIALOG_H
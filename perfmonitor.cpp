@@ -0,0 +1,153 @@
+/**
+ * @file perfmonitor.cpp
+ * @brief Реализация гистограмм задержек и журнала зависаний UI.
+ */
+#include "perfmonitor.h"
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+
+int LatencyHistogram::bucketFor(qint64 micros)
+{
+    if (micros < kSubBuckets)
+        return static_cast<int>(std::max<qint64>(0, micros));
+    // Старший бит задаёт октаву, следующие два бита — корзину внутри октавы
+    int msb = 63 - static_cast<int>(qCountLeadingZeroBits(static_cast<quint64>(micros)));
+    int sub = static_cast<int>((micros >> (msb - 2)) & (kSubBuckets - 1));
+    int bucket = (msb - 1) * kSubBuckets + sub;
+    return std::min(bucket, kBucketCount - 1);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket)
+{
+    if (bucket < kSubBuckets)
+        return bucket;
+    int msb = bucket / kSubBuckets + 1;
+    int sub = bucket % kSubBuckets;
+    return ((static_cast<qint64>(kSubBuckets + sub + 1)) << (msb - 2)) - 1;
+}
+
+void LatencyHistogram::record(qint64 micros)
+{
+    ++m_buckets[bucketFor(micros)];
+    ++m_count;
+    m_max = std::max(m_max, micros);
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0)
+        return 0;
+    qint64 rank = static_cast<qint64>(std::ceil(p * m_count));
+    rank = std::clamp<qint64>(rank, 1, m_count);
+    qint64 seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank)
+            return std::min(bucketUpperBound(i), m_max);
+    }
+    return m_max;
+}
+
+void LatencyHistogram::reset()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+PerfMonitor::Scope::Scope(const char *name)
+    : m_name(name)
+{
+    PerfMonitor *monitor = PerfMonitor::instance();
+    const char *expected = nullptr;
+    m_isTopLevel = monitor->m_topLevel.compare_exchange_strong(expected, name, std::memory_order_acq_rel);
+    m_previousPhase = monitor->m_phase.exchange(name, std::memory_order_acq_rel);
+    m_timer.start();
+}
+
+PerfMonitor::Scope::~Scope()
+{
+    PerfMonitor *monitor = PerfMonitor::instance();
+    monitor->recordLatency(m_name, m_timer.nsecsElapsed() / 1000);
+    monitor->m_phase.store(m_previousPhase, std::memory_order_release);
+    if (m_isTopLevel)
+        monitor->m_topLevel.store(nullptr, std::memory_order_release);
+}
+
+PerfMonitor *PerfMonitor::instance()
+{
+    static PerfMonitor monitor;
+    return &monitor;
+}
+
+void PerfMonitor::recordLatency(const char *name, qint64 micros)
+{
+    QMutexLocker locker(&m_mutex);
+    m_histograms[QString::fromLatin1(name)].record(micros);
+}
+
+void PerfMonitor::recordStall(const StallRecord &record)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stalls.size() >= kMaxStalls)
+        m_stalls.removeFirst();
+    m_stalls.append(record);
+}
+
+QVector<PerfMonitor::StallRecord> PerfMonitor::stalls() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stalls;
+}
+
+QString PerfMonitor::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString text;
+    QTextStream out(&text);
+
+    out << "Задержки операций (мс): count / p50 / p95 / p99 / max\n";
+    for (auto it = m_histograms.constBegin(); it != m_histograms.constEnd(); ++it) {
+        const LatencyHistogram &h = it.value();
+        out << QString("  %1: %2 / %3 / %4 / %5 / %6\n")
+                   .arg(it.key(), -24)
+                   .arg(h.count())
+                   .arg(h.percentile(0.50) / 1000.0, 0, 'f', 2)
+                   .arg(h.percentile(0.95) / 1000.0, 0, 'f', 2)
+                   .arg(h.percentile(0.99) / 1000.0, 0, 'f', 2)
+                   .arg(h.maxValue() / 1000.0, 0, 'f', 2);
+    }
+
+    out << "\nЗависания цикла событий: " << m_stalls.size() << "\n";
+    for (const StallRecord &stall : m_stalls) {
+        out << QString("  %1  %2 мс  операция: %3  фаза: %4\n")
+                   .arg(stall.when.toString("dd.MM.yyyy HH:mm:ss.zzz"))
+                   .arg(stall.durationMs)
+                   .arg(stall.operation.isEmpty() ? "-" : stall.operation)
+                   .arg(stall.phase.isEmpty() ? "-" : stall.phase);
+    }
+    return text;
+}
+
+bool PerfMonitor::dumpToFile(const QString &filePath) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning("Couldn't open performance report file.");
+        return false;
+    }
+    file.write(report().toUtf8());
+    file.close();
+    return true;
+}
+
+void PerfMonitor::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_histograms.clear();
+    m_stalls.clear();
+}
@@ -0,0 +1,164 @@
+/**
+ * @file perfmonitor.h
+ * @brief Замеры задержек пользовательских операций и журнал зависаний UI.
+ */
+
+#ifndef PERFMONITOR_H
+#define PERFMONITOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QVector>
+#include <array>
+#include <atomic>
+
+/**
+ * @class LatencyHistogram
+ * @brief Гистограмма задержек с логарифмическими корзинами (4 корзины на октаву).
+ *
+ * Хранит только счётчики, поэтому запись стоит O(1) и не выделяет память.
+ * Точность перцентилей — около 25% от значения, чего достаточно для p50/p95/p99.
+ */
+class LatencyHistogram
+{
+public:
+    /**
+     * @brief Добавить замер.
+     * @param micros Длительность в микросекундах.
+     */
+    void record(qint64 micros);
+    /**
+     * @brief Оценка перцентиля.
+     * @param p Доля от 0 до 1 (например, 0.95).
+     * @return Верхняя граница корзины в микросекундах.
+     */
+    qint64 percentile(double p) const;
+    /**
+     * @brief Количество замеров.
+     */
+    qint64 count() const { return m_count; }
+    /**
+     * @brief Максимальный замер в микросекундах.
+     */
+    qint64 maxValue() const { return m_max; }
+    /**
+     * @brief Сбросить гистограмму.
+     */
+    void reset();
+
+private:
+    static constexpr int kSubBuckets = 4;
+    static constexpr int kBucketCount = 128;
+    static int bucketFor(qint64 micros);
+    static qint64 bucketUpperBound(int bucket);
+
+    std::array<quint32, kBucketCount> m_buckets{};
+    qint64 m_count = 0;
+    qint64 m_max = 0;
+};
+
+/**
+ * @class PerfMonitor
+ * @brief Сборщик задержек по операциям и записей о зависаниях цикла событий.
+ *
+ * Операции размечаются через PerfMonitor::Scope в потоке GUI. Имя внешней
+ * (пользовательской) и самой вложенной операции доступно из других потоков,
+ * чтобы сторожевой поток мог указать, что выполнялось во время зависания.
+ */
+class PerfMonitor
+{
+public:
+    /**
+     * @struct StallRecord
+     * @brief Запись о зависании цикла событий.
+     */
+    struct StallRecord {
+        QDateTime when;
+        QString operation;
+        QString phase;
+        qint64 durationMs = 0;
+    };
+
+    /**
+     * @class Scope
+     * @brief RAII-замер операции: время попадает в гистограмму при выходе из области.
+     *
+     * Имя должно быть строковым литералом — указатель хранится без копирования.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char *m_name;
+        const char *m_previousPhase;
+        bool m_isTopLevel;
+        QElapsedTimer m_timer;
+    };
+
+    /**
+     * @brief Глобальный экземпляр.
+     */
+    static PerfMonitor *instance();
+
+    /**
+     * @brief Записать длительность операции.
+     * @param name Имя операции.
+     * @param micros Длительность в микросекундах.
+     */
+    void recordLatency(const char *name, qint64 micros);
+    /**
+     * @brief Записать зависание (вызывается из сторожевого потока).
+     * @param record Запись о зависании.
+     */
+    void recordStall(const StallRecord &record);
+
+    /**
+     * @brief Внешняя операция, активная в потоке GUI (или nullptr).
+     */
+    const char *currentOperation() const { return m_topLevel.load(std::memory_order_acquire); }
+    /**
+     * @brief Самая вложенная активная операция (или nullptr).
+     */
+    const char *currentPhase() const { return m_phase.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Список зафиксированных зависаний.
+     */
+    QVector<StallRecord> stalls() const;
+    /**
+     * @brief Текстовый отчёт: перцентили по операциям и список зависаний.
+     */
+    QString report() const;
+    /**
+     * @brief Сохранить отчёт в файл.
+     * @param filePath Путь к файлу.
+     * @return true если успешно.
+     */
+    bool dumpToFile(const QString &filePath) const;
+    /**
+     * @brief Сбросить все гистограммы и журнал зависаний.
+     */
+    void reset();
+
+private:
+    PerfMonitor() = default;
+
+    static constexpr int kMaxStalls = 200;
+
+    mutable QMutex m_mutex;
+    QMap<QString, LatencyHistogram> m_histograms;
+    QVector<StallRecord> m_stalls;
+    std::atomic<const char *> m_topLevel{nullptr};
+    std::atomic<const char *> m_phase{nullptr};
+};
+
+#endif // PERFMONITOR_H
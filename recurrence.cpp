@@ -0,0 +1,222 @@
+/**
+ * @file recurrence.cpp
+ * @brief Реализация правила повторения и разворачивания вхождений.
+ */
+#include "recurrence.h"
+#include "task.h"
+#include <QJsonArray>
+#include <QStringList>
+
+static int monthsBetween(const QDate &from, const QDate &to)
+{
+    return (to.year() - from.year()) * 12 + to.month() - from.month();
+}
+
+QString Recurrence::toRRule() const
+{
+    static const char *const names[] = {"", "DAILY", "WEEKLY", "MONTHLY"};
+    if (!isRecurring())
+        return QString();
+    QString rule = QString("FREQ=%1;INTERVAL=%2").arg(names[m_frequency]).arg(m_interval);
+    if (m_until.isValid())
+        rule += ";UNTIL=" + m_until.toString("yyyyMMdd");
+    if (m_count > 0)
+        rule += QString(";COUNT=%1").arg(m_count);
+    return rule;
+}
+
+Recurrence Recurrence::fromRRule(const QString &rrule)
+{
+    Recurrence recurrence;
+    const QStringList parts = rrule.split(';', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        const QString key = part.section('=', 0, 0).trimmed().toUpper();
+        const QString value = part.section('=', 1).trimmed();
+        if (key == "FREQ") {
+            if (value == "DAILY")
+                recurrence.setFrequency(Daily);
+            else if (value == "WEEKLY")
+                recurrence.setFrequency(Weekly);
+            else if (value == "MONTHLY")
+                recurrence.setFrequency(Monthly);
+        } else if (key == "INTERVAL") {
+            recurrence.setInterval(value.toInt());
+        } else if (key == "UNTIL") {
+            recurrence.setUntil(QDate::fromString(value.left(8), "yyyyMMdd"));
+        } else if (key == "COUNT") {
+            recurrence.setCount(value.toInt());
+        }
+    }
+    return recurrence;
+}
+
+QJsonObject Recurrence::toJson() const
+{
+    QJsonObject object;
+    object["rrule"] = toRRule();
+    if (!m_exceptions.isEmpty()) {
+        QList<QDate> dates(m_exceptions.begin(), m_exceptions.end());
+        std::sort(dates.begin(), dates.end());
+        QJsonArray exdates;
+        for (const QDate &date : std::as_const(dates))
+            exdates.append(date.toString(Qt::ISODate));
+        object["exdates"] = exdates;
+    }
+    if (!m_overrides.isEmpty()) {
+        QJsonObject overrides;
+        for (auto it = m_overrides.constBegin(); it != m_overrides.constEnd(); ++it) {
+            // Сохраняются только изменённые поля
+            QJsonObject change;
+            if (it.value().start.isValid())
+                change["start"] = it.value().start.toString(Qt::ISODate);
+            if (it.value().end.isValid())
+                change["end"] = it.value().end.toString(Qt::ISODate);
+            if (!it.value().title.isEmpty())
+                change["title"] = it.value().title;
+            if (!it.value().status.isEmpty())
+                change["status"] = it.value().status;
+            if (!it.value().description.isEmpty())
+                change["description"] = it.value().description;
+            overrides[it.key().toString(Qt::ISODate)] = change;
+        }
+        object["overrides"] = overrides;
+    }
+    return object;
+}
+
+Recurrence Recurrence::fromJson(const QJsonObject &object)
+{
+    Recurrence recurrence = fromRRule(object["rrule"].toString());
+    for (const QJsonValue &value : object["exdates"].toArray())
+        recurrence.m_exceptions.insert(QDate::fromString(value.toString(), Qt::ISODate));
+    const QJsonObject overrides = object["overrides"].toObject();
+    for (auto it = overrides.constBegin(); it != overrides.constEnd(); ++it) {
+        const QJsonObject change = it.value().toObject();
+        OccurrenceOverride occurrence;
+        occurrence.start = QDateTime::fromString(change["start"].toString(), Qt::ISODate);
+        occurrence.end = QDateTime::fromString(change["end"].toString(), Qt::ISODate);
+        occurrence.title = change["title"].toString();
+        occurrence.status = change["status"].toString();
+        occurrence.description = change["description"].toString();
+        recurrence.m_overrides.insert(QDate::fromString(it.key(), Qt::ISODate), occurrence);
+    }
+    return recurrence;
+}
+
+QDate Recurrence::nthMonthly(const QDate &seriesStart, int monthIndex) const
+{
+    // Месяцы без такого числа (31-е, 29 февраля) пропускаются, как в RRULE
+    const int total = seriesStart.month() - 1 + monthIndex * m_interval;
+    return QDate(seriesStart.year() + total / 12, total % 12 + 1, seriesStart.day());
+}
+
+QVector<QDate> Recurrence::occurrenceDates(const QDate &seriesStart, const QDate &from, const QDate &to) const
+{
+    QVector<QDate> result;
+    if (!isRecurring() || !seriesStart.isValid() || !from.isValid() || !to.isValid())
+        return result;
+    const QDate first = std::max(from, seriesStart);
+    const QDate last = m_until.isValid() ? std::min(to, m_until) : to;
+    if (first > last)
+        return result;
+
+    if (m_frequency == Daily || m_frequency == Weekly) {
+        const qint64 step = static_cast<qint64>(m_interval) * (m_frequency == Weekly ? 7 : 1);
+        qint64 k = (seriesStart.daysTo(first) + step - 1) / step;
+        qint64 lastK = seriesStart.daysTo(last) / step;
+        if (m_count > 0)
+            lastK = std::min<qint64>(lastK, m_count - 1);
+        for (; k <= lastK; ++k) {
+            const QDate date = seriesStart.addDays(k * step);
+            if (!m_exceptions.contains(date))
+                result.append(date);
+        }
+        return result;
+    }
+
+    // Ежемесячно: при COUNT считаем вхождения с начала серии, иначе сразу прыгаем к окну
+    const int lastMonth = monthsBetween(seriesStart, last) / m_interval;
+    int n = m_count > 0 ? 0 : monthsBetween(seriesStart, first) / m_interval;
+    int counted = 0;
+    for (; n <= lastMonth; ++n) {
+        const QDate date = nthMonthly(seriesStart, n);
+        if (!date.isValid())
+            continue;
+        if (m_count > 0 && ++counted > m_count)
+            break;
+        if (date < first)
+            continue;
+        if (date > last)
+            break;
+        if (!m_exceptions.contains(date))
+            result.append(date);
+    }
+    return result;
+}
+
+QVector<Task> Recurrence::expand(const Task &series, const QDate &from, const QDate &to)
+{
+    QVector<Task> result;
+    const Recurrence &rule = series.recurrence();
+    const bool timed = series.isProjectTask();
+    const QDateTime start = timed ? series.startDateTime() : series.dueDateTime();
+
+    auto inWindow = [&from, &to, timed](const Task &task) {
+        if (timed)
+            return task.startDateTime().date() <= to && task.endDateTime().date() >= from;
+        return task.dueDateTime().date() >= from && task.dueDateTime().date() <= to;
+    };
+
+    if (!rule.isRecurring() || !start.isValid()) {
+        if (inWindow(series))
+            result.append(series);
+        return result;
+    }
+
+    // Многодневное вхождение может начаться до окна и заходить в него
+    const int spanDays = timed ? static_cast<int>(series.startDateTime().date().daysTo(series.endDateTime().date())) : 0;
+    QVector<QDate> dates = rule.occurrenceDates(start.date(), from.addDays(-spanDays), to);
+
+    // Вхождения, перенесённые в окно из-за его пределов
+    for (auto it = rule.m_overrides.constBegin(); it != rule.m_overrides.constEnd(); ++it) {
+        const QDate movedTo = it.value().start.date();
+        if (!it.value().start.isValid() || movedTo < from.addDays(-spanDays) || movedTo > to
+            || dates.contains(it.key()) || rule.occurrenceDates(start.date(), it.key(), it.key()).isEmpty()) {
+            continue;
+        }
+        dates.append(it.key());
+    }
+
+    result.reserve(dates.size());
+    for (const QDate &date : std::as_const(dates)) {
+        Task occurrence = series;
+        occurrence.setRecurrence(Recurrence());
+        occurrence.setOccurrenceDate(date);
+        // Сдвиг по календарным дням сохраняет местное время при переходе на летнее время
+        const qint64 days = start.date().daysTo(date);
+        occurrence.setStartDateTime(series.startDateTime().addDays(days));
+        occurrence.setEndDateTime(series.endDateTime().addDays(days));
+        // Срок задачи без времени тоже переезжает на день вхождения: по нему её ищут фильтр и виды
+        occurrence.setDueDateTime(series.dueDateTime().addDays(days));
+
+        const auto change = rule.m_overrides.constFind(date);
+        if (change != rule.m_overrides.constEnd()) {
+            if (change->start.isValid())
+                occurrence.setStartDateTime(change->start);
+            if (change->end.isValid())
+                occurrence.setEndDateTime(change->end);
+            if (!change->title.isEmpty())
+                occurrence.setTitle(change->title);
+            if (!change->status.isEmpty())
+                occurrence.setStatus(change->status);
+            if (!change->description.isEmpty())
+                occurrence.setDescription(change->description);
+        }
+        if (inWindow(occurrence))
+            result.append(occurrence);
+    }
+    std::sort(result.begin(), result.end(), [](const Task &a, const Task &b) {
+        return a.startDateTime() < b.startDateTime();
+    });
+    return result;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file recurrence.h
+ * @brief Правило повторения задачи (в духе RRULE) и разворачивание вхождений.
+ */
+
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+
+class Task;
+
+/**
+ * @struct OccurrenceOverride
+ * @brief Изменения одного вхождения серии; пустые поля берутся из серии.
+ */
+struct OccurrenceOverride {
+    QDateTime start;
+    QDateTime end;
+    QString title;
+    QString status;
+    QString description;
+};
+
+/**
+ * @class Recurrence
+ * @brief Повторение серии: частота, интервал, окончание (UNTIL/COUNT), исключения.
+ *
+ * Серия хранится одной задачей. Вхождения не хранятся: они вычисляются
+ * только для запрошенного окна дат, а удалённые и изменённые вхождения
+ * хранятся разреженно — множеством дат-исключений и картой изменений.
+ */
+class Recurrence {
+public:
+    enum Frequency { NoRepeat, Daily, Weekly, Monthly };
+
+    Frequency frequency() const { return m_frequency; }
+    void setFrequency(Frequency frequency) { m_frequency = frequency; }
+
+    int interval() const { return m_interval; }
+    void setInterval(int interval) { m_interval = std::max(1, interval); }
+
+    /**
+     * @brief Последний допустимый день (включительно); невалидная дата — без ограничения.
+     */
+    QDate until() const { return m_until; }
+    void setUntil(const QDate &until) { m_until = until; }
+
+    /**
+     * @brief Число вхождений (включая исключённые); 0 — без ограничения.
+     */
+    int count() const { return m_count; }
+    void setCount(int count) { m_count = std::max(0, count); }
+
+    bool isRecurring() const { return m_frequency != NoRepeat; }
+
+    const QSet<QDate> &exceptions() const { return m_exceptions; }
+    void addException(const QDate &date) { m_exceptions.insert(date); m_overrides.remove(date); }
+
+    const QMap<QDate, OccurrenceOverride> &overrides() const { return m_overrides; }
+    void setOverride(const QDate &date, const OccurrenceOverride &change) { m_overrides.insert(date, change); }
+    void removeOverride(const QDate &date) { m_overrides.remove(date); }
+
+    /**
+     * @brief Правило в виде строки RRULE, например "FREQ=WEEKLY;INTERVAL=2;COUNT=10".
+     */
+    QString toRRule() const;
+    /**
+     * @brief Разбор строки RRULE (поддерживаются FREQ, INTERVAL, UNTIL, COUNT).
+     */
+    static Recurrence fromRRule(const QString &rrule);
+
+    QJsonObject toJson() const;
+    static Recurrence fromJson(const QJsonObject &object);
+
+    /**
+     * @brief Даты вхождений в [from, to] без исключённых, по возрастанию.
+     *
+     * Для ежедневного и еженедельного повторения первое вхождение окна
+     * вычисляется арифметически, так что стоимость пропорциональна окну,
+     * а не возрасту серии.
+     * @param seriesStart Дата первого вхождения.
+     */
+    QVector<QDate> occurrenceDates(const QDate &seriesStart, const QDate &from, const QDate &to) const;
+
+    /**
+     * @brief Вхождения серии, попадающие в окно дат [from, to], с применёнными изменениями.
+     *
+     * У вхождения тот же UID, что у серии, заполнена Task::occurrenceDate,
+     * а правило повторения сброшено. Задача без повторения возвращается
+     * как есть, если попадает в окно.
+     */
+    static QVector<Task> expand(const Task &series, const QDate &from, const QDate &to);
+
+private:
+    Frequency m_frequency = NoRepeat;
+    int m_interval = 1;
+    QDate m_until;
+    int m_count = 0;
+    QSet<QDate> m_exceptions;
+    QMap<QDate, OccurrenceOverride> m_overrides;
+
+    QDate nthMonthly(const QDate &seriesStart, int monthIndex) const;
+};
+
+#endif // RECURRENCE_H
@@ -0,0 +1,102 @@
+/**
+ * @file rowbitmap.cpp
+ * @brief Реализация битовой карты строк.
+ */
+#include "rowbitmap.h"
+#include <algorithm>
+#include <QtAlgorithms>
+
+static constexpr int kWordBits = 64;
+
+RowBitmap RowBitmap::filled(int size)
+{
+    RowBitmap bitmap;
+    if (size <= 0)
+        return bitmap;
+    bitmap.m_words.fill(~quint64(0), (size + kWordBits - 1) / kWordBits);
+    const int tail = size % kWordBits;
+    if (tail)
+        bitmap.m_words.last() = (quint64(1) << tail) - 1;
+    return bitmap;
+}
+
+bool RowBitmap::testBit(int row) const
+{
+    const int word = row / kWordBits;
+    return row >= 0 && word < m_words.size() && (m_words[word] >> (row % kWordBits)) & 1;
+}
+
+void RowBitmap::setBit(int row, bool value)
+{
+    if (row < 0)
+        return;
+    const int word = row / kWordBits;
+    if (word >= m_words.size()) {
+        if (!value)
+            return;
+        m_words.resize(word + 1);
+    }
+    const quint64 mask = quint64(1) << (row % kWordBits);
+    if (value)
+        m_words[word] |= mask;
+    else
+        m_words[word] &= ~mask;
+}
+
+void RowBitmap::removeRow(int row)
+{
+    const int first = row / kWordBits;
+    if (row < 0 || first >= m_words.size())
+        return;
+    // В первом слове сдвигаются только биты выше row, младшие остаются на месте
+    const int bit = row % kWordBits;
+    const quint64 low = bit ? m_words[first] & ((quint64(1) << bit) - 1) : 0;
+    const quint64 high = bit == kWordBits - 1 ? 0 : (m_words[first] >> (bit + 1)) << bit;
+    m_words[first] = low | high;
+    for (int word = first; word < m_words.size(); ++word) {
+        if (word > first)
+            m_words[word] >>= 1;
+        if (word + 1 < m_words.size())
+            m_words[word] |= (m_words[word + 1] & 1) << (kWordBits - 1);
+    }
+    while (!m_words.isEmpty() && m_words.last() == 0)
+        m_words.removeLast();
+}
+
+bool RowBitmap::any() const
+{
+    return std::any_of(m_words.cbegin(), m_words.cend(), [](quint64 word) { return word != 0; });
+}
+
+int RowBitmap::count() const
+{
+    int result = 0;
+    for (quint64 word : m_words)
+        result += qPopulationCount(word);
+    return result;
+}
+
+RowBitmap &RowBitmap::operator&=(const RowBitmap &other)
+{
+    m_words.resize(std::min(m_words.size(), other.m_words.size()));
+    for (int word = 0; word < m_words.size(); ++word)
+        m_words[word] &= other.m_words[word];
+    return *this;
+}
+
+RowBitmap &RowBitmap::operator|=(const RowBitmap &other)
+{
+    if (other.m_words.size() > m_words.size())
+        m_words.resize(other.m_words.size());
+    for (int word = 0; word < other.m_words.size(); ++word)
+        m_words[word] |= other.m_words[word];
+    return *this;
+}
+
+RowBitmap &RowBitmap::subtract(const RowBitmap &other)
+{
+    const int common = std::min(m_words.size(), other.m_words.size());
+    for (int word = 0; word < common; ++word)
+        m_words[word] &= ~other.m_words[word];
+    return *this;
+}
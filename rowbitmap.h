@@ -0,0 +1,58 @@
+/**
+ * @file rowbitmap.h
+ * @brief Битовая карта строк модели для быстрых операций над множествами задач.
+ */
+
+#ifndef ROWBITMAP_H
+#define ROWBITMAP_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @class RowBitmap
+ * @brief Множество номеров строк, по биту на строку в 64-битных словах.
+ *
+ * Биты за последним словом считаются нулевыми, поэтому карта редкого тега
+ * занимает место только до его последней строки. Пересечение, объединение
+ * и разность выполняются по словам — по 64 строки за операцию, без обращения
+ * к самим задачам. Удаление строки сдвигает хвост на один бит, как
+ * сдвигаются номера строк в TaskModel.
+ */
+class RowBitmap
+{
+public:
+    /**
+     * @brief Карта со всеми строками [0, size).
+     */
+    static RowBitmap filled(int size);
+
+    bool testBit(int row) const;
+    void setBit(int row, bool value = true);
+    /**
+     * @brief Удалить строку row: биты после неё сдвигаются на одну позицию вниз.
+     */
+    void removeRow(int row);
+    void clear() { m_words.clear(); }
+
+    /**
+     * @brief Есть ли хотя бы одна строка.
+     */
+    bool any() const;
+    /**
+     * @brief Число строк в множестве.
+     */
+    int count() const;
+
+    RowBitmap &operator&=(const RowBitmap &other);
+    RowBitmap &operator|=(const RowBitmap &other);
+    /**
+     * @brief Убрать строки, которые есть в other.
+     */
+    RowBitmap &subtract(const RowBitmap &other);
+
+private:
+    QVector<quint64> m_words;
+};
+
+#endif // ROWBITMAP_H
@@ -0,0 +1,156 @@
+/**
+ * @file schedulelayout.cpp
+ * @brief Реализация раскладки задач дня по колонкам.
+ */
+#include "schedulelayout.h"
+#include "tracing.h"
+#include <algorithm>
+#include <numeric>
+
+namespace ScheduleLayout {
+
+static bool hasValidInterval(const Task &task)
+{
+    return task.isProjectTask()
+           && task.startDateTime().isValid() && task.endDateTime().isValid()
+           && task.startDateTime() < task.endDateTime();
+}
+
+bool clipToDay(const Task &task, const QDate &day, Task *clipped)
+{
+    if (!day.isValid() || !hasValidInterval(task))
+        return false;
+
+    QDate startDate = task.startDateTime().date();
+    QDate endDate = task.endDateTime().date();
+    if (!(startDate <= day && day <= endDate))
+        return false;
+
+    // Корректировка времени для выбранной даты
+    *clipped = task;
+    if (startDate != day)
+        clipped->setStartDateTime(QDateTime(day, QTime(0, 0)));
+    if (endDate != day)
+        clipped->setEndDateTime(QDateTime(day, QTime(23, 59)));
+    return true;
+}
+
+QVector<Task> tasksForDay(const QVector<Task> &tasks, const QDate &day)
+{
+    QVector<Task> result;
+    Task clipped;
+    for (const Task &task : tasks) {
+        if (task.isRecurring()) {
+            // Серия разворачивается только на этот день
+            for (const Task &occurrence : Recurrence::expand(task, day, day)) {
+                if (clipToDay(occurrence, day, &clipped))
+                    result.append(clipped);
+            }
+            continue;
+        }
+        if (clipToDay(task, day, &clipped))
+            result.append(clipped);
+    }
+    return result;
+}
+
+QHash<QDate, QVector<Task>> tasksByDay(const QVector<Task> &tasks, const QDate &first, const QDate &last)
+{
+    QHash<QDate, QVector<Task>> result;
+    if (!first.isValid() || !last.isValid() || last < first)
+        return result;
+
+    Task clipped;
+    auto distribute = [&](const Task &task) {
+        if (!hasValidInterval(task))
+            return;
+        QDate from = std::max(first, task.startDateTime().date());
+        QDate to = std::min(last, task.endDateTime().date());
+        for (QDate day = from; day <= to; day = day.addDays(1)) {
+            if (clipToDay(task, day, &clipped))
+                result[day].append(clipped);
+        }
+    };
+    for (const Task &task : tasks) {
+        if (task.isRecurring()) {
+            // Вхождения серии создаются только для дней диапазона
+            for (const Task &occurrence : Recurrence::expand(task, first, last))
+                distribute(occurrence);
+        } else {
+            distribute(task);
+        }
+    }
+    return result;
+}
+
+QVector<ScheduleBlock> layoutDay(const QVector<Task> &dayTasks)
+{
+    TRACE_SCOPE("ScheduleLayout::layoutDay");
+
+    // 1. Сортируем задачи по времени начала
+    QVector<int> taskIndices(dayTasks.size());
+    std::iota(taskIndices.begin(), taskIndices.end(), 0);
+    std::sort(taskIndices.begin(), taskIndices.end(), [&](int a, int b) {
+        if (dayTasks[a].startDateTime() != dayTasks[b].startDateTime()) {
+            return dayTasks[a].startDateTime() < dayTasks[b].startDateTime();
+        }
+        return dayTasks[a].endDateTime() < dayTasks[b].endDateTime();
+    });
+
+    // 2. Распределяем задачи по колонкам
+    QVector<int> taskColumns(dayTasks.size(), -1);
+    QVector<QDateTime> columnEndTimes; // Хранит время окончания последней задачи в колонке
+
+    for (int i : taskIndices) {
+        if (!hasValidInterval(dayTasks[i]))
+            continue;
+
+        QDateTime currentTaskStart = dayTasks[i].startDateTime();
+        int freeCol = -1;
+
+        // Ищем первую свободную колонку
+        for (int col = 0; col < columnEndTimes.size(); ++col) {
+            if (currentTaskStart >= columnEndTimes[col]) {
+                freeCol = col;
+                break;
+            }
+        }
+
+        if (freeCol == -1) {
+            // Если свободной колонки нет, создаем новую
+            freeCol = columnEndTimes.size();
+            columnEndTimes.append(QDateTime());
+        }
+
+        taskColumns[i] = freeCol;
+        columnEndTimes[freeCol] = dayTasks[i].endDateTime();
+    }
+
+    const int columnsCount = columnEndTimes.size();
+
+    // 3. Переводим время в минуты от начала дня
+    QVector<ScheduleBlock> blocks;
+    blocks.reserve(dayTasks.size());
+    for (int i = 0; i < dayTasks.size(); ++i) {
+        if (taskColumns[i] == -1)
+            continue;
+
+        const Task &task = dayTasks[i];
+        int s = task.startDateTime().time().hour() * 60 + task.startDateTime().time().minute();
+        int e = task.endDateTime().time().hour() * 60 + task.endDateTime().time().minute();
+        s = std::max(0, s);
+        e = std::min(kMinutesPerDay, e);
+        if (e <= s) e = s + 1;
+
+        ScheduleBlock block;
+        block.task = task;
+        block.startMinute = s;
+        block.endMinute = e;
+        block.column = taskColumns[i];
+        block.columnsCount = columnsCount;
+        blocks.append(block);
+    }
+    return blocks;
+}
+
+} // namespace ScheduleLayout
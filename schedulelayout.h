@@ -0,0 +1,73 @@
+/**
+ * @file schedulelayout.h
+ * @brief Раскладка задач по времени внутри одного дня (общая для оверлея и недельного вида).
+ */
+
+#ifndef SCHEDULELAYOUT_H
+#define SCHEDULELAYOUT_H
+
+#include <QDate>
+#include <QHash>
+#include <QVector>
+#include "task.h"
+
+/**
+ * @struct ScheduleBlock
+ * @brief Задача, разложенная по колонкам дня, в минутах от полуночи.
+ */
+struct ScheduleBlock {
+    Task task;            ///< Задача со временем, обрезанным по границам дня
+    int startMinute = 0;  ///< Начало, 0..1439
+    int endMinute = 0;    ///< Конец, 1..1440, всегда больше начала
+    int column = 0;       ///< Колонка, в которую попала задача
+    int columnsCount = 0; ///< Число колонок в раскладке дня
+};
+
+/**
+ * @brief Функции раскладки не зависят от виджетов и не имеют состояния,
+ * поэтому их можно вызывать из рабочих потоков.
+ */
+namespace ScheduleLayout {
+
+constexpr int kMinutesPerDay = 24 * 60;
+
+/**
+ * @brief Обрезает проектную задачу по границам дня.
+ * @param task Задача.
+ * @param day День.
+ * @param clipped Результат (задача с началом/концом внутри дня).
+ * @return false, если задача не проектная, без времени или не пересекает день.
+ */
+bool clipToDay(const Task &task, const QDate &day, Task *clipped);
+
+/**
+ * @brief Отбирает задачи выбранного дня и обрезает их по его границам.
+ *
+ * Повторяющиеся серии разворачиваются во вхождения только этого дня.
+ * @param tasks Все задачи.
+ * @param day День.
+ * @return Задачи дня.
+ */
+QVector<Task> tasksForDay(const QVector<Task> &tasks, const QDate &day);
+
+/**
+ * @brief Раскладывает задачи по дням диапазона за один проход по списку.
+ *
+ * Повторяющиеся серии разворачиваются только в пределах диапазона.
+ * @param tasks Все задачи.
+ * @param first Первый день диапазона.
+ * @param last Последний день диапазона.
+ * @return Задачи каждого дня (дни без задач отсутствуют).
+ */
+QHash<QDate, QVector<Task>> tasksByDay(const QVector<Task> &tasks, const QDate &first, const QDate &last);
+
+/**
+ * @brief Распределяет задачи одного дня по колонкам (первая свободная колонка).
+ * @param dayTasks Задачи, уже обрезанные по границам дня.
+ * @return Блоки в исходном порядке задач; некорректные задачи пропускаются.
+ */
+QVector<ScheduleBlock> layoutDay(const QVector<Task> &dayTasks);
+
+} // namespace ScheduleLayout
+
+#endif // SCHEDULELAYOUT_H
@@ -0,0 +1,77 @@
+/**
+ * @file stallwatchdog.cpp
+ * @brief Реализация сторожевого потока для цикла событий GUI.
+ */
+#include "stallwatchdog.h"
+#include "perfmonitor.h"
+#include <QTimer>
+#include <QDateTime>
+#include <algorithm>
+
+StallWatchdog::StallWatchdog(int thresholdMs, QObject *parent)
+    : QThread(parent), m_thresholdMs(thresholdMs)
+{
+    m_clock.start();
+    m_heartbeatTimer = new QTimer(this);
+    // Сердцебиение заметно чаще порога, чтобы не давать ложных срабатываний
+    m_heartbeatTimer->setInterval(std::max(10, m_thresholdMs / 4));
+    connect(m_heartbeatTimer, &QTimer::timeout, this, [this]() {
+        m_lastBeatMs.store(m_clock.elapsed(), std::memory_order_release);
+    });
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    stopWatching();
+}
+
+void StallWatchdog::startWatching()
+{
+    if (isRunning())
+        return;
+    m_lastBeatMs.store(m_clock.elapsed(), std::memory_order_release);
+    m_heartbeatTimer->start();
+    start(QThread::LowPriority);
+}
+
+void StallWatchdog::stopWatching()
+{
+    m_heartbeatTimer->stop();
+    if (isRunning()) {
+        requestInterruption();
+        wait();
+    }
+}
+
+void StallWatchdog::run()
+{
+    PerfMonitor *monitor = PerfMonitor::instance();
+    const int pollMs = std::max(5, m_thresholdMs / 4);
+
+    bool inStall = false;
+    qint64 stallStartMs = 0;
+    PerfMonitor::StallRecord pending;
+
+    while (!isInterruptionRequested()) {
+        QThread::msleep(pollMs);
+
+        qint64 lastBeat = m_lastBeatMs.load(std::memory_order_acquire);
+        qint64 now = m_clock.elapsed();
+
+        if (!inStall && now - lastBeat > m_thresholdMs) {
+            // Фиксируем операцию в момент обнаружения: к окончанию зависания она уже завершится
+            inStall = true;
+            stallStartMs = lastBeat;
+            const char *operation = monitor->currentOperation();
+            const char *phase = monitor->currentPhase();
+            pending = PerfMonitor::StallRecord();
+            pending.when = QDateTime::currentDateTime().addMSecs(lastBeat - now);
+            pending.operation = operation ? QString::fromLatin1(operation) : QString();
+            pending.phase = phase ? QString::fromLatin1(phase) : QString();
+        } else if (inStall && lastBeat > stallStartMs) {
+            inStall = false;
+            pending.durationMs = lastBeat - stallStartMs;
+            monitor->recordStall(pending);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * @file stallwatchdog.h
+ * @brief Сторожевой поток, фиксирующий зависания цикла событий GUI.
+ */
+
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+
+class QTimer;
+
+/**
+ * @class StallWatchdog
+ * @brief Следит за тем, что цикл событий GUI прокручивается не реже, чем раз в N мс.
+ *
+ * Таймер в потоке GUI обновляет метку «сердцебиения», а отдельный поток
+ * проверяет её возраст. Если цикл событий стоит дольше порога, в PerfMonitor
+ * записывается зависание вместе с активной в этот момент операцией.
+ */
+class StallWatchdog : public QThread
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Конструктор StallWatchdog.
+     * @param thresholdMs Порог зависания в миллисекундах.
+     * @param parent Родительский объект (должен жить в потоке GUI).
+     */
+    explicit StallWatchdog(int thresholdMs = 200, QObject *parent = nullptr);
+    ~StallWatchdog() override;
+
+    /**
+     * @brief Запустить сердцебиение и сторожевой поток.
+     */
+    void startWatching();
+    /**
+     * @brief Остановить сторожевой поток.
+     */
+    void stopWatching();
+
+protected:
+    void run() override;
+
+private:
+    int m_thresholdMs;
+    QElapsedTimer m_clock;
+    QTimer *m_heartbeatTimer;
+    std::atomic<qint64> m_lastBeatMs{0};
+};
+
+#endif // STALLWATCHDOG_H
@@ -6,6 +6,7 @@
 #include <QDateTime>
 #include <QUuid>
 #include <QDate> // Added for QDate::currentDate()
+#include <algorithm>
 
 Task::Task()
     : m_title(""),
@@ -17,6 +18,7 @@ Task::Task()
     m_status("Не начато"),
     m_description(""),
     m_priority("Средний"),
+    m_estimatedMinutes(60),
     m_wasModified(false),
     m_uid(QUuid::createUuid())
 {
@@ -32,11 +34,30 @@ Task::Task(const QString &title, const QString &projectType, const QDateTime &st
     m_status(status),
     m_description(description),
     m_priority("Средний"),
+    m_estimatedMinutes(60),
     m_wasModified(false),
     m_uid(QUuid::createUuid())
 {
 }
 
+void Task::setTagIds(const QVector<int> &ids)
+{
+    m_tagIds = ids;
+    std::sort(m_tagIds.begin(), m_tagIds.end());
+    m_tagIds.erase(std::unique(m_tagIds.begin(), m_tagIds.end()), m_tagIds.end());
+}
+
+bool Task::hasTag(int id) const
+{
+    return std::binary_search(m_tagIds.cbegin(), m_tagIds.cend(), id);
+}
+
+qint64 Task::fieldStamp(const QString &key) const
+{
+    const auto it = m_fieldStamps.constFind(key);
+    return it != m_fieldStamps.constEnd() ? it.value() : m_creationDateTime.toMSecsSinceEpoch();
+}
+
 QString Task::formatDate(const Task &task)
 {
     QDate today = QDate::currentDate();
@@ -44,15 +65,14 @@ QString Task::formatDate(const Task &task)
         QDateTime start = task.startDateTime();
         QDateTime end = task.endDateTime();
         QString dateText = (start.date() == today) ? "Сегодня" : start.date().toString("dd.MM.yyyy");
-        return QString("%1 %2–%3")
+        return QString("%1 %2–%3%4")
             .arg(dateText)
             .arg(start.time().toString("HH:mm"))
-            .arg(end.time().toString("HH:mm"));
+            .arg(end.time().toString("HH:mm"))
+            .arg(task.isRecurring() ? " ↻" : "");
     } else {
         QDateTime due = task.dueDateTime();
-        if (due.date() == today) {
-            return "Сегодня";
-        }
-        return due.date().toString("dd.MM.yyyy");
+        QString dateText = (due.date() == today) ? "Сегодня" : due.date().toString("dd.MM.yyyy");
+        return task.isRecurring() ? dateText + " ↻" : dateText;
     }
 }
@@ -8,7 +8,9 @@
 
 #include <QDateTime>
 #include <QDebug>
+#include <QHash>
 #include <QUuid>
+#include "recurrence.h"
 
 /**
  * @class Task
@@ -55,12 +57,68 @@ public:
     QString priority() const { return m_priority; }
     void setPriority(const QString &priority) { m_priority = priority; }
 
+    /**
+     * @brief Оценка длительности в минутах (для задач без времени, используется автопланировщиком).
+     */
+    int estimatedMinutes() const { return m_estimatedMinutes; }
+    void setEstimatedMinutes(int minutes) { m_estimatedMinutes = minutes; }
+
+    /**
+     * @brief Правило повторения серии (для обычной задачи — NoRepeat).
+     */
+    const Recurrence &recurrence() const { return m_recurrence; }
+    void setRecurrence(const Recurrence &recurrence) { m_recurrence = recurrence; }
+    bool isRecurring() const { return m_recurrence.isRecurring(); }
+
+    /**
+     * @brief Дата вхождения, если задача — развёрнутое вхождение серии (UID совпадает с серией).
+     */
+    QDate occurrenceDate() const { return m_occurrenceDate; }
+    void setOccurrenceDate(const QDate &date) { m_occurrenceDate = date; }
+    bool isOccurrence() const { return m_occurrenceDate.isValid(); }
+
     QUuid uid() const { return m_uid; }
     void setUid(const QUuid &id) { m_uid = id; }
 
+    /**
+     * @brief UID родительской задачи (пустой — задача верхнего уровня).
+     */
+    QUuid parentUid() const { return m_parentUid; }
+    void setParentUid(const QUuid &uid) { m_parentUid = uid; }
+
+    /**
+     * @brief UID задач, которые должны закончиться до начала этой.
+     */
+    QVector<QUuid> dependencies() const { return m_dependencies; }
+    void setDependencies(const QVector<QUuid> &uids) { m_dependencies = uids; }
+
+    /**
+     * @brief Теги задачи — отсортированные ID из CustomDataManager::tagName.
+     */
+    QVector<int> tagIds() const { return m_tagIds; }
+    /**
+     * @brief Задать теги; ID сортируются, повторы отбрасываются.
+     */
+    void setTagIds(const QVector<int> &ids);
+    bool hasTag(int id) const;
+
     bool wasModified() const { return m_wasModified; }
     void setWasModified(bool modified) { m_wasModified = modified; }
 
+    /**
+     * @brief Время последнего изменения полей, мс от эпохи, по ключам JSON-представления.
+     *
+     * Хранятся только поля, менявшиеся после создания задачи; по отметкам
+     * синхронизация (TaskSync) решает, чьё значение поля новее.
+     */
+    QHash<QString, qint64> fieldStamps() const { return m_fieldStamps; }
+    void setFieldStamps(const QHash<QString, qint64> &stamps) { m_fieldStamps = stamps; }
+    /**
+     * @brief Отметка поля; для поля, не менявшегося с создания, — время создания задачи.
+     */
+    qint64 fieldStamp(const QString &key) const;
+    void setFieldStamp(const QString &key, qint64 msecs) { m_fieldStamps.insert(key, msecs); }
+
     static QString formatDate(const Task& task);
 
 private:
@@ -73,8 +131,15 @@ private:
     QString m_status;
     QString m_description;
     QString m_priority;
+    int m_estimatedMinutes = 60;
     bool m_wasModified = false;
     QUuid m_uid;
+    QUuid m_parentUid;
+    QVector<QUuid> m_dependencies;
+    QVector<int> m_tagIds;
+    QHash<QString, qint64> m_fieldStamps;
+    Recurrence m_recurrence;
+    QDate m_occurrenceDate;
 };
 
 
@@ -5,12 +5,16 @@
 #include "taskdelegate.h"
 #include "taskmodel.h"
 #include <QPainter>
+#include <QIcon>
 #include <QApplication>
 #include <QDate>
 #include <QString>
 #include <QDateTime>
 #include <QFontMetrics>
+#include <QStaticText>
+#include <algorithm>
 #include "task.h"
+#include "tracing.h"
 
 TaskDelegate::TaskDelegate(QObject *parent)
     : QStyledItemDelegate(parent)
@@ -20,50 +24,38 @@ void TaskDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
                          const QModelIndex &index) const
 {
     if (!index.isValid()) return;
+    TRACE_SCOPE("TaskDelegate::paint");
 
     painter->save();
 
-    // Получение данных
-    Task task = index.data(TaskModel::FullTaskRole).value<Task>();
-    QString title = task.title();
-    QString project = task.projectType();
-    QString status = task.status();
-    QString dateStr = Task::formatDate(task);
-
-
     // Отрисовка фона
     QRect rect = option.rect;
+    // Значок колонки (предупреждение об изменении, цвет приоритета) — слева от текста
+    const QIcon icon = qvariant_cast<QIcon>(index.data(Qt::DecorationRole));
+    QRect textRect = rect.adjusted(icon.isNull() ? 10 : 30, 5, -10, -5);
+    const PaintEntry &entry = paintEntry(index, textRect.width());
+
     painter->setRenderHint(QPainter::Antialiasing);
     painter->setPen(Qt::NoPen);
-
-    // Цвет фона в зависимости от статуса
-    QColor bgColor;
-    if (status == "Выполнено") bgColor = QColor(200, 255, 200);
-    else if (status == "В процессе") bgColor = QColor(255, 255, 150);
-    else bgColor = QColor(240, 240, 240);
-
-    painter->setBrush(bgColor);
+    painter->setBrush(entry.background);
     painter->drawRoundedRect(rect.adjusted(2, 2, -2, -2), 5, 5);
+    if (entry.border.isValid()) {
+        painter->setPen(QPen(entry.border, 2));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRoundedRect(rect.adjusted(3, 3, -3, -3), 5, 5);
+    }
 
-    // Отрисовка текста
-    painter->setPen(Qt::black);
+    // Отрисовка текста: раскладка уже готова, остаётся вывести глифы
     QFont font = painter->font();
-    font.setBold(true);
+    font.setBold(entry.bold);
     painter->setFont(font);
-    if (index.column() == TaskModel::TitleColumn) {
-        painter->drawText(rect.adjusted(10, 5, -10, -20), Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, title);
-    } else if (index.column() == TaskModel::DateColumn) {
-        painter->drawText(rect.adjusted(10, 25, -10, -5), Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, dateStr);
-    } else {
-        font.setBold(false);
-        painter->setFont(font);
-        painter->setPen(Qt::darkGray);
-        QString details = QString("%1 | %2 | %3")
-                              .arg(dateStr)
-                              .arg(project)
-                              .arg(status);
-        painter->drawText(rect.adjusted(10, 25, -10, -5), Qt::AlignLeft | Qt::AlignTop, details);
-    }
+    painter->setPen(entry.bold ? QColor(Qt::black) : QColor(Qt::darkGray));
+    painter->save();
+    painter->setClipRect(textRect, Qt::IntersectClip);
+    painter->drawStaticText(textRect.topLeft(), entry.text);
+    painter->restore();
+    if (!icon.isNull())
+        icon.paint(painter, QRect(rect.left() + 8, rect.center().y() - 8, 16, 16));
 
     // Выделение выбранного элемента
     if (option.state & QStyle::State_Selected) {
@@ -75,27 +67,135 @@ void TaskDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     painter->restore();
 }
 
+const TaskDelegate::PaintEntry &TaskDelegate::paintEntry(const QModelIndex &index, int textWidth) const
+{
+    QUuid uid = index.data(TaskModel::UidRole).toUuid();
+    QDate today = QDate::currentDate();
+    if (m_paintCache.size() >= kMaxCachedLayouts && !m_paintCache.contains(uid))
+        m_paintCache.clear();
+    QHash<int, PaintEntry> &taskEntries = m_paintCache[uid];
+    auto it = taskEntries.find(index.column());
+    // «Сегодня» в дате зависит от текущего дня, поэтому запись живёт не дольше суток
+    if (it != taskEntries.end() && it->textWidth == textWidth && it->builtOn == today)
+        return it.value();
+
+    Task task = index.data(TaskModel::FullTaskRole).value<Task>();
+    QString status = task.status();
+
+    PaintEntry entry;
+    entry.textWidth = textWidth;
+    entry.builtOn = today;
+    // Цвет фона в зависимости от статуса
+    if (status == "Выполнено") entry.background = QColor(200, 255, 200);
+    else if (status == "В процессе") entry.background = QColor(255, 255, 150);
+    else entry.background = QColor(240, 240, 240);
+    // Рамка по графу зависимостей: конфликт важнее критического пути
+    if (index.data(TaskModel::DependencyConflictRole).toBool())
+        entry.border = QColor(220, 40, 40);
+    else if (index.data(TaskModel::CriticalPathRole).toBool())
+        entry.border = QColor(230, 140, 0);
+
+    // Каждая колонка показывает своё значение; жирным — название и дата
+    entry.bold = index.column() == TaskModel::TitleColumn || index.column() == TaskModel::DateColumn;
+    entry.text.setTextWidth(std::max(1, textWidth));
+    const QString text = index.data(Qt::DisplayRole).toString();
+    entry.text.setTextFormat(Qt::PlainText);
+    entry.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    entry.text.setText(text);
+
+    if (it == taskEntries.end())
+        it = taskEntries.insert(index.column(), entry);
+    else
+        it.value() = entry;
+    return it.value();
+}
+
 QSize TaskDelegate::sizeHint(const QStyleOptionViewItem &option,
                              const QModelIndex &index) const
 {
-    Task task = index.data(TaskModel::FullTaskRole).value<Task>();
-    QString text;
-    if (index.column() == TaskModel::TitleColumn) {
-        text = task.title();
-    } else if (index.column() == TaskModel::DateColumn) {
-        text = Task::formatDate(task);
-    } else {
-        text = index.data(Qt::DisplayRole).toString();
-    }
-    QFont font = option.font;
-    QFontMetrics fm(font);
-    int width = option.rect.width() > 0 ? option.rect.width() : 120;
-    QRect textRect = fm.boundingRect(QRect(0, 0, width - 20, 1000), Qt::TextWordWrap, text);
-    int height = textRect.height() + 20;
     int minWidth = 120;
     if (index.column() == TaskModel::TitleColumn)
         minWidth = 400;
     if (index.column() == TaskModel::DateColumn)
         minWidth = 150;
-    return QSize(minWidth, std::max(height, 40));
+
+    int width = option.rect.width() > 0 ? option.rect.width() : 120;
+    QUuid uid = index.data(TaskModel::UidRole).toUuid();
+    HeightKey key{index.column(), width, fontKey(option.font)};
+    if (!uid.isNull()) {
+        auto taskIt = m_heightCache.constFind(uid);
+        if (taskIt != m_heightCache.constEnd()) {
+            auto hit = taskIt->constFind(key);
+            if (hit != taskIt->constEnd())
+                return QSize(minWidth, hit.value());
+        }
+    }
+
+    // paint рисует DisplayRole колонки, сдвинутый вправо, если у колонки есть значок
+    QString text = index.data(Qt::DisplayRole).toString();
+    const int iconWidth = index.data(Qt::DecorationRole).isNull() ? 0 : 20;
+    QFontMetrics fm(option.font);
+    QRect textRect = fm.boundingRect(QRect(0, 0, width - 20 - iconWidth, 1000), Qt::TextWordWrap, text);
+    int height = std::max(textRect.height() + 20, 40);
+
+    if (!uid.isNull()) {
+        if (m_cachedCount >= kMaxCachedHeights) {
+            m_heightCache.clear();
+            m_cachedCount = 0;
+        }
+        QHash<HeightKey, int> &taskHeights = m_heightCache[uid];
+        if (!taskHeights.contains(key))
+            ++m_cachedCount;
+        taskHeights.insert(key, height);
+    }
+    return QSize(minWidth, height);
+}
+
+void TaskDelegate::watchModel(QAbstractItemModel *model)
+{
+    if (!model) return;
+    connect(model, &QAbstractItemModel::dataChanged, this,
+            [this, model](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+                invalidateRows(model, topLeft.row(), bottomRight.row());
+            });
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this, model](const QModelIndex &, int first, int last) {
+                invalidateRows(model, first, last);
+            });
+    connect(model, &QAbstractItemModel::modelReset, this, &TaskDelegate::clearCache);
+}
+
+void TaskDelegate::invalidateTask(const QUuid &uid)
+{
+    m_paintCache.remove(uid);
+    auto it = m_heightCache.find(uid);
+    if (it == m_heightCache.end()) return;
+    m_cachedCount -= it->size();
+    m_heightCache.erase(it);
+}
+
+void TaskDelegate::clearCache()
+{
+    m_heightCache.clear();
+    m_paintCache.clear();
+    m_cachedCount = 0;
+}
+
+size_t TaskDelegate::fontKey(const QFont &font) const
+{
+    // QFont::key() собирает строку, поэтому запоминаем ключ последнего шрифта
+    if (m_lastFontKey == 0 || font != m_lastFont) {
+        m_lastFont = font;
+        m_lastFontKey = qHash(font.key()) | 1;
+    }
+    return m_lastFontKey;
+}
+
+void TaskDelegate::invalidateRows(QAbstractItemModel *model, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        QUuid uid = model->index(row, 0).data(TaskModel::UidRole).toUuid();
+        if (!uid.isNull())
+            invalidateTask(uid);
+    }
 }
@@ -7,10 +7,23 @@
 #define TASKDELEGATE_H
 
 #include <QStyledItemDelegate>
+#include <QHash>
+#include <QUuid>
+#include <QFont>
+#include <QColor>
+#include <QDate>
+#include <QStaticText>
+
+class QAbstractItemModel;
 
 /**
  * @class TaskDelegate
  * @brief Делегат для отрисовки задач в таблице/списке.
+ *
+ * Высоты строк кэшируются по (uid, колонка, ширина, шрифт), поэтому повторные
+ * resizeRowToContents не пересчитывают перенос текста для неизменённых задач.
+ * Текст ячеек хранится как готовая раскладка QStaticText и перестраивается
+ * только при изменении задачи или ширины колонки.
  */
 class TaskDelegate : public QStyledItemDelegate
 {
@@ -23,6 +36,62 @@ public:
     QSize sizeHint(const QStyleOptionViewItem &option,
                    const QModelIndex &index) const override;
     virtual ~TaskDelegate() = default;
+
+    /**
+     * @brief Следить за изменениями модели задач и сбрасывать устаревшие высоты.
+     * @param model Исходная модель (TaskModel).
+     */
+    void watchModel(QAbstractItemModel *model);
+    /**
+     * @brief Сбросить закэшированные высоты и раскладки задачи.
+     * @param uid Идентификатор задачи.
+     */
+    void invalidateTask(const QUuid &uid);
+    /**
+     * @brief Полностью очистить кэши высот и раскладок текста.
+     */
+    void clearCache();
+
+private:
+    /**
+     * @brief Ключ высоты внутри одной задачи: колонка, ширина и шрифт.
+     */
+    struct HeightKey {
+        int column;
+        int width;
+        size_t fontKey;
+        bool operator==(const HeightKey &other) const {
+            return column == other.column && width == other.width && fontKey == other.fontKey;
+        }
+    };
+    friend size_t qHash(const HeightKey &key, size_t seed) {
+        return qHashMulti(seed, key.column, key.width, key.fontKey);
+    }
+
+    /**
+     * @brief Подготовленный к отрисовке текст ячейки.
+     */
+    struct PaintEntry {
+        QStaticText text;
+        QColor background;
+        QColor border; // конфликт зависимостей или критический путь; невалиден — без рамки
+        bool bold = true;
+        int textWidth = -1;
+        QDate builtOn;
+    };
+
+    static constexpr int kMaxCachedHeights = 200000;
+    static constexpr int kMaxCachedLayouts = 50000;
+
+    size_t fontKey(const QFont &font) const;
+    void invalidateRows(QAbstractItemModel *model, int first, int last);
+    const PaintEntry &paintEntry(const QModelIndex &index, int textWidth) const;
+
+    mutable QHash<QUuid, QHash<HeightKey, int>> m_heightCache;
+    mutable QHash<QUuid, QHash<int, PaintEntry>> m_paintCache;
+    mutable int m_cachedCount = 0;
+    mutable QFont m_lastFont;
+    mutable size_t m_lastFontKey = 0;
 };
 
 #endif // TASKDELEGATE_H
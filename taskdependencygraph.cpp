@@ -0,0 +1,310 @@
+/**
+ * @file taskdependencygraph.cpp
+ * @brief Реализация графа зависимостей задач.
+ */
+#include "taskdependencygraph.h"
+#include "tracing.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+
+void TaskDependencyGraph::setTiming(const QUuid &uid, qint64 startMs, qint64 endMs)
+{
+    endMs = std::max(startMs, endMs);
+    auto it = m_nodes.find(uid);
+    if (it == m_nodes.end()) {
+        Node node;
+        node.order = m_nextOrder++;
+        node.startMs = startMs;
+        node.endMs = endMs;
+        node.finishMs = endMs;
+        node.latestFinishMs = endMs;
+        m_finishes.insert(endMs);
+        m_nodes.insert(uid, node);
+        m_changed.insert(uid);
+        propagate({}, {uid});
+        return;
+    }
+
+    if (it->startMs == startMs && it->endMs == endMs)
+        return;
+    it->startMs = startMs;
+    it->endMs = endMs;
+    // Признак конфликта последователей зависит от окончания этой задачи
+    m_changed.insert(uid);
+    for (const QUuid &succ : std::as_const(it->succs))
+        m_changed.insert(succ);
+    const QVector<QUuid> preds = it->preds;
+    propagate({uid}, preds);
+}
+
+bool TaskDependencyGraph::addEdge(const QUuid &from, const QUuid &to)
+{
+    TRACE_SCOPE("TaskDependencyGraph::addEdge");
+    if (from == to || !m_nodes.contains(from) || !m_nodes.contains(to) || createsCycle(from, to)) {
+        // Узлы, созданные под отвергнутое ребро, не должны влиять на окончание графа
+        dropIfIsolated(from);
+        dropIfIsolated(to);
+        propagate({}, {});
+        return false;
+    }
+    if (m_nodes[from].succs.contains(to))
+        return true;
+
+    if (m_nodes[to].order < m_nodes[from].order)
+        reorder(from, to);
+    m_nodes[from].succs.append(to);
+    m_nodes[to].preds.append(from);
+    m_changed.insert(to);
+    propagate({to}, {from});
+    return true;
+}
+
+void TaskDependencyGraph::removeEdge(const QUuid &from, const QUuid &to)
+{
+    auto fromIt = m_nodes.find(from);
+    auto toIt = m_nodes.find(to);
+    if (fromIt == m_nodes.end() || toIt == m_nodes.end() || !fromIt->succs.removeOne(to))
+        return;
+    toIt->preds.removeOne(from);
+    m_changed.insert(from);
+    m_changed.insert(to);
+    dropIfIsolated(from);
+    dropIfIsolated(to);
+    propagate({to}, {from});
+}
+
+void TaskDependencyGraph::removeNode(const QUuid &uid)
+{
+    auto it = m_nodes.find(uid);
+    if (it == m_nodes.end())
+        return;
+    const Node node = it.value();
+    m_finishes.erase(m_finishes.find(node.finishMs));
+    m_nodes.erase(it);
+    m_changed.insert(uid);
+
+    for (const QUuid &pred : node.preds) {
+        m_nodes[pred].succs.removeOne(uid);
+        m_changed.insert(pred);
+    }
+    for (const QUuid &succ : node.succs) {
+        m_nodes[succ].preds.removeOne(uid);
+        m_changed.insert(succ);
+    }
+    for (const QUuid &pred : node.preds)
+        dropIfIsolated(pred);
+    for (const QUuid &succ : node.succs)
+        dropIfIsolated(succ);
+    propagate(node.succs, node.preds);
+}
+
+void TaskDependencyGraph::clear()
+{
+    m_nodes.clear();
+    m_finishes.clear();
+    m_changed.clear();
+    m_nextOrder = 0;
+    m_lastProjectFinishMs = 0;
+}
+
+void TaskDependencyGraph::dropIfIsolated(const QUuid &uid)
+{
+    auto it = m_nodes.find(uid);
+    if (it == m_nodes.end() || !it->preds.isEmpty() || !it->succs.isEmpty())
+        return;
+    m_finishes.erase(m_finishes.find(it->finishMs));
+    m_nodes.erase(it);
+    m_changed.insert(uid);
+}
+
+bool TaskDependencyGraph::createsCycle(const QUuid &from, const QUuid &to) const
+{
+    if (from == to)
+        return true;
+    const auto fromIt = m_nodes.constFind(from);
+    if (fromIt == m_nodes.constEnd() || !m_nodes.contains(to))
+        return false;
+
+    // Путь в from проходит только через узлы с меньшим номером — остальное не обходим
+    const int limit = fromIt->order;
+    QVector<QUuid> stack{to};
+    QSet<QUuid> seen{to};
+    while (!stack.isEmpty()) {
+        const QUuid uid = stack.takeLast();
+        if (uid == from)
+            return true;
+        const Node &node = *m_nodes.constFind(uid);
+        if (node.order > limit)
+            continue;
+        for (const QUuid &succ : node.succs) {
+            if (!seen.contains(succ)) {
+                seen.insert(succ);
+                stack.append(succ);
+            }
+        }
+    }
+    return false;
+}
+
+void TaskDependencyGraph::reorder(const QUuid &from, const QUuid &to)
+{
+    // Пирс — Келли: переставляются только узлы между номерами to и from
+    const int lower = m_nodes[to].order;
+    const int upper = m_nodes[from].order;
+    auto collect = [this](const QUuid &start, bool forward, int lower, int upper) {
+        QVector<QUuid> result{start};
+        QSet<QUuid> seen{start};
+        for (int i = 0; i < result.size(); ++i) {
+            const Node &node = *m_nodes.constFind(result[i]);
+            for (const QUuid &next : forward ? node.succs : node.preds) {
+                const int order = m_nodes.constFind(next)->order;
+                if (order >= lower && order <= upper && !seen.contains(next)) {
+                    seen.insert(next);
+                    result.append(next);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end(), [this](const QUuid &a, const QUuid &b) {
+            return m_nodes.constFind(a)->order < m_nodes.constFind(b)->order;
+        });
+        return result;
+    };
+    const QVector<QUuid> ahead = collect(to, true, lower, upper);
+    const QVector<QUuid> behind = collect(from, false, lower, upper);
+
+    QVector<int> orders;
+    orders.reserve(ahead.size() + behind.size());
+    for (const QUuid &uid : ahead)
+        orders.append(m_nodes[uid].order);
+    for (const QUuid &uid : behind)
+        orders.append(m_nodes[uid].order);
+    std::sort(orders.begin(), orders.end());
+
+    // Предшественники from встают раньше всего, что достижимо из to
+    int next = 0;
+    for (const QUuid &uid : behind)
+        m_nodes[uid].order = orders[next++];
+    for (const QUuid &uid : ahead)
+        m_nodes[uid].order = orders[next++];
+}
+
+void TaskDependencyGraph::propagate(const QVector<QUuid> &forward, const QVector<QUuid> &backward)
+{
+    // Прямой проход: раннее окончание, по возрастанию номеров
+    std::map<int, QUuid> ahead;
+    for (const QUuid &uid : forward) {
+        const auto it = m_nodes.constFind(uid);
+        if (it != m_nodes.constEnd())
+            ahead.emplace(it->order, uid);
+    }
+    while (!ahead.empty()) {
+        const QUuid uid = ahead.begin()->second;
+        ahead.erase(ahead.begin());
+        Node &node = m_nodes[uid];
+        qint64 start = node.startMs;
+        for (const QUuid &pred : std::as_const(node.preds))
+            start = std::max(start, m_nodes.constFind(pred)->finishMs);
+        const qint64 finish = start + (node.endMs - node.startMs);
+        if (finish == node.finishMs)
+            continue;
+        m_finishes.erase(m_finishes.find(node.finishMs));
+        m_finishes.insert(finish);
+        node.finishMs = finish;
+        m_changed.insert(uid);
+        for (const QUuid &succ : std::as_const(node.succs))
+            ahead.emplace(m_nodes.constFind(succ)->order, succ);
+    }
+
+    // Обратный проход: позднее окончание, по убыванию номеров
+    std::map<int, QUuid, std::greater<int>> behind;
+    for (const QUuid &uid : backward) {
+        const auto it = m_nodes.constFind(uid);
+        if (it != m_nodes.constEnd())
+            behind.emplace(it->order, uid);
+    }
+    const qint64 projectFinish = projectFinishMs();
+    if (projectFinish != m_lastProjectFinishMs) {
+        // Сдвинулось окончание всего графа — от него считаются все конечные задачи
+        m_lastProjectFinishMs = projectFinish;
+        for (auto it = m_nodes.constBegin(); it != m_nodes.constEnd(); ++it) {
+            if (it->succs.isEmpty())
+                behind.emplace(it->order, it.key());
+        }
+    }
+    while (!behind.empty()) {
+        const QUuid uid = behind.begin()->second;
+        behind.erase(behind.begin());
+        Node &node = m_nodes[uid];
+        qint64 latest = projectFinish;
+        for (const QUuid &succ : std::as_const(node.succs)) {
+            const Node &next = *m_nodes.constFind(succ);
+            latest = std::min(latest, next.latestFinishMs - (next.endMs - next.startMs));
+        }
+        if (latest == node.latestFinishMs)
+            continue;
+        node.latestFinishMs = latest;
+        m_changed.insert(uid);
+        for (const QUuid &pred : std::as_const(node.preds))
+            behind.emplace(m_nodes.constFind(pred)->order, pred);
+    }
+}
+
+QSet<QUuid> TaskDependencyGraph::successorsOf(const QUuid &uid) const
+{
+    QSet<QUuid> result;
+    QVector<QUuid> stack = m_nodes.value(uid).succs;
+    while (!stack.isEmpty()) {
+        const QUuid current = stack.takeLast();
+        if (result.contains(current))
+            continue;
+        result.insert(current);
+        stack += m_nodes.constFind(current)->succs;
+    }
+    return result;
+}
+
+QVector<QUuid> TaskDependencyGraph::topologicalOrder() const
+{
+    QVector<QUuid> result = m_nodes.keys();
+    std::sort(result.begin(), result.end(), [this](const QUuid &a, const QUuid &b) {
+        return m_nodes.constFind(a)->order < m_nodes.constFind(b)->order;
+    });
+    return result;
+}
+
+qint64 TaskDependencyGraph::earliestStartMs(const QUuid &uid) const
+{
+    const auto it = m_nodes.constFind(uid);
+    return it == m_nodes.constEnd() ? 0 : it->finishMs - (it->endMs - it->startMs);
+}
+
+qint64 TaskDependencyGraph::slackMs(const QUuid &uid) const
+{
+    const auto it = m_nodes.constFind(uid);
+    return it == m_nodes.constEnd() ? 0 : it->latestFinishMs - it->finishMs;
+}
+
+bool TaskDependencyGraph::isCritical(const QUuid &uid) const
+{
+    return contains(uid) && slackMs(uid) <= 0;
+}
+
+bool TaskDependencyGraph::hasConflict(const QUuid &uid) const
+{
+    const auto it = m_nodes.constFind(uid);
+    if (it == m_nodes.constEnd())
+        return false;
+    for (const QUuid &pred : it->preds) {
+        if (it->startMs < m_nodes.constFind(pred)->endMs)
+            return true;
+    }
+    return false;
+}
+
+QSet<QUuid> TaskDependencyGraph::takeChanged()
+{
+    QSet<QUuid> changed;
+    changed.swap(m_changed);
+    return changed;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file taskdependencygraph.h
+ * @brief Граф зависимостей задач: топологический порядок и критический путь.
+ */
+
+#ifndef TASKDEPENDENCYGRAPH_H
+#define TASKDEPENDENCYGRAPH_H
+
+#include <QHash>
+#include <QSet>
+#include <QUuid>
+#include <QVector>
+#include <set>
+
+/**
+ * @class TaskDependencyGraph
+ * @brief Рёбра «A должна закончиться до начала B» между задачами по UID.
+ *
+ * В графе только задачи, у которых есть хотя бы одна зависимость.
+ * Топологический порядок хранится номерами узлов и при добавлении ребра
+ * поправляется только на затронутом отрезке (алгоритм Пирса — Келли),
+ * там же обнаруживается цикл. Раннее начало и резерв времени пересчитываются
+ * от изменённых узлов по порядку, а не для всего графа: прямой проход —
+ * по возрастанию номеров, обратный — по убыванию.
+ */
+class TaskDependencyGraph
+{
+public:
+    /**
+     * @brief Задать время задачи (узел создаётся, если его ещё нет).
+     * @param uid Задача.
+     * @param startMs Запланированное начало, мс от эпохи.
+     * @param endMs Запланированное окончание.
+     */
+    void setTiming(const QUuid &uid, qint64 startMs, qint64 endMs);
+    /**
+     * @brief Добавить зависимость: to не может начаться до окончания from.
+     *
+     * Оба узла должны существовать (см. setTiming).
+     * @return false, если ребро замкнуло бы цикл; граф тогда не меняется.
+     */
+    bool addEdge(const QUuid &from, const QUuid &to);
+    /**
+     * @brief Удалить зависимость; узлы без рёбер удаляются из графа.
+     */
+    void removeEdge(const QUuid &from, const QUuid &to);
+    /**
+     * @brief Удалить задачу со всеми её рёбрами.
+     */
+    void removeNode(const QUuid &uid);
+    /**
+     * @brief Очистить граф.
+     */
+    void clear();
+
+    bool contains(const QUuid &uid) const { return m_nodes.contains(uid); }
+    int size() const { return m_nodes.size(); }
+    /**
+     * @brief Замкнуло бы ребро from → to цикл (достижима ли from из to).
+     */
+    bool createsCycle(const QUuid &from, const QUuid &to) const;
+    /**
+     * @brief Все задачи, которые не могут начаться до окончания uid (прямо или через другие).
+     */
+    QSet<QUuid> successorsOf(const QUuid &uid) const;
+    QVector<QUuid> predecessors(const QUuid &uid) const { return m_nodes.value(uid).preds; }
+    QVector<QUuid> successors(const QUuid &uid) const { return m_nodes.value(uid).succs; }
+    /**
+     * @brief Узлы в топологическом порядке (для проверок и экспорта).
+     */
+    QVector<QUuid> topologicalOrder() const;
+
+    /**
+     * @brief Раннее начало с учётом предшественников: не раньше запланированного
+     * начала и не раньше расчётного окончания каждого предшественника.
+     */
+    qint64 earliestStartMs(const QUuid &uid) const;
+    /**
+     * @brief Резерв времени: на сколько задачу можно сдвинуть, не отодвигая окончание всего графа.
+     */
+    qint64 slackMs(const QUuid &uid) const;
+    /**
+     * @brief Задача на критическом пути (резерв равен нулю).
+     */
+    bool isCritical(const QUuid &uid) const;
+    /**
+     * @brief Запланированное начало раньше запланированного окончания одного из предшественников.
+     */
+    bool hasConflict(const QUuid &uid) const;
+    /**
+     * @brief Забрать UID задач, у которых с прошлого вызова изменились расчётные значения.
+     */
+    QSet<QUuid> takeChanged();
+
+private:
+    struct Node {
+        QVector<QUuid> preds;
+        QVector<QUuid> succs;
+        int order = 0;
+        qint64 startMs = 0;
+        qint64 endMs = 0;
+        qint64 finishMs = 0;       // расчётное окончание с учётом предшественников
+        qint64 latestFinishMs = 0; // позднее окончание при неизменном окончании графа
+    };
+
+    QHash<QUuid, Node> m_nodes;
+    int m_nextOrder = 0;
+    std::multiset<qint64> m_finishes; // расчётные окончания всех узлов — окончание графа
+    qint64 m_lastProjectFinishMs = 0; // окончание графа при последнем обратном проходе
+    QSet<QUuid> m_changed;
+
+    qint64 projectFinishMs() const { return m_finishes.empty() ? 0 : *m_finishes.rbegin(); }
+    /**
+     * @brief Переставить номера после ребра from → to, идущего против порядка.
+     */
+    void reorder(const QUuid &from, const QUuid &to);
+    /**
+     * @brief Пересчитать раннее окончание от forward и позднее окончание от backward.
+     */
+    void propagate(const QVector<QUuid> &forward, const QVector<QUuid> &backward);
+    void dropIfIsolated(const QUuid &uid);
+};
+
+#endif // TASKDEPENDENCYGRAPH_H
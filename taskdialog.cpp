@@ -17,10 +17,15 @@
 #include <QCheckBox>
 #include <QDateEdit>
 #include <QTimeEdit>
+#include <QSpinBox>
+#include <QGridLayout>
+#include <QListWidget>
 #include "customdatamanager.h"
+#include "taskmodel.h"
+#include <algorithm>
 
-TaskDialog::TaskDialog(CustomDataManager *dataManager, QWidget *parent, const Task &task)
-    : QDialog(parent), m_dataManager(dataManager), m_originalTask(task)
+TaskDialog::TaskDialog(CustomDataManager *dataManager, QWidget *parent, const Task &task, const TaskModel *model)
+    : QDialog(parent), m_model(model), m_dataManager(dataManager), m_originalTask(task)
 {
     setWindowTitle(task.title().isEmpty() ? "Новая задача" : "Редактирование задачи");
     setMinimumWidth(400);
@@ -55,6 +60,46 @@ TaskDialog::TaskDialog(CustomDataManager *dataManager, QWidget *parent, const Ta
     mainLayout->addWidget(new QLabel("Проект:"));
     mainLayout->addWidget(projectTypeCombo);
 
+    // Теги: имена через запятую, в задаче хранятся их ID
+    if (m_dataManager) {
+        QStringList names;
+        for (int id : task.tagIds())
+            names.append(m_dataManager->tagName(id));
+        tagsEdit = new QLineEdit(names.join(", "), this);
+        tagsEdit->setPlaceholderText("Например: срочно, отчёт");
+        mainLayout->addWidget(new QLabel("Теги:"));
+        mainLayout->addWidget(tagsEdit);
+    }
+
+    // Родительская задача: сама задача и её потомки не предлагаются, чтобы не получить цикл
+    if (m_model && !task.isOccurrence()) {
+        parentCombo = new QComboBox(this);
+        parentCombo->addItem("Нет (задача верхнего уровня)", QUuid());
+        for (const Task &candidate : m_model->tasks()) {
+            if (candidate.uid() == task.uid() || m_model->isAncestor(task.uid(), candidate.uid()))
+                continue;
+            parentCombo->addItem(candidate.title(), candidate.uid());
+        }
+        parentCombo->setCurrentIndex(std::max(0, parentCombo->findData(task.parentUid())));
+        mainLayout->addWidget(new QLabel("Родительская задача:"));
+        mainLayout->addWidget(parentCombo);
+
+        // Предшественники: задачи, уже зависящие от этой, замкнули бы цикл
+        dependencyList = new QListWidget(this);
+        dependencyList->setMaximumHeight(100);
+        const QSet<QUuid> successors = m_model->dependencyGraph().successorsOf(task.uid());
+        for (const Task &candidate : m_model->tasks()) {
+            if (candidate.uid() == task.uid() || candidate.isRecurring() || successors.contains(candidate.uid()))
+                continue;
+            QListWidgetItem *item = new QListWidgetItem(candidate.title(), dependencyList);
+            item->setData(Qt::UserRole, candidate.uid());
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(task.dependencies().contains(candidate.uid()) ? Qt::Checked : Qt::Unchecked);
+        }
+        mainLayout->addWidget(new QLabel("Зависит от:"));
+        mainLayout->addWidget(dependencyList);
+    }
+
     populateCombos();
 
     statusCombo->setCurrentText(task.status().isEmpty() ? "Не начато" : task.status());
@@ -98,6 +143,70 @@ TaskDialog::TaskDialog(CustomDataManager *dataManager, QWidget *parent, const Ta
     timeLayout->addWidget(endTimeEdit);
     mainLayout->addLayout(timeLayout);
 
+    // Пересечения с другими задачами показываются сразу, пока время редактируется
+    conflictLabel = new QLabel(this);
+    conflictLabel->setWordWrap(true);
+    conflictLabel->setTextFormat(Qt::PlainText);
+    conflictLabel->setStyleSheet("color: #b00020;");
+    conflictLabel->hide();
+    mainLayout->addWidget(conflictLabel);
+    connect(dateEdit, &QDateEdit::dateChanged, this, &TaskDialog::updateConflicts);
+    connect(startTimeEdit, &QTimeEdit::timeChanged, this, &TaskDialog::updateConflicts);
+    connect(endTimeEdit, &QTimeEdit::timeChanged, this, &TaskDialog::updateConflicts);
+
+    // Оценка длительности — только для задач без времени, по ней работает автопланировщик
+    estimateLabel = new QLabel("Оценка длительности:", this);
+    estimateSpin = new QSpinBox(this);
+    estimateSpin->setRange(5, 24 * 60);
+    estimateSpin->setSingleStep(15);
+    estimateSpin->setSuffix(" мин");
+    estimateSpin->setValue(task.estimatedMinutes());
+    mainLayout->addWidget(estimateLabel);
+    mainLayout->addWidget(estimateSpin);
+
+    // Повторение задаётся для серии целиком; у отдельного вхождения правило не редактируется
+    const Recurrence &recurrence = task.recurrence();
+    repeatBox = new QWidget(this);
+    QGridLayout *repeatLayout = new QGridLayout(repeatBox);
+    repeatLayout->setContentsMargins(0, 0, 0, 0);
+    repeatCombo = new QComboBox(repeatBox);
+    repeatCombo->addItem("Не повторять", Recurrence::NoRepeat);
+    repeatCombo->addItem("Каждый день", Recurrence::Daily);
+    repeatCombo->addItem("Каждую неделю", Recurrence::Weekly);
+    repeatCombo->addItem("Каждый месяц", Recurrence::Monthly);
+    repeatCombo->setCurrentIndex(repeatCombo->findData(recurrence.frequency()));
+    repeatIntervalSpin = new QSpinBox(repeatBox);
+    repeatIntervalSpin->setRange(1, 99);
+    repeatIntervalSpin->setPrefix("интервал: ");
+    repeatIntervalSpin->setValue(recurrence.interval());
+    repeatUntilCheck = new QCheckBox("До", repeatBox);
+    repeatUntilCheck->setChecked(recurrence.until().isValid());
+    repeatUntilEdit = new QDateEdit(recurrence.until().isValid() ? recurrence.until() : dateEdit->date().addMonths(3), repeatBox);
+    repeatUntilEdit->setCalendarPopup(true);
+    repeatCountSpin = new QSpinBox(repeatBox);
+    repeatCountSpin->setRange(0, 999);
+    repeatCountSpin->setSpecialValueText("без ограничения");
+    repeatCountSpin->setSuffix(" раз");
+    repeatCountSpin->setValue(recurrence.count());
+    repeatLayout->addWidget(new QLabel("Повтор:", repeatBox), 0, 0);
+    repeatLayout->addWidget(repeatCombo, 0, 1);
+    repeatLayout->addWidget(repeatIntervalSpin, 0, 2);
+    repeatLayout->addWidget(repeatUntilCheck, 1, 0);
+    repeatLayout->addWidget(repeatUntilEdit, 1, 1);
+    repeatLayout->addWidget(repeatCountSpin, 1, 2);
+    mainLayout->addWidget(repeatBox);
+    auto updateRepeatControls = [this]() {
+        const bool repeats = repeatCombo->currentData().toInt() != Recurrence::NoRepeat;
+        repeatIntervalSpin->setEnabled(repeats);
+        repeatUntilCheck->setEnabled(repeats);
+        repeatUntilEdit->setEnabled(repeats && repeatUntilCheck->isChecked());
+        repeatCountSpin->setEnabled(repeats);
+    };
+    connect(repeatCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, updateRepeatControls);
+    connect(repeatUntilCheck, &QCheckBox::toggled, this, updateRepeatControls);
+    updateRepeatControls();
+    repeatBox->setVisible(!task.isOccurrence());
+
     // Кнопки
     QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
     connect(buttonBox, &QDialogButtonBox::accepted, this, &TaskDialog::validateAndAccept);
@@ -134,6 +243,47 @@ void TaskDialog::onTimedTaskToggled(bool checked)
 {
     startTimeEdit->setVisible(checked);
     endTimeEdit->setVisible(checked);
+    estimateLabel->setVisible(!checked);
+    estimateSpin->setVisible(!checked);
+    updateConflicts();
+}
+
+void TaskDialog::updateConflicts()
+{
+    m_conflictCount = 0;
+    const QDateTime start(dateEdit->date(), startTimeEdit->time());
+    const QDateTime end(dateEdit->date(), endTimeEdit->time());
+    if (!m_model || !isTimedTaskCheck->isChecked() || start >= end) {
+        conflictLabel->hide();
+        return;
+    }
+
+    // Запрос к индексу интервалов — O(log n + k) плюс вхождения серий этого дня, названия — по хэшу UID
+    const QVector<TaskIntervalIndex::Interval> hits =
+        m_model->overlapping(start, end, m_originalTask.uid());
+    m_conflictCount = hits.size();
+    if (hits.isEmpty()) {
+        conflictLabel->hide();
+        return;
+    }
+
+    const int shown = std::min<int>(3, hits.size());
+    QStringList items;
+    for (int i = 0; i < shown; ++i) {
+        const int row = m_model->findTask(hits[i].uid);
+        const QDateTime from = QDateTime::fromMSecsSinceEpoch(hits[i].startMs);
+        const QDateTime to = QDateTime::fromMSecsSinceEpoch(hits[i].endMs);
+        const QString format = from.date() == to.date() && from.date() == start.date() ? "HH:mm" : "dd.MM HH:mm";
+        items << QString("«%1» %2–%3")
+                     .arg(row >= 0 ? m_model->getTask(row).title() : QString("?"))
+                     .arg(from.toString(format))
+                     .arg(to.toString(format));
+    }
+    QString text = "Пересекается с: " + items.join(", ");
+    if (hits.size() > shown)
+        text += QString(" и ещё %1").arg(hits.size() - shown);
+    conflictLabel->setText(text);
+    conflictLabel->show();
 }
 
 void TaskDialog::validateAndAccept()
@@ -142,11 +292,32 @@ void TaskDialog::validateAndAccept()
         QMessageBox::warning(this, "Ошибка", "Заголовок задачи не может быть пустым");
         return;
     }
+    if (!m_originalTask.isOccurrence() && repeatCombo->currentData().toInt() != Recurrence::NoRepeat
+        && repeatUntilCheck->isChecked() && repeatUntilEdit->date() < dateEdit->date()) {
+        QMessageBox::warning(this, "Ошибка", "Повторение должно заканчиваться не раньше даты задачи");
+        return;
+    }
     if (isTimedTaskCheck->isChecked()) {
         if (startTimeEdit->time() >= endTimeEdit->time()) {
             QMessageBox::warning(this, "Ошибка", "Время окончания должно быть позже времени начала");
             return;
         }
+        if (m_conflictCount > 0
+            && QMessageBox::question(this, "Пересечение",
+                                     QString("Время задачи пересекается с другими задачами (%1). Сохранить всё равно?")
+                                         .arg(m_conflictCount)) != QMessageBox::Yes) {
+            return;
+        }
+    }
+    // Новые теги заводятся только при подтверждении: getTask() ничего не сохраняет
+    if (tagsEdit) {
+        m_tagIds.clear();
+        for (const QString &name : tagsEdit->text().split(',', Qt::SkipEmptyParts)) {
+            const int id = m_dataManager->internTag(name);
+            if (id >= 0)
+                m_tagIds.append(id);
+        }
+        m_tagsAccepted = true;
     }
     accept();
 }
@@ -159,8 +330,31 @@ Task TaskDialog::getTask() const
     task.setStatus(statusCombo->currentText());
     task.setPriority(priorityCombo->currentText());
     task.setProjectType(projectTypeCombo->currentText());
+    if (parentCombo)
+        task.setParentUid(parentCombo->currentData().toUuid());
+    if (m_tagsAccepted)
+        task.setTagIds(m_tagIds);
+    if (dependencyList) {
+        QVector<QUuid> dependencies;
+        for (int i = 0; i < dependencyList->count(); ++i) {
+            if (dependencyList->item(i)->checkState() == Qt::Checked)
+                dependencies.append(dependencyList->item(i)->data(Qt::UserRole).toUuid());
+        }
+        task.setDependencies(dependencies);
+    }
     // isProjectTask выставляется независимо от projectType
     task.setIsProjectTask(isTimedTaskCheck->isChecked());
+    if (!task.isProjectTask())
+        task.setEstimatedMinutes(estimateSpin->value());
+    if (!task.isOccurrence()) {
+        // Исключения и изменения отдельных вхождений сохраняются при правке правила
+        Recurrence recurrence = m_originalTask.recurrence();
+        recurrence.setFrequency(static_cast<Recurrence::Frequency>(repeatCombo->currentData().toInt()));
+        recurrence.setInterval(repeatIntervalSpin->value());
+        recurrence.setUntil(repeatUntilCheck->isChecked() ? repeatUntilEdit->date() : QDate());
+        recurrence.setCount(repeatCountSpin->value());
+        task.setRecurrence(recurrence.isRecurring() ? recurrence : Recurrence());
+    }
     task.setWasModified(false); // Clear the flag on any manual edit
     if (task.isProjectTask()) {
         QDate date = dateEdit->date();
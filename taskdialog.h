@@ -15,8 +15,12 @@
 class QLineEdit;
 class QDateTimeEdit;
 class QComboBox;
+class QListWidget;
 class QTextEdit;
+class QSpinBox;
+class QLabel;
 class CustomDataManager;
+class TaskModel;
 
 /**
  * @class TaskDialog
@@ -31,8 +35,10 @@ public:
      * @param dataManager Менеджер пользовательских данных.
      * @param parent Родительский виджет.
      * @param task Исходная задача (по умолчанию пустая).
+     * @param model Модель задач для проверки пересечений по времени (может быть nullptr).
      */
-    explicit TaskDialog(CustomDataManager *dataManager, QWidget *parent = nullptr, const Task &task = Task());
+    explicit TaskDialog(CustomDataManager *dataManager, QWidget *parent = nullptr, const Task &task = Task(),
+                        const TaskModel *model = nullptr);
     /**
      * @brief Получить задачу из диалога.
      * @return Задача.
@@ -66,6 +72,10 @@ private slots:
      * @param checked Включено/выключено.
      */
     void onTimedTaskToggled(bool checked);
+    /**
+     * @brief Пересчитать пересечения редактируемого интервала с другими задачами.
+     */
+    void updateConflicts();
 
 private:
     /**
@@ -77,13 +87,29 @@ private:
     QComboBox *projectTypeCombo;
     QComboBox *statusCombo;
     QComboBox *priorityCombo;
+    QComboBox *parentCombo = nullptr;
+    QListWidget *dependencyList = nullptr;
+    QLineEdit *tagsEdit = nullptr;
     QTextEdit *descriptionEdit;
     QCheckBox *isTimedTaskCheck;
     QDateEdit *dateEdit;
     QTimeEdit *startTimeEdit;
     QTimeEdit *endTimeEdit;
+    QLabel *estimateLabel;
+    QSpinBox *estimateSpin;
+    QLabel *conflictLabel;
+    QWidget *repeatBox;
+    QComboBox *repeatCombo;
+    QSpinBox *repeatIntervalSpin;
+    QCheckBox *repeatUntilCheck;
+    QDateEdit *repeatUntilEdit;
+    QSpinBox *repeatCountSpin;
+    const TaskModel *m_model;
+    int m_conflictCount = 0;
     CustomDataManager *m_dataManager;
     Task m_originalTask;
+    QVector<int> m_tagIds;       ///< ID тегов, заведённых при подтверждении
+    bool m_tagsAccepted = false; ///< До подтверждения теги задачи не меняются
 };
 
 #endif // TASKDIALOG_H
@@ -0,0 +1,73 @@
+/**
+ * @file taskfilewatcher.cpp
+ * @brief Реализация слежения за файлом задач.
+ */
+#include "taskfilewatcher.h"
+#include "tracing.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+
+TaskFileWatcher::TaskFileWatcher(TaskModel *model, const QString &filePath, QObject *parent)
+    : QObject(parent),
+    m_model(model),
+    m_filePath(filePath.isEmpty() ? TaskModel::tasksFilePath() : filePath),
+    m_watcher(new QFileSystemWatcher(this)),
+    m_debounce(new QTimer(this)),
+    m_parseWatcher(new QFutureWatcher<TaskModel::TaskFile>(this))
+{
+    const QString dirPath = QFileInfo(m_filePath).absolutePath();
+    QDir().mkpath(dirPath);
+    m_watcher->addPath(dirPath);
+    if (QFileInfo::exists(m_filePath))
+        m_watcher->addPath(m_filePath);
+
+    m_debounce->setSingleShot(true);
+    m_debounce->setInterval(DebounceMs);
+    connect(m_debounce, &QTimer::timeout, this, &TaskFileWatcher::reload);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &TaskFileWatcher::onPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &TaskFileWatcher::onPathChanged);
+    connect(m_parseWatcher, &QFutureWatcherBase::finished, this, &TaskFileWatcher::onParseFinished);
+}
+
+TaskFileWatcher::~TaskFileWatcher()
+{
+    m_parseWatcher->waitForFinished();
+}
+
+void TaskFileWatcher::onPathChanged()
+{
+    // Заменённый переименованием файл выпадает из наблюдения — возвращаем
+    if (QFileInfo::exists(m_filePath) && !m_watcher->files().contains(m_filePath))
+        m_watcher->addPath(m_filePath);
+    m_debounce->start();
+}
+
+void TaskFileWatcher::reload()
+{
+    if (m_parseWatcher->isRunning()) {
+        m_parseAgain = true;
+        return;
+    }
+    if (!QFileInfo::exists(m_filePath))
+        return;
+    m_parseWatcher->setFuture(QtConcurrent::run(&TaskModel::readTasksFile, m_filePath));
+}
+
+void TaskFileWatcher::onParseFinished()
+{
+    if (m_parseAgain) {
+        // Разобранное уже устарело
+        m_parseAgain = false;
+        reload();
+        return;
+    }
+    if (m_parseWatcher->future().resultCount() == 0)
+        return;
+    TRACE_SCOPE("TaskFileWatcher::onParseFinished");
+    const int changes = m_model->applyTasksFile(m_parseWatcher->result());
+    if (changes > 0)
+        emit reloaded(changes);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file taskfilewatcher.h
+ * @brief Слежение за tasks.json и подхват изменений, сделанных другими процессами.
+ */
+
+#ifndef TASKFILEWATCHER_H
+#define TASKFILEWATCHER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QString>
+#include "taskmodel.h"
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @class TaskFileWatcher
+ * @brief Перечитывает файл задач после изменения на диске и применяет разницу к модели.
+ *
+ * Изменения файла собираются с задержкой DebounceMs (запись может идти
+ * несколькими порциями), затем файл разбирается в фоновом потоке
+ * (TaskModel::readTasksFile), а модель приводится к нему поштучными
+ * вставками, удалениями и dataChanged (TaskModel::applyTasksFile) вместо
+ * сброса. Собственные сохранения модели узнаются по хэшу содержимого и не
+ * применяются повторно. Следится и за каталогом: файл, заменённый
+ * переименованием, снова берётся под наблюдение.
+ */
+class TaskFileWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int DebounceMs = 200;
+
+    /**
+     * @brief Конструктор TaskFileWatcher.
+     * @param model Модель, которую нужно держать в соответствии с файлом.
+     * @param filePath Файл задач; пустой путь — TaskModel::tasksFilePath().
+     * @param parent Родительский объект.
+     */
+    explicit TaskFileWatcher(TaskModel *model, const QString &filePath = QString(), QObject *parent = nullptr);
+    ~TaskFileWatcher() override;
+
+    /**
+     * @brief Перечитать файл сейчас, не дожидаясь уведомления.
+     */
+    void reload();
+
+signals:
+    /**
+     * @brief Изменения файла применены к модели.
+     * @param changes Число добавленных, удалённых и изменённых задач.
+     */
+    void reloaded(int changes);
+
+private:
+    TaskModel *m_model;
+    QString m_filePath;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_debounce;
+    QFutureWatcher<TaskModel::TaskFile> *m_parseWatcher;
+    bool m_parseAgain = false; // файл изменился, пока шёл разбор
+
+    void onPathChanged();
+    void onParseFinished();
+};
+
+#endif // TASKFILEWATCHER_H
@@ -4,7 +4,11 @@
  */
 #include "taskfilterproxymodel.h"
 #include "taskmodel.h"
+#include "customdatamanager.h"
+#include "perfmonitor.h"
+#include "tracing.h"
 #include <QDebug>
+#include <algorithm>
 
 TaskFilterProxyModel::TaskFilterProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent),
@@ -16,13 +20,20 @@ TaskFilterProxyModel::TaskFilterProxyModel(QObject *parent)
     m_filterDeadlineType(0),
     m_filterIsProjectTask(-1)
 {
+    // Любое изменение состава или порядка строк делает карту UID → строка устаревшей
+    auto markDirty = [this]() { m_proxyRowMapDirty = true; };
+    connect(this, &QAbstractItemModel::rowsInserted, this, markDirty);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, markDirty);
+    connect(this, &QAbstractItemModel::rowsMoved, this, markDirty);
+    connect(this, &QAbstractItemModel::layoutChanged, this, markDirty);
+    connect(this, &QAbstractItemModel::modelReset, this, markDirty);
 }
 
 void TaskFilterProxyModel::setFilterDate(const QDate &date)
 {
     if (m_filterDate != date) {
         m_filterDate = date;
-        invalidateFilter();
+        refilter();
     }
 }
 
@@ -30,7 +41,7 @@ void TaskFilterProxyModel::setFilterProjectType(const QString &projectType)
 {
     if (m_filterProjectType != projectType) {
         m_filterProjectType = projectType;
-        invalidateFilter();
+        refilter();
     }
 }
 
@@ -38,7 +49,7 @@ void TaskFilterProxyModel::setFilterTitle(const QString &title)
 {
     if (m_filterTitle != title) {
         m_filterTitle = title;
-        invalidateFilter();
+        refilter();
     }
 }
 
@@ -46,7 +57,7 @@ void TaskFilterProxyModel::setFilterStatus(const QString &status)
 {
     if (m_filterStatus != status) {
         m_filterStatus = status;
-        invalidateFilter();
+        refilter();
     }
 }
 
@@ -54,7 +65,7 @@ void TaskFilterProxyModel::setFilterPriority(const QString& prio)
 {
     if (m_filterPriority != prio) {
         m_filterPriority = prio;
-        invalidateFilter();
+        refilter();
     }
 }
 
@@ -62,26 +73,145 @@ void TaskFilterProxyModel::setFilterDeadlineType(int type)
 {
     if (m_filterDeadlineType != type) {
         m_filterDeadlineType = type;
-        invalidateFilter();
+        refilter();
     }
 }
 
 void TaskFilterProxyModel::setFilterIsProjectTask(int isProjectTask) {
     if (m_filterIsProjectTask != isProjectTask) {
         m_filterIsProjectTask = isProjectTask;
-        invalidateFilter();
+        refilter();
     }
 }
 
+void TaskFilterProxyModel::setFilterTags(const TagFilter &filter)
+{
+    if (m_filterTags != filter) {
+        m_filterTags = filter;
+        m_tagMatchesModel = nullptr;
+        refilter();
+    }
+}
+
+void TaskFilterProxyModel::setHierarchyModel(const TaskModel *model)
+{
+    if (m_hierarchyModel == model)
+        return;
+    m_hierarchyModel = model;
+    // Qt перепроверяет предков при изменении загруженной подзадачи
+    setRecursiveFilteringEnabled(model != nullptr);
+    refilter();
+}
+
+int TaskFilterProxyModel::proxyRowForUid(const QUuid &uid) const
+{
+    if (m_proxyRowMapDirty) {
+        m_proxyRowByUid.clear();
+        int rows = rowCount();
+        m_proxyRowByUid.reserve(rows);
+        for (int row = 0; row < rows; ++row) {
+            m_proxyRowByUid.insert(index(row, 0).data(TaskModel::UidRole).toUuid(), row);
+        }
+        m_proxyRowMapDirty = false;
+    }
+    return m_proxyRowByUid.value(uid, -1);
+}
+
+void TaskFilterProxyModel::refilter()
+{
+    PerfMonitor::Scope perfScope("invalidateFilter");
+    TRACE_SCOPE("TaskFilterProxyModel::invalidateFilter");
+    invalidateFilter();
+}
+
 bool TaskFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
     QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
     if (!index.isValid())
         return false;
 
-    Task task = index.data(TaskModel::FullTaskRole).value<Task>();
+    const Task task = index.data(TaskModel::FullTaskRole).value<Task>();
+    if (acceptsTask(task))
+        return true;
+    return m_hierarchyModel && acceptsDescendant(task.uid());
+}
+
+bool TaskFilterProxyModel::acceptsDescendant(const QUuid &uid) const
+{
+    QVector<QUuid> pending = m_hierarchyModel->childUids(uid);
+    while (!pending.isEmpty()) {
+        const QUuid current = pending.takeLast();
+        const int row = m_hierarchyModel->findTask(current);
+        if (row >= 0 && acceptsTask(m_hierarchyModel->tasks()[row]))
+            return true;
+        pending += m_hierarchyModel->childUids(current);
+    }
+    return false;
+}
+
+bool TagFilter::matches(const Task &task) const
+{
+    for (const QVector<int> &group : required) {
+        if (std::none_of(group.cbegin(), group.cend(), [&task](int tag) { return task.hasTag(tag); }))
+            return false;
+    }
+    return std::none_of(excluded.cbegin(), excluded.cend(), [&task](int tag) { return task.hasTag(tag); });
+}
+
+TagFilter TagFilter::parse(const QString &text, const CustomDataManager *dataManager)
+{
+    TagFilter filter;
+    if (!dataManager)
+        return filter;
+    const QStringList words = text.split(' ', Qt::SkipEmptyParts);
+    for (const QString &word : words) {
+        if (word.startsWith('-')) {
+            const int id = dataManager->tagId(word.mid(1));
+            if (id >= 0)
+                filter.excluded.append(id);
+            continue;
+        }
+        QVector<int> group;
+        for (const QString &name : word.split('|', Qt::SkipEmptyParts))
+            group.append(dataManager->tagId(name));
+        if (!group.isEmpty())
+            filter.required.append(group);
+    }
+    return filter;
+}
+
+bool TaskFilterProxyModel::acceptsTags(const Task &task) const
+{
+    if (m_filterTags.isEmpty())
+        return true;
+    const TaskModel *model = m_hierarchyModel ? m_hierarchyModel : qobject_cast<const TaskModel *>(sourceModel());
+    if (!model)
+        return m_filterTags.matches(task);
+
+    if (m_tagMatchesModel != model || m_tagMatchesRevision != model->tagIndexRevision()) {
+        // Одно вычисление на все строки вместо проверки списка тегов у каждой задачи
+        TRACE_SCOPE("TaskFilterProxyModel::evaluateTags");
+        m_tagMatches = RowBitmap::filled(model->rowCount());
+        for (const QVector<int> &group : m_filterTags.required) {
+            RowBitmap any;
+            for (int tag : group)
+                any |= model->rowsWithTag(tag);
+            m_tagMatches &= any;
+        }
+        for (int tag : m_filterTags.excluded)
+            m_tagMatches.subtract(model->rowsWithTag(tag));
+        m_tagMatchesModel = model;
+        m_tagMatchesRevision = model->tagIndexRevision();
+    }
+    return m_tagMatches.testBit(model->findTask(task.uid()));
+}
 
+bool TaskFilterProxyModel::acceptsTask(const Task &task) const
+{
     // Apply general filters first
+    if (!acceptsTags(task)) {
+        return false;
+    }
     if (!m_filterProjectType.isEmpty() && task.projectType() != m_filterProjectType) {
         return false;
     }
@@ -90,7 +220,10 @@ bool TaskFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &s
     }
     if (m_filterDate.isValid()) {
         bool dateMatches = false;
-        if (task.isProjectTask()) {
+        if (task.isRecurring()) {
+            // Серия подходит, если у неё есть вхождение в этот день
+            dateMatches = !Recurrence::expand(task, m_filterDate, m_filterDate).isEmpty();
+        } else if (task.isProjectTask()) {
             dateMatches = (task.startDateTime().date() <= m_filterDate && m_filterDate <= task.endDateTime().date());
         } else {
             dateMatches = (task.dueDateTime().date() == m_filterDate);
@@ -145,6 +278,8 @@ bool TaskFilterProxyModel::filterAcceptsRow_IgnoreDeadline(int source_row, const
     }
 
     if (m_filterDate.isValid()) {
+        if (task.isRecurring())
+            return !Recurrence::expand(task, m_filterDate, m_filterDate).isEmpty();
         if (task.startDateTime().date() > m_filterDate || task.endDateTime().date() < m_filterDate) {
             return false;
         }
@@ -8,7 +8,38 @@
 
 #include <QSortFilterProxyModel>
 #include <QDate>
+#include <QHash>
+#include <QUuid>
 #include "task.h"
+#include "rowbitmap.h"
+
+class TaskModel;
+class CustomDataManager;
+
+/**
+ * @struct TagFilter
+ * @brief Условие по тегам: каждая группа требует хотя бы один из своих тегов,
+ * группы объединяются по «и», исключённые теги запрещены.
+ */
+struct TagFilter {
+    QVector<QVector<int>> required;
+    QVector<int> excluded;
+
+    bool isEmpty() const { return required.isEmpty() && excluded.isEmpty(); }
+    bool operator==(const TagFilter &other) const { return required == other.required && excluded == other.excluded; }
+    bool operator!=(const TagFilter &other) const { return !(*this == other); }
+    /**
+     * @brief Проверка одной задачи по её списку тегов.
+     */
+    bool matches(const Task &task) const;
+    /**
+     * @brief Разобрать строку вида «работа срочно|важно -дом».
+     *
+     * Слова через пробел — «и», через «|» — «или», «-» перед словом — «не».
+     * Неизвестный обязательный тег не подходит ни одной задаче.
+     */
+    static TagFilter parse(const QString &text, const CustomDataManager *dataManager);
+};
 
 /**
  * @class TaskFilterProxyModel
@@ -55,6 +86,24 @@ public:
      * @param isProjectTask -1: все, 0: только без времени, 1: только по времени.
      */
     void setFilterIsProjectTask(int isProjectTask);
+    /**
+     * @brief Установить фильтр по тегам.
+     *
+     * Для источника TaskModel фильтр считается один раз на всю модель
+     * операциями над картами строк тегов (TaskModel::rowsWithTag) и
+     * пересчитывается только при смене версии этих карт.
+     * @param filter Условие по тегам; пустое — без фильтра.
+     */
+    void setFilterTags(const TagFilter &filter);
+
+    /**
+     * @brief Оставлять видимыми предков подходящих подзадач (для дерева TaskTreeModel).
+     *
+     * Потомки проверяются по индексу подзадач TaskModel, а не по узлам дерева,
+     * поэтому предок виден, даже если уровень с подходящей подзадачей ещё не загружен.
+     * @param model Модель с иерархией задач; nullptr — обычная построчная фильтрация.
+     */
+    void setHierarchyModel(const TaskModel *model);
 
     /**
      * @brief Получить текущий фильтр по дате.
@@ -68,6 +117,15 @@ public:
      * @return true если задача подходит.
      */
     bool filterAcceptsRow_IgnoreDeadline(int source_row, const QModelIndex &source_parent) const;
+    /**
+     * @brief Строка прокси-модели для задачи с данным UID.
+     *
+     * Карта UID → строка перестраивается лениво один раз после любого изменения
+     * состава или порядка строк, поэтому повторные запросы выполняются за O(1).
+     * @param uid Уникальный идентификатор задачи.
+     * @return Строка прокси-модели или -1, если задача скрыта фильтром.
+     */
+    int proxyRowForUid(const QUuid &uid) const;
 
 protected:
     /**
@@ -79,6 +137,23 @@ protected:
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
 
 private:
+    /**
+     * @brief Перезапуск фильтрации с замером длительности.
+     */
+    void refilter();
+    /**
+     * @brief Проходит ли задача все фильтры сама по себе.
+     */
+    bool acceptsTask(const Task &task) const;
+    /**
+     * @brief Проходит ли фильтры хотя бы один потомок задачи.
+     */
+    bool acceptsDescendant(const QUuid &uid) const;
+    /**
+     * @brief Проходит ли задача фильтр по тегам.
+     */
+    bool acceptsTags(const Task &task) const;
+
     QDate m_filterDate;
     QString m_filterProjectType;
     QString m_filterTitle;
@@ -86,6 +161,15 @@ private:
     QString m_filterPriority;
     int m_filterDeadlineType; // 0: все, 1: предстоящие, 2: просроченные
     int m_filterIsProjectTask = -1;
+    const TaskModel *m_hierarchyModel = nullptr;
+    TagFilter m_filterTags;
+
+    mutable RowBitmap m_tagMatches;                  // строки TaskModel, прошедшие фильтр по тегам
+    mutable const TaskModel *m_tagMatchesModel = nullptr; // для какой модели посчитан m_tagMatches
+    mutable quint64 m_tagMatchesRevision = 0;
+
+    mutable QHash<QUuid, int> m_proxyRowByUid;
+    mutable bool m_proxyRowMapDirty = true;
 };
 
 #endif // TASKFILTERPROXYMODEL_H
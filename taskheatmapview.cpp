@@ -0,0 +1,173 @@
+/**
+ * @file taskheatmapview.cpp
+ * @brief Реализация календарной тепловой карты.
+ */
+#include "taskheatmapview.h"
+#include "taskmodel.h"
+#include "tracing.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QLocale>
+#include <algorithm>
+#include <cmath>
+
+TaskHeatmapView::TaskHeatmapView(TaskModel *model, QWidget *parent)
+    : QWidget(parent), m_model(model), m_year(QDate::currentDate().year())
+{
+    setMouseTracking(true);
+    if (m_model) {
+        // Сводки уже пересчитаны моделью, достаточно перерисовать
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, [this]() { update(); });
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, [this]() { update(); });
+        connect(m_model, &QAbstractItemModel::dataChanged, this, [this]() { update(); });
+        connect(m_model, &QAbstractItemModel::modelReset, this, [this]() { update(); });
+    }
+}
+
+void TaskHeatmapView::setYear(int year)
+{
+    if (m_year != year) {
+        m_year = year;
+        update();
+    }
+}
+
+void TaskHeatmapView::setMetric(Metric metric)
+{
+    if (m_metric != metric) {
+        m_metric = metric;
+        update();
+    }
+}
+
+QSize TaskHeatmapView::sizeHint() const
+{
+    return QSize(kLeftMargin + kWeeks * 16, kTopMargin + 7 * 16);
+}
+
+int TaskHeatmapView::cellSize() const
+{
+    return std::max(4, std::min((width() - kLeftMargin) / kWeeks, (height() - kTopMargin) / 7));
+}
+
+QRect TaskHeatmapView::cellRect(const QDate &date) const
+{
+    // Неделя считается от понедельника, на которую приходится 1 января
+    const QDate firstDay(m_year, 1, 1);
+    const int week = (firstDay.dayOfWeek() - 1 + date.dayOfYear() - 1) / 7;
+    const int row = date.dayOfWeek() - 1;
+    const int cell = cellSize();
+    return QRect(kLeftMargin + week * cell, kTopMargin + row * cell, cell - 2, cell - 2);
+}
+
+QDate TaskHeatmapView::dateAt(const QPoint &pos) const
+{
+    const int cell = cellSize();
+    if (pos.x() < kLeftMargin || pos.y() < kTopMargin)
+        return QDate();
+    const int week = (pos.x() - kLeftMargin) / cell;
+    const int row = (pos.y() - kTopMargin) / cell;
+    if (week >= kWeeks || row >= 7)
+        return QDate();
+
+    const QDate firstDay(m_year, 1, 1);
+    QDate date = firstDay.addDays(week * 7 + row - (firstDay.dayOfWeek() - 1));
+    return date.year() == m_year ? date : QDate();
+}
+
+int TaskHeatmapView::metricValue(const QDate &date) const
+{
+    if (!m_model)
+        return 0;
+    TaskModel::DayStats stats = m_model->dayStats(date);
+    return m_metric == BookedMinutesMetric ? stats.bookedMinutes : stats.taskCount;
+}
+
+void TaskHeatmapView::paintEvent(QPaintEvent *event)
+{
+    TRACE_SCOPE("TaskHeatmapView::paintEvent");
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().base());
+
+    const QDate firstDay(m_year, 1, 1);
+    const int days = firstDay.daysInYear();
+
+    // Масштаб цвета — по самому загруженному дню года
+    QVector<int> values(days);
+    int maxValue = 0;
+    for (int i = 0; i < days; ++i) {
+        values[i] = metricValue(firstDay.addDays(i));
+        maxValue = std::max(maxValue, values[i]);
+    }
+
+    const QColor emptyColor(235, 237, 240);
+    const QColor fullColor(33, 110, 57);
+    for (int i = 0; i < days; ++i) {
+        const QDate date = firstDay.addDays(i);
+        const QRect rect = cellRect(date);
+        if (!rect.intersects(event->rect()))
+            continue;
+        QColor color = emptyColor;
+        if (values[i] > 0 && maxValue > 0) {
+            // Четыре ступени насыщенности, как у привычных календарей активности
+            const double level = std::ceil(4.0 * values[i] / maxValue) / 4.0;
+            color = QColor::fromRgbF(emptyColor.redF() + (fullColor.redF() - emptyColor.redF()) * level,
+                                     emptyColor.greenF() + (fullColor.greenF() - emptyColor.greenF()) * level,
+                                     emptyColor.blueF() + (fullColor.blueF() - emptyColor.blueF()) * level);
+        }
+        painter.fillRect(rect, color);
+        if (date == QDate::currentDate()) {
+            painter.setPen(QPen(Qt::black, 1));
+            painter.drawRect(rect.adjusted(0, 0, -1, -1));
+        }
+    }
+
+    // Подписи месяцев и дней недели
+    QLocale locale;
+    painter.setPen(palette().color(QPalette::WindowText));
+    for (int month = 1; month <= 12; ++month) {
+        const QRect rect = cellRect(QDate(m_year, month, 1));
+        painter.drawText(QPoint(rect.left(), kTopMargin - 6), locale.standaloneMonthName(month, QLocale::ShortFormat));
+    }
+    const int cell = cellSize();
+    for (int row : {0, 2, 4}) {
+        painter.drawText(QRect(0, kTopMargin + row * cell, kLeftMargin - 4, cell),
+                         Qt::AlignRight | Qt::AlignVCenter, locale.dayName(row + 1, QLocale::ShortFormat));
+    }
+}
+
+void TaskHeatmapView::mousePressEvent(QMouseEvent *event)
+{
+    const QDate date = dateAt(event->pos());
+    if (date.isValid() && event->button() == Qt::LeftButton) {
+        emit dateActivated(date);
+        return;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+bool TaskHeatmapView::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+        const QDate date = dateAt(helpEvent->pos());
+        if (date.isValid() && m_model) {
+            TaskModel::DayStats stats = m_model->dayStats(date);
+            QString text = QString("<b>%1</b><br>Задач: %2<br>Занято: %3 ч %4 мин")
+                               .arg(date.toString("dd.MM.yyyy"))
+                               .arg(stats.taskCount)
+                               .arg(stats.bookedMinutes / 60)
+                               .arg(stats.bookedMinutes % 60);
+            for (auto it = stats.minutesByProject.constBegin(); it != stats.minutesByProject.constEnd(); ++it)
+                text += QString("<br>%1: %2 мин").arg(it.key().toHtmlEscaped()).arg(it.value());
+            QToolTip::showText(helpEvent->globalPos(), text, this);
+        } else {
+            QToolTip::hideText();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file taskheatmapview.h
+ * @brief Календарная тепловая карта загрузки за год.
+ */
+
+#ifndef TASKHEATMAPVIEW_H
+#define TASKHEATMAPVIEW_H
+
+#include <QWidget>
+#include <QDate>
+
+class TaskModel;
+
+/**
+ * @class TaskHeatmapView
+ * @brief Год в виде сетки «недели × дни недели», цвет ячейки — загрузка дня.
+ *
+ * Значения берутся из дневных сводок TaskModel::dayStats(), которые модель
+ * поддерживает при каждом изменении, поэтому отрисовка года — это 366 поисков
+ * в хэше независимо от числа задач.
+ */
+class TaskHeatmapView : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Показатель, которым окрашиваются ячейки.
+     */
+    enum Metric {
+        TaskCountMetric = 0,
+        BookedMinutesMetric
+    };
+
+    /**
+     * @brief Конструктор TaskHeatmapView.
+     * @param model Модель задач.
+     * @param parent Родительский виджет.
+     */
+    explicit TaskHeatmapView(TaskModel *model, QWidget *parent = nullptr);
+
+    /**
+     * @brief Установить отображаемый год.
+     * @param year Год.
+     */
+    void setYear(int year);
+    int year() const { return m_year; }
+    /**
+     * @brief Установить показатель окраски.
+     * @param metric Показатель.
+     */
+    void setMetric(Metric metric);
+
+    QSize sizeHint() const override;
+
+signals:
+    /**
+     * @brief Пользователь выбрал день.
+     * @param date Дата.
+     */
+    void dateActivated(const QDate &date);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    bool event(QEvent *event) override;
+
+private:
+    static constexpr int kWeeks = 54;
+    static constexpr int kLeftMargin = 28;
+    static constexpr int kTopMargin = 20;
+
+    TaskModel *m_model;
+    int m_year;
+    Metric m_metric = TaskCountMetric;
+
+    int cellSize() const;
+    QRect cellRect(const QDate &date) const;
+    QDate dateAt(const QPoint &pos) const;
+    int metricValue(const QDate &date) const;
+};
+
+#endif // TASKHEATMAPVIEW_H
@@ -0,0 +1,292 @@
+/**
+ * @file taskhistory.cpp
+ * @brief Реализация журнала изменений задач.
+ */
+#include "taskhistory.h"
+#include "taskmodel.h"
+#include "tracing.h"
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+#include <QStandardPaths>
+#include <utility>
+
+static const char *kindNames[] = {"create", "update", "delete"};
+
+/**
+ * @brief Имя пользователя системы — автор ревизии.
+ */
+static QString currentUser()
+{
+    const QString user = qEnvironmentVariable("USER");
+    return user.isEmpty() ? qEnvironmentVariable("USERNAME") : user;
+}
+
+TaskHistory::TaskHistory(TaskModel *model, const QString &filePath, QObject *parent)
+    : QObject(parent), m_model(model), m_filePath(filePath)
+{
+    if (m_filePath.isEmpty()) {
+        const QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(path);
+        m_filePath = path + "/history.jsonl";
+    }
+    connect(m_model, &TaskModel::taskInserted, this, &TaskHistory::onTaskInserted);
+    connect(m_model, &TaskModel::taskAboutToBeRemoved, this, &TaskHistory::onTaskAboutToBeRemoved);
+    connect(m_model, &TaskModel::taskUpdated, this, &TaskHistory::onTaskUpdated);
+    // Загруженные задачи могли измениться вне журнала — перед следующей записью их надо сверить.
+    // Влитый чужой файл сверять не нужно: его изменения журналируются по одному
+    connect(m_model, &QAbstractItemModel::modelReset, this, [this]() { m_checkState = true; });
+}
+
+void TaskHistory::onTaskInserted(int row)
+{
+    const Task task = m_model->getTask(row);
+    append(task.uid(), Revision::Created, {}, TaskModel::taskToJson(task));
+}
+
+void TaskHistory::onTaskAboutToBeRemoved(int row)
+{
+    // Сама задача остаётся в корзине — в журнал идёт только факт удаления
+    append(m_model->getTask(row).uid(), Revision::Deleted, {}, {});
+}
+
+void TaskHistory::onTaskUpdated(int row, const Task &before)
+{
+    const Task task = m_model->getTask(row);
+    const TaskModel::FieldDiff diff = TaskModel::diffFields(before, task);
+    if (!diff.isEmpty())
+        append(task.uid(), Revision::Updated, diff.before, diff.after);
+}
+
+void TaskHistory::append(const QUuid &uid, Revision::Kind kind, const QJsonObject &before, const QJsonObject &after)
+{
+    TRACE_SCOPE("TaskHistory::append");
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning("Couldn't open history file.");
+        return;
+    }
+    // Модель сейчас в состоянии после всех прежних записей: удаление ещё не выполнено
+    if (m_checkState) {
+        m_checkState = false;
+        if (m_sinceCheckpoint < m_checkpointInterval
+            && !journalMatchesModel(kind == Revision::Created ? uid : QUuid()))
+            m_sinceCheckpoint = m_checkpointInterval;
+    }
+    if (m_sinceCheckpoint >= m_checkpointInterval)
+        writeCheckpoint(file.size());
+
+    QJsonObject record;
+    record["uid"] = uid.toString();
+    record["at"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    // Изменение из чужого файла записано не здесь — его автор неизвестен
+    if (m_model->isApplyingTasksFile())
+        record["source"] = "file";
+    else
+        record["user"] = currentUser();
+    record["op"] = kindNames[kind];
+    if (!before.isEmpty())
+        record["from"] = before;
+    if (!after.isEmpty())
+        record["to"] = after;
+    file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+    ++m_sinceCheckpoint;
+}
+
+void TaskHistory::writeCheckpoint(qint64 journalOffset)
+{
+    TRACE_SCOPE("TaskHistory::writeCheckpoint");
+    QFile file(checkpointsPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning("Couldn't open history checkpoints file.");
+        return;
+    }
+    const QDateTime now = QDateTime::currentDateTime();
+    QJsonArray tasks;
+    for (const Task &task : m_model->tasks())
+        tasks.append(TaskModel::taskToJson(task));
+    QJsonObject checkpoint;
+    checkpoint["at"] = now.toString(Qt::ISODateWithMs);
+    checkpoint["tasks"] = tasks;
+
+    const qint64 offset = file.size();
+    file.write(QJsonDocument(checkpoint).toJson(QJsonDocument::Compact) + '\n');
+    m_sinceCheckpoint = 0;
+
+    QFile index(indexPath());
+    if (index.open(QIODevice::WriteOnly | QIODevice::Append))
+        index.write(now.toString(Qt::ISODateWithMs).toUtf8() + ' ' + QByteArray::number(offset) + ' '
+                    + QByteArray::number(journalOffset) + '\n');
+}
+
+bool TaskHistory::journalMatchesModel(const QUuid &inserted) const
+{
+    TRACE_SCOPE("TaskHistory::journalMatchesModel");
+    const QVector<Task> replayed = tasksAsOf(QDateTime::currentDateTime());
+    if (replayed.size() != m_model->rowCount() - (inserted.isNull() ? 0 : 1))
+        return false;
+    QHash<QUuid, QJsonObject> journal;
+    journal.reserve(replayed.size());
+    for (const Task &task : replayed)
+        journal.insert(task.uid(), TaskModel::taskToJson(task));
+    for (const Task &task : m_model->tasks()) {
+        if (task.uid() != inserted && journal.value(task.uid()) != TaskModel::taskToJson(task))
+            return false;
+    }
+    return true;
+}
+
+QVector<Task> TaskHistory::tasksAsOf(const QDateTime &at) const
+{
+    TRACE_SCOPE("TaskHistory::tasksAsOf");
+    // Ближайшая контрольная точка не позже at — по индексу, не читая журнал.
+    // Строка индекса: время, смещение точки в файле точек, смещение журнала после неё.
+    // В старых журналах точки лежали в самом журнале, и в строке два поля
+    qint64 checkpointOffset = -1;
+    qint64 offset = 0;
+    QFile index(indexPath());
+    if (index.open(QIODevice::ReadOnly)) {
+        while (!index.atEnd()) {
+            const QList<QByteArray> parts = index.readLine().trimmed().split(' ');
+            if (parts.size() != 2 && parts.size() != 3)
+                continue;
+            if (QDateTime::fromString(QString::fromUtf8(parts[0]), Qt::ISODateWithMs) > at)
+                break;
+            checkpointOffset = parts.size() == 3 ? parts[1].toLongLong() : -1;
+            offset = parts.last().toLongLong();
+        }
+    }
+
+    QHash<QUuid, QJsonObject> state;
+    QVector<QUuid> order; // порядок появления задач, как в списке
+    auto restoreCheckpoint = [&state, &order](const QJsonArray &tasks) {
+        // Точка заменяет всё проигранное до неё
+        state.clear();
+        order.clear();
+        for (const QJsonValue &value : tasks) {
+            const QUuid uid(value.toObject()["uid"].toString());
+            state.insert(uid, value.toObject());
+            order.append(uid);
+        }
+    };
+    if (checkpointOffset >= 0) {
+        QFile checkpoints(checkpointsPath());
+        if (!checkpoints.open(QIODevice::ReadOnly) || !checkpoints.seek(checkpointOffset))
+            return {};
+        restoreCheckpoint(QJsonDocument::fromJson(checkpoints.readLine()).object()["tasks"].toArray());
+    }
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(offset))
+        return {};
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        const QJsonObject record = QJsonDocument::fromJson(line).object();
+        if (QDateTime::fromString(record["at"].toString(), Qt::ISODateWithMs) > at)
+            break;
+        const QString op = record["op"].toString();
+        if (op == "checkpoint") {
+            // Точка старого формата (если индекс потерян, их может быть несколько)
+            restoreCheckpoint(record["tasks"].toArray());
+        } else if (op == kindNames[Revision::Created]) {
+            const QUuid uid(record["uid"].toString());
+            if (!state.contains(uid))
+                order.append(uid);
+            state.insert(uid, record["to"].toObject());
+        } else if (op == kindNames[Revision::Deleted]) {
+            state.remove(QUuid(record["uid"].toString()));
+        } else {
+            const QJsonObject before = record["from"].toObject();
+            const QUuid uid(record["uid"].toString());
+            const QUuid oldUid = before.contains("uid") ? QUuid(before["uid"].toString()) : uid;
+            auto it = state.find(oldUid);
+            if (it == state.end())
+                continue;
+            QJsonObject object = it.value();
+            const QJsonObject after = record["to"].toObject();
+            for (auto field = after.constBegin(); field != after.constEnd(); ++field) {
+                if (field.value().isNull())
+                    object.remove(field.key());
+                else
+                    object.insert(field.key(), field.value());
+            }
+            if (oldUid != uid) {
+                state.erase(it);
+                order.append(uid);
+            }
+            state.insert(uid, object);
+        }
+    }
+
+    QVector<Task> result;
+    result.reserve(state.size());
+    QSet<QUuid> seen;
+    for (const QUuid &uid : std::as_const(order)) {
+        const auto it = state.constFind(uid);
+        if (it != state.constEnd() && !seen.contains(uid)) {
+            seen.insert(uid);
+            result.append(TaskModel::taskFromJson(it.value()));
+        }
+    }
+    return result;
+}
+
+QVector<TaskHistory::Revision> TaskHistory::revisions(const QUuid &uid) const
+{
+    TRACE_SCOPE("TaskHistory::revisions");
+    QVector<Revision> result;
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+
+    // Разбираются только строки с нужным UID. Контрольные точки старого формата
+    // узнаются по началу строки, не просматривая весь снимок списка задач
+    const QByteArray needle = uid.toString().toUtf8();
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.left(64).contains("\"op\":\"checkpoint\"") || !line.contains(needle))
+            continue;
+        const QJsonObject record = QJsonDocument::fromJson(line).object();
+        if (QUuid(record["uid"].toString()) != uid)
+            continue;
+        Revision revision;
+        const QString op = record["op"].toString();
+        revision.kind = op == kindNames[Revision::Created] ? Revision::Created
+                      : op == kindNames[Revision::Deleted] ? Revision::Deleted
+                                                           : Revision::Updated;
+        revision.at = QDateTime::fromString(record["at"].toString(), Qt::ISODateWithMs);
+        revision.user = record["user"].toString();
+        revision.fromFile = record["source"].toString() == "file";
+        revision.before = record["from"].toObject();
+        revision.after = record["to"].toObject();
+        result.append(std::move(revision));
+    }
+    return result;
+}
+
+QString TaskHistory::fieldTitle(const QString &key)
+{
+    static const QHash<QString, QString> titles = {
+        {"uid", "Идентификатор"},
+        {"title", "Название"},
+        {"description", "Описание"},
+        {"projectType", "Проект"},
+        {"status", "Статус"},
+        {"priority", "Приоритет"},
+        {"estimatedMinutes", "Оценка, мин"},
+        {"isProjectTask", "Проектная задача"},
+        {"wasModified", "Изменена"},
+        {"creationDateTime", "Создана"},
+        {"startDateTime", "Начало"},
+        {"endDateTime", "Окончание"},
+        {"parentUid", "Родитель"},
+        {"tags", "Теги"},
+        {"dependsOn", "Зависит от"},
+        {"recurrence", "Повторение"},
+        {"stamps", "Отметки изменений"},
+    };
+    return titles.value(key, key);
+}
@@ -0,0 +1,119 @@
+/**
+ * @file taskhistory.h
+ * @brief История изменений задач в отдельном файле только для дописывания.
+ */
+
+#ifndef TASKHISTORY_H
+#define TASKHISTORY_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QString>
+#include <QUuid>
+#include <QVector>
+
+class TaskModel;
+class Task;
+
+/**
+ * @class TaskHistory
+ * @brief Журнал ревизий задач: кто, когда и какие поля изменил.
+ *
+ * Каждое изменение TaskModel дописывается в конец файла одной строкой JSON.
+ * Для правки хранятся только изменившиеся поля JSON-представления задачи
+ * (TaskModel::taskToJson) — старые и новые значения; полная запись пишется
+ * лишь при создании. В памяти журнал не держится: ревизии задачи читаются
+ * из файла только по запросу (revisions), поэтому загрузка задач и память
+ * приложения от размера истории не зависят.
+ *
+ * Каждые CheckpointInterval записей в отдельный файл рядом с журналом пишется
+ * контрольная точка — полный список задач; её время, смещение и смещение
+ * журнала в этот момент дописываются в маленький индекс. В самом журнале
+ * остаются только ревизии, и revisions не читает снимков списка задач.
+ * Состояние на момент в прошлом (tasksAsOf) восстанавливается от ближайшей
+ * более ранней точки проигрыванием не более CheckpointInterval записей.
+ *
+ * Изменения, влитые из чужого файла задач (TaskModel::applyTasksFile), тоже
+ * журналируются — с пометкой fromFile, ведь их автор неизвестен. Загруженный
+ * заново список задач сверяется с журналом перед первой записью, и точка
+ * пишется, только если он с журналом расходится.
+ */
+class TaskHistory : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int CheckpointInterval = 500;
+
+    /**
+     * @brief Одна ревизия задачи.
+     */
+    struct Revision {
+        enum Kind { Created, Updated, Deleted };
+        Kind kind = Updated;
+        QDateTime at;
+        QString user;
+        QJsonObject before; ///< Для Updated — старые значения изменившихся полей; null — поля не было
+        QJsonObject after;  ///< Новые значения; для Created — вся задача
+        bool fromFile = false; ///< Влито из файла другого экземпляра или синхронизации; user не заполнен
+    };
+
+    /**
+     * @brief Конструктор TaskHistory.
+     * @param model Модель, изменения которой записываются.
+     * @param filePath Файл журнала; пустой путь — history.jsonl рядом с tasks.json.
+     * @param parent Родительский объект.
+     */
+    explicit TaskHistory(TaskModel *model, const QString &filePath = QString(), QObject *parent = nullptr);
+
+    QString filePath() const { return m_filePath; }
+
+    /**
+     * @brief Ревизии задачи от старых к новым; читает файл журнала.
+     */
+    QVector<Revision> revisions(const QUuid &uid) const;
+
+    /**
+     * @brief Задачи в том виде, в каком они были в момент at (только чтение).
+     *
+     * Без контрольной точки раньше at журнал проигрывается с начала, и задачи,
+     * созданные до появления журнала, в результат не попадают.
+     */
+    QVector<Task> tasksAsOf(const QDateTime &at) const;
+    /**
+     * @brief Изменить шаг контрольных точек (для проверок).
+     */
+    void setCheckpointInterval(int records) { m_checkpointInterval = records; }
+
+    /**
+     * @brief Название поля задачи для показа в истории.
+     * @param key Ключ JSON-представления задачи.
+     */
+    static QString fieldTitle(const QString &key);
+
+private:
+    TaskModel *m_model;
+    QString m_filePath;
+    int m_checkpointInterval = CheckpointInterval;
+    int m_sinceCheckpoint = 0; // записей после последней контрольной точки
+    bool m_checkState = true;  // список задач загружен заново — сверить с журналом перед записью
+
+    void onTaskInserted(int row);
+    void onTaskAboutToBeRemoved(int row);
+    void onTaskUpdated(int row, const Task &before);
+    void append(const QUuid &uid, Revision::Kind kind, const QJsonObject &before, const QJsonObject &after);
+    /**
+     * @brief Записать контрольную точку с текущим состоянием модели и добавить её в индекс.
+     * @param journalOffset Смещение в журнале, с которого идут записи после точки.
+     */
+    void writeCheckpoint(qint64 journalOffset);
+    /**
+     * @brief Совпадает ли текущее состояние модели с проигранным журналом.
+     * @param inserted Только что добавленная задача — её в журнале ещё нет.
+     */
+    bool journalMatchesModel(const QUuid &inserted) const;
+    QString indexPath() const { return m_filePath + ".idx"; }
+    QString checkpointsPath() const { return m_filePath + ".checkpoints"; }
+};
+
+#endif // TASKHISTORY_H
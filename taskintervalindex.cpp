@@ -0,0 +1,96 @@
+/**
+ * @file taskintervalindex.cpp
+ * @brief Реализация индекса интервалов задач.
+ */
+#include "taskintervalindex.h"
+#include <algorithm>
+#include <limits>
+
+void TaskIntervalIndex::insert(const QUuid &uid, const QDateTime &start, const QDateTime &end)
+{
+    Interval interval;
+    interval.startMs = start.toMSecsSinceEpoch();
+    interval.endMs = end.toMSecsSinceEpoch();
+    interval.uid = uid;
+    auto it = std::upper_bound(m_intervals.begin(), m_intervals.end(), interval.startMs,
+                               [](qint64 value, const Interval &item) { return value < item.startMs; });
+    m_intervals.insert(it, interval);
+    m_prefixDirty = true;
+}
+
+void TaskIntervalIndex::remove(const QUuid &uid, const QDateTime &start, const QDateTime &end)
+{
+    const qint64 startMs = start.toMSecsSinceEpoch();
+    const qint64 endMs = end.toMSecsSinceEpoch();
+    auto it = std::lower_bound(m_intervals.begin(), m_intervals.end(), startMs,
+                               [](const Interval &item, qint64 value) { return item.startMs < value; });
+    for (; it != m_intervals.end() && it->startMs == startMs; ++it) {
+        if (it->uid == uid && it->endMs == endMs) {
+            m_intervals.erase(it);
+            m_prefixDirty = true;
+            return;
+        }
+    }
+}
+
+void TaskIntervalIndex::clear()
+{
+    m_intervals.clear();
+    m_prefixMaxEnd.clear();
+    m_prefixDirty = false;
+}
+
+void TaskIntervalIndex::ensurePrefix() const
+{
+    if (!m_prefixDirty && m_prefixMaxEnd.size() == m_intervals.size())
+        return;
+    m_prefixMaxEnd.resize(m_intervals.size());
+    qint64 maxEnd = std::numeric_limits<qint64>::min();
+    for (int i = 0; i < m_intervals.size(); ++i) {
+        maxEnd = std::max(maxEnd, m_intervals[i].endMs);
+        m_prefixMaxEnd[i] = maxEnd;
+    }
+    m_prefixDirty = false;
+}
+
+QVector<TaskIntervalIndex::Interval> TaskIntervalIndex::overlappingMs(qint64 startMs, qint64 endMs, const QUuid &exclude) const
+{
+    QVector<Interval> result;
+    if (m_intervals.isEmpty() || endMs <= startMs)
+        return result;
+    ensurePrefix();
+
+    // До first ни один интервал не заканчивается позже startMs
+    const int first = static_cast<int>(std::upper_bound(m_prefixMaxEnd.begin(), m_prefixMaxEnd.end(), startMs)
+                                       - m_prefixMaxEnd.begin());
+    // Начиная с last все интервалы начинаются не раньше endMs
+    const int last = static_cast<int>(std::lower_bound(m_intervals.begin(), m_intervals.end(), endMs,
+                                                       [](const Interval &item, qint64 value) { return item.startMs < value; })
+                                      - m_intervals.begin());
+    for (int i = first; i < last; ++i) {
+        const Interval &interval = m_intervals[i];
+        if (interval.endMs > startMs && interval.uid != exclude)
+            result.append(interval);
+    }
+    return result;
+}
+
+QVector<TaskIntervalIndex::Interval> TaskIntervalIndex::overlapping(const QDateTime &start, const QDateTime &end, const QUuid &exclude) const
+{
+    return overlappingMs(start.toMSecsSinceEpoch(), end.toMSecsSinceEpoch(), exclude);
+}
+
+QVector<QPair<qint64, qint64>> TaskIntervalIndex::busy(qint64 fromMs, qint64 toMs) const
+{
+    QVector<QPair<qint64, qint64>> merged;
+    const QVector<Interval> hits = overlappingMs(fromMs, toMs, QUuid());
+    for (const Interval &interval : hits) {
+        qint64 start = std::max(interval.startMs, fromMs);
+        qint64 end = std::min(interval.endMs, toMs);
+        if (!merged.isEmpty() && start <= merged.last().second)
+            merged.last().second = std::max(merged.last().second, end);
+        else
+            merged.append(qMakePair(start, end));
+    }
+    return merged;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file taskintervalindex.h
+ * @brief Индекс интервалов задач по времени для поиска пересечений и свободного времени.
+ */
+
+#ifndef TASKINTERVALINDEX_H
+#define TASKINTERVALINDEX_H
+
+#include <QVector>
+#include <QUuid>
+#include <QDateTime>
+#include <QPair>
+
+/**
+ * @struct FreeSlot
+ * @brief Свободный промежуток в расписании.
+ */
+struct FreeSlot {
+    QDateTime start;
+    QDateTime end;
+};
+
+/**
+ * @class TaskIntervalIndex
+ * @brief Интервалы [начало, конец) задач, отсортированные по началу.
+ *
+ * Рядом хранится префиксный максимум концов: он монотонен, поэтому первый
+ * интервал, который может пересечь запрос, находится двоичным поиском, а
+ * последний — двоичным поиском по началам. Вставка и удаление — O(n) сдвига
+ * памяти, что для десятков тысяч задач быстрее любых деревьев на узлах.
+ */
+class TaskIntervalIndex
+{
+public:
+    /**
+     * @brief Интервал задачи в миллисекундах от эпохи.
+     */
+    struct Interval {
+        qint64 startMs = 0;
+        qint64 endMs = 0;
+        QUuid uid;
+    };
+
+    /**
+     * @brief Добавить интервал задачи.
+     * @param uid Идентификатор задачи.
+     * @param start Начало.
+     * @param end Конец (должен быть позже начала).
+     */
+    void insert(const QUuid &uid, const QDateTime &start, const QDateTime &end);
+    /**
+     * @brief Удалить интервал задачи (те же значения, что при вставке).
+     */
+    void remove(const QUuid &uid, const QDateTime &start, const QDateTime &end);
+    /**
+     * @brief Очистить индекс.
+     */
+    void clear();
+    /**
+     * @brief Число интервалов.
+     */
+    int size() const { return m_intervals.size(); }
+
+    /**
+     * @brief Интервалы, пересекающие [start, end), по возрастанию начала.
+     * @param start Начало запроса.
+     * @param end Конец запроса.
+     * @param exclude Задача, которую не нужно возвращать (например, редактируемая).
+     * @return Пересекающиеся интервалы.
+     */
+    QVector<Interval> overlapping(const QDateTime &start, const QDateTime &end, const QUuid &exclude = QUuid()) const;
+    /**
+     * @brief Объединённые занятые промежутки внутри [from, to), обрезанные по его границам.
+     * @return Пары (начало, конец) в миллисекундах, без пересечений, по возрастанию.
+     */
+    QVector<QPair<qint64, qint64>> busy(qint64 fromMs, qint64 toMs) const;
+
+private:
+    QVector<Interval> m_intervals;           // по возрастанию startMs
+    mutable QVector<qint64> m_prefixMaxEnd;  // max(endMs) по префиксу m_intervals
+    mutable bool m_prefixDirty = false;
+
+    void ensurePrefix() const;
+    QVector<Interval> overlappingMs(qint64 startMs, qint64 endMs, const QUuid &exclude) const;
+};
+
+#endif // TASKINTERVALINDEX_H
@@ -9,6 +9,7 @@
 #include <QIcon>
 #include <QMessageBox>
 #include "customdatamanager.h"
+#include "tracing.h"
 #include <QUuid> // Added for QUuid
 #include <QApplication>
 #include <QStyle>
@@ -18,6 +19,11 @@
 #include <QJsonObject>
 #include <QStandardPaths>
 #include <QDir>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include "lockedsavefile.h"
+#include "tasksync.h"
+#include <algorithm>
 
 TaskModel::TaskModel(QObject *parent, CustomDataManager *dataManager)
     : QAbstractListModel(parent), m_dataManager(dataManager)
@@ -80,6 +86,31 @@ QVariant TaskModel::data(const QModelIndex &index, int role) const {
     if (role == FullTaskRole) {
         return QVariant::fromValue(task);
     }
+    // Лёгкий ключ задачи без копирования всего Task (кэши делегата и оверлея)
+    if (role == UidRole) {
+        return task.uid();
+    }
+    // Расчётные значения графа зависимостей
+    if (role == EarliestStartRole) {
+        return m_dependencies.contains(task.uid()) ? QDateTime::fromMSecsSinceEpoch(m_dependencies.earliestStartMs(task.uid()))
+                                                   : task.startDateTime();
+    }
+    if (role == SlackMinutesRole)
+        return m_dependencies.contains(task.uid()) ? QVariant(m_dependencies.slackMs(task.uid()) / 60000) : QVariant();
+    if (role == CriticalPathRole)
+        return m_dependencies.isCritical(task.uid());
+    if (role == DependencyConflictRole)
+        return m_dependencies.hasConflict(task.uid());
+    if (role == Qt::ToolTipRole && index.column() == TitleColumn && m_dependencies.contains(task.uid())) {
+        QString tip = QString("Раннее начало: %1, резерв: %2 мин")
+                          .arg(QDateTime::fromMSecsSinceEpoch(m_dependencies.earliestStartMs(task.uid())).toString("dd.MM.yyyy HH:mm"))
+                          .arg(m_dependencies.slackMs(task.uid()) / 60000);
+        if (m_dependencies.isCritical(task.uid()))
+            tip += "\nНа критическом пути";
+        if (m_dependencies.hasConflict(task.uid()))
+            tip += "\nНачинается раньше окончания предшествующей задачи";
+        return tip;
+    }
     // Для сортировки и других ролей можно добавить дополнительные case
     return QVariant();
 }
@@ -104,6 +135,7 @@ bool TaskModel::setData(const QModelIndex &index, const QVariant &value, int rol
         return false;
 
     Task &task = m_tasks[index.row()];
+    const Task before = task;
 
     switch (role) {
     case TitleRole:
@@ -130,7 +162,18 @@ bool TaskModel::setData(const QModelIndex &index, const QVariant &value, int rol
         return false;
     }
 
+    accountTask(before, -1);
+    accountTask(task, +1);
+    relinkTask(before, task);
+    retagRow(index.row(), before.tagIds(), task.tagIds());
+    if (before.uid() != task.uid())
+        m_dependencies.removeNode(before.uid());
+    syncDependencies(before.uid() == task.uid() ? before.dependencies() : QVector<QUuid>(), index.row());
+    renameUid(before.uid(), task.uid(), index.row());
     emit dataChanged(index, index, {role});
+    emitDependencyChanges();
+    stampFields(index.row(), before);
+    emit taskUpdated(index.row(), before);
     return true;
 }
 
@@ -150,41 +193,105 @@ QHash<int, QByteArray> TaskModel::roleNames() const {
     roles[EndDateRole] = "endDate";
     roles[CreationDateRole] = "creationDate";
     roles[FullTaskRole] = "fullTask";
+    roles[UidRole] = "uid";
+    roles[EarliestStartRole] = "earliestStart";
+    roles[SlackMinutesRole] = "slackMinutes";
+    roles[CriticalPathRole] = "criticalPath";
+    roles[DependencyConflictRole] = "dependencyConflict";
     return roles;
 }
 
 void TaskModel::addTask(const Task& task) {
-    // Удалено ограничение на лимит пересечений по времени
-    qDebug() << "Adding task to model:"
+    // Пересечения по времени не запрещаются — о них предупреждает TaskDialog
+    qCDebug(lcTaskHotPath) << "Adding task to model:"
              << "title:" << task.title()
              << "isProjectTask:" << task.isProjectTask()
              << "projectType:" << task.projectType()
              << "start:" << task.startDateTime()
              << "end:" << task.endDateTime();
 
+    // Задача, возвращённая отменой удаления, больше не лежит в корзине
+    const bool fromTrash = m_trash.remove(task.uid()) > 0;
+
     beginInsertRows(QModelIndex(), m_tasks.size(), m_tasks.size());
     m_tasks.append(task);
+    accountTask(task, +1);
+    m_rowByUid.insert(task.uid(), m_tasks.size() - 1);
+    linkTask(task);
+    retagRow(m_tasks.size() - 1, QVector<int>(), task.tagIds());
+    ++m_tagRevision; // новая строка меняет и результат фильтра «без тега»
+    syncDependencies(QVector<QUuid>(), m_tasks.size() - 1);
     endInsertRows();
+    emitDependencyChanges();
+    emit taskInserted(m_tasks.size() - 1);
+    if (fromTrash)
+        emit trashChanged();
 
-    qDebug() << "Total tasks in model:" << m_tasks.size();
+    qCDebug(lcTaskHotPath) << "Total tasks in model:" << m_tasks.size();
 }
 
-void TaskModel::removeTask(int index) {
+void TaskModel::removeTask(int index, bool toTrash) {
     if (index < 0 || index >= m_tasks.size()) return;
 
-    qDebug() << "Removing task at index" << index << ":" << m_tasks[index].title();
+    qCDebug(lcTaskHotPath) << "Removing task at index" << index << ":" << m_tasks[index].title();
+
+    // Подзадачи не удаляются, а поднимаются на уровень удаляемой задачи
+    const QUuid parentUid = parentOf(m_tasks[index].uid());
+    const QVector<QUuid> children = childUids(m_tasks[index].uid());
+    for (const QUuid &child : children) {
+        const int row = findTask(child);
+        Task task = m_tasks[row];
+        task.setParentUid(parentUid);
+        updateTask(row, task);
+    }
+
+    // Последователи перестают ссылаться на удаляемую задачу
+    const QUuid uid = m_tasks[index].uid();
+    const QVector<QUuid> successors = m_dependencies.successors(uid);
+    QVector<Task> successorsBefore;
+    for (const QUuid &successor : successors) {
+        const int row = findTask(successor);
+        successorsBefore.append(m_tasks[row]);
+        QVector<QUuid> dependencies = m_tasks[row].dependencies();
+        dependencies.removeAll(uid);
+        m_tasks[row].setDependencies(dependencies);
+    }
+    m_dependencies.removeNode(uid);
+    emitDependencyChanges();
+    for (const Task &before : std::as_const(successorsBefore)) {
+        const int row = findTask(before.uid());
+        stampFields(row, before);
+        emit taskUpdated(row, before);
+    }
+    emit taskAboutToBeRemoved(index);
 
     beginRemoveRows(QModelIndex(), index, index);
+    if (toTrash)
+        m_trash.insert(uid, DeletedTask{m_tasks[index], QDateTime::currentDateTime()});
+    accountTask(m_tasks[index], -1);
+    unlinkTask(m_tasks[index]);
+    m_progress.remove(m_tasks[index].uid());
+    m_rowByUid.remove(m_tasks[index].uid());
     m_tasks.removeAt(index);
+    reindexRows(index);
+    // Номера строк после удалённой сдвигаются на единицу и в картах тегов
+    for (auto it = m_rowsByTag.begin(); it != m_rowsByTag.end();) {
+        it->removeRow(index);
+        it = it->any() ? std::next(it) : m_rowsByTag.erase(it);
+    }
+    ++m_tagRevision;
     endRemoveRows();
+    emitDependencyChanges();
+    if (toTrash)
+        emit trashChanged();
 
-    qDebug() << "Total tasks in model:" << m_tasks.size();
+    qCDebug(lcTaskHotPath) << "Total tasks in model:" << m_tasks.size();
 }
 
 void TaskModel::updateTask(int index, const Task& task) {
     if (index < 0 || index >= m_tasks.size()) return;
 
-    qDebug() << "Updating task at index" << index
+    qCDebug(lcTaskHotPath) << "Updating task at index" << index
              << "old title:" << m_tasks[index].title()
              << "new title:" << task.title()
              << "isProjectTask:" << task.isProjectTask()
@@ -192,8 +299,20 @@ void TaskModel::updateTask(int index, const Task& task) {
              << "start:" << task.startDateTime()
              << "end:" << task.endDateTime();
 
+    accountTask(m_tasks[index], -1);
+    const Task before = m_tasks[index];
     m_tasks[index] = task;
+    accountTask(task, +1);
+    relinkTask(before, task);
+    retagRow(index, before.tagIds(), task.tagIds());
+    if (before.uid() != task.uid())
+        m_dependencies.removeNode(before.uid());
+    syncDependencies(before.uid() == task.uid() ? before.dependencies() : QVector<QUuid>(), index);
+    renameUid(before.uid(), task.uid(), index);
     emit dataChanged(createIndex(index, 0), createIndex(index, 0));
+    emitDependencyChanges();
+    stampFields(index, before);
+    emit taskUpdated(index, before);
 }
 
 Task TaskModel::getTask(int index) const {
@@ -210,21 +329,371 @@ void TaskModel::clear() {
     if (m_tasks.isEmpty())
         return;
 
-    qDebug() << "Clearing all tasks from model. Total tasks:" << m_tasks.size();
+    qCDebug(lcTaskHotPath) << "Clearing all tasks from model. Total tasks:" << m_tasks.size();
 
     beginRemoveRows(QModelIndex(), 0, m_tasks.size() - 1);
     m_tasks.clear();
+    m_dayStats.clear();
+    m_intervalIndex.clear();
+    m_rowByUid.clear();
+    m_seriesUids.clear();
+    m_childUids.clear();
+    m_parentByUid.clear();
+    m_progress.clear();
+    m_dependencies.clear();
+    m_rowsByTag.clear();
+    ++m_tagRevision;
     endRemoveRows();
 }
 
+void TaskModel::setTasks(const QVector<Task> &tasks)
+{
+    beginResetModel();
+    m_tasks = tasks;
+    rebuildIndexes();
+    endResetModel();
+}
+
 int TaskModel::findTask(const QUuid &uid) const
 {
-    for (int i = 0; i < m_tasks.size(); ++i) {
-        if (m_tasks[i].uid() == uid) {
-            return i;
+    return m_rowByUid.value(uid, -1);
+}
+
+QVector<TaskModel::DeletedTask> TaskModel::deletedTasks() const
+{
+    QVector<DeletedTask> result;
+    result.reserve(m_trash.size());
+    for (const DeletedTask &deleted : m_trash)
+        result.append(deleted);
+    std::sort(result.begin(), result.end(), [](const DeletedTask &a, const DeletedTask &b) {
+        return a.deletedAt > b.deletedAt;
+    });
+    return result;
+}
+
+int TaskModel::restoreTask(const QUuid &uid)
+{
+    const auto it = m_trash.constFind(uid);
+    if (it == m_trash.constEnd() || m_rowByUid.contains(uid))
+        return -1;
+    m_restoring = true;
+    addTask(it->task); // убирает запись из корзины
+    m_restoring = false;
+    return m_tasks.size() - 1;
+}
+
+void TaskModel::deletePermanently(const QUuid &uid)
+{
+    if (m_trash.remove(uid) > 0)
+        emit trashChanged();
+}
+
+int TaskModel::purgeTrash(const QDateTime &deletedBefore)
+{
+    TRACE_SCOPE("TaskModel::purgeTrash");
+    int purged = 0;
+    for (auto it = m_trash.begin(); it != m_trash.end();) {
+        if (it->deletedAt < deletedBefore) {
+            it = m_trash.erase(it);
+            ++purged;
+        } else {
+            ++it;
+        }
+    }
+    if (purged > 0)
+        emit trashChanged();
+    return purged;
+}
+
+TaskModel::FieldDiff TaskModel::diffFields(const Task &before, const Task &after)
+{
+    const QJsonObject oldObject = taskToJson(before);
+    const QJsonObject newObject = taskToJson(after);
+    QSet<QString> keys;
+    for (auto it = oldObject.constBegin(); it != oldObject.constEnd(); ++it)
+        keys.insert(it.key());
+    for (auto it = newObject.constBegin(); it != newObject.constEnd(); ++it)
+        keys.insert(it.key());
+    keys.remove("stamps");
+
+    FieldDiff diff;
+    for (const QString &key : std::as_const(keys)) {
+        const QJsonValue oldValue = oldObject.value(key);
+        const QJsonValue newValue = newObject.value(key);
+        if (oldValue == newValue)
+            continue;
+        diff.before.insert(key, oldValue.isUndefined() ? QJsonValue() : oldValue);
+        diff.after.insert(key, newValue.isUndefined() ? QJsonValue() : newValue);
+    }
+    return diff;
+}
+
+void TaskModel::applyFields(QJsonObject &target, const QJsonObject &fields)
+{
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        if (it.value().isNull())
+            target.remove(it.key());
+        else
+            target.insert(it.key(), it.value());
+    }
+}
+
+int TaskModel::applyEdit(const Task &original, const Task &edited)
+{
+    const int row = findTask(original.uid());
+    if (row < 0)
+        return -1;
+    const FieldDiff diff = diffFields(original, edited);
+    if (diff.isEmpty())
+        return row;
+    QJsonObject object = taskToJson(m_tasks[row]);
+    applyFields(object, diff.after);
+    updateTask(row, taskFromJson(object));
+    return row;
+}
+
+void TaskModel::stampFields(int row, const Task &before)
+{
+    if (m_applyingFile || row < 0)
+        return;
+    Task &task = m_tasks[row];
+
+    // Копия задачи из диалога или шага отмены может нести старые отметки — они не откатываются
+    QHash<QString, qint64> stamps = task.fieldStamps();
+    const QHash<QString, qint64> previous = before.fieldStamps();
+    for (auto it = previous.constBegin(); it != previous.constEnd(); ++it)
+        stamps.insert(it.key(), std::max(it.value(), stamps.value(it.key())));
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 created = before.creationDateTime().toMSecsSinceEpoch();
+    const QJsonObject changed = diffFields(before, task).after;
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it)
+        stamps.insert(it.key(), std::max(now, stamps.value(it.key(), created) + 1));
+    task.setFieldStamps(stamps);
+}
+
+void TaskModel::reindexRows(int from)
+{
+    // С конца, чтобы при повторяющемся UID, как и раньше, находилась первая строка
+    for (int i = m_tasks.size() - 1; i >= from; --i)
+        m_rowByUid[m_tasks[i].uid()] = i;
+}
+
+void TaskModel::renameUid(const QUuid &oldUid, const QUuid &newUid, int row)
+{
+    if (oldUid == newUid)
+        return;
+    m_rowByUid.remove(oldUid);
+    m_rowByUid.insert(newUid, row);
+}
+
+static bool isDone(const Task &task)
+{
+    return task.status() == "Выполнено";
+}
+
+int TaskModel::childCount(const QUuid &parentUid) const
+{
+    const auto it = m_childUids.constFind(parentUid);
+    return it == m_childUids.constEnd() ? 0 : it->size();
+}
+
+bool TaskModel::isAncestor(const QUuid &ancestor, const QUuid &uid) const
+{
+    if (ancestor.isNull())
+        return false;
+    for (QUuid current = parentOf(uid); !current.isNull(); current = parentOf(current)) {
+        if (current == ancestor)
+            return true;
+    }
+    return false;
+}
+
+void TaskModel::linkTask(const Task &task)
+{
+    const QUuid uid = task.uid();
+    QUuid parent = task.parentUid();
+    if (parent == uid || !m_rowByUid.contains(parent) || isAncestor(uid, parent))
+        parent = QUuid();
+
+    m_parentByUid.insert(uid, parent);
+    m_childUids[parent].append(uid);
+    const Progress subtree = m_progress.value(uid);
+    adjustProgress(parent, subtree.done + (isDone(task) ? 1 : 0), subtree.total + 1);
+}
+
+void TaskModel::unlinkTask(const Task &task)
+{
+    const QUuid uid = task.uid();
+    const auto it = m_parentByUid.find(uid);
+    if (it == m_parentByUid.end())
+        return;
+    const QUuid parent = it.value();
+    m_parentByUid.erase(it);
+
+    QVector<QUuid> &siblings = m_childUids[parent];
+    siblings.removeOne(uid);
+    if (siblings.isEmpty())
+        m_childUids.remove(parent);
+    const Progress subtree = m_progress.value(uid);
+    adjustProgress(parent, -(subtree.done + (isDone(task) ? 1 : 0)), -(subtree.total + 1));
+}
+
+void TaskModel::relinkTask(const Task &before, const Task &after)
+{
+    if (before.uid() == after.uid() && before.parentUid() == after.parentUid()) {
+        // Частый случай — правка без смены места в дереве: меняется только число выполненных
+        const int doneDelta = (isDone(after) ? 1 : 0) - (isDone(before) ? 1 : 0);
+        if (doneDelta != 0)
+            adjustProgress(parentOf(after.uid()), doneDelta, 0);
+        return;
+    }
+
+    unlinkTask(before);
+    if (before.uid() != after.uid()) {
+        // Подзадачи и прогресс переходят к новому UID
+        const QVector<QUuid> children = m_childUids.take(before.uid());
+        for (const QUuid &child : children)
+            m_parentByUid[child] = after.uid();
+        if (!children.isEmpty())
+            m_childUids.insert(after.uid(), children);
+        if (m_progress.contains(before.uid()))
+            m_progress.insert(after.uid(), m_progress.take(before.uid()));
+    }
+    linkTask(after);
+}
+
+void TaskModel::adjustProgress(const QUuid &from, int doneDelta, int totalDelta)
+{
+    for (QUuid current = from; !current.isNull(); current = parentOf(current)) {
+        Progress &progress = m_progress[current];
+        progress.done += doneDelta;
+        progress.total += totalDelta;
+        if (progress.total <= 0)
+            m_progress.remove(current);
+    }
+}
+
+/**
+ * @brief Интервал задачи для графа зависимостей: задача без времени занимает оценку длительности с начала дня срока.
+ */
+static QPair<qint64, qint64> dependencyTiming(const Task &task)
+{
+    const qint64 start = task.startDateTime().toMSecsSinceEpoch();
+    if (task.isProjectTask() && task.endDateTime() > task.startDateTime())
+        return qMakePair(start, task.endDateTime().toMSecsSinceEpoch());
+    return qMakePair(start, start + static_cast<qint64>(task.estimatedMinutes()) * 60 * 1000);
+}
+
+bool TaskModel::linkDependency(const QUuid &predecessor, int row)
+{
+    const int predecessorRow = findTask(predecessor);
+    if (predecessorRow < 0)
+        return false;
+    const QPair<qint64, qint64> predecessorTiming = dependencyTiming(m_tasks[predecessorRow]);
+    const QPair<qint64, qint64> taskTiming = dependencyTiming(m_tasks[row]);
+    m_dependencies.setTiming(predecessor, predecessorTiming.first, predecessorTiming.second);
+    m_dependencies.setTiming(m_tasks[row].uid(), taskTiming.first, taskTiming.second);
+    return m_dependencies.addEdge(predecessor, m_tasks[row].uid());
+}
+
+void TaskModel::syncDependencies(const QVector<QUuid> &previous, int row)
+{
+    Task &task = m_tasks[row];
+    if (m_dependencies.contains(task.uid())) {
+        const QPair<qint64, qint64> timing = dependencyTiming(task);
+        m_dependencies.setTiming(task.uid(), timing.first, timing.second);
+    }
+    const QVector<QUuid> requested = task.dependencies();
+    for (const QUuid &predecessor : previous) {
+        if (!requested.contains(predecessor))
+            m_dependencies.removeEdge(predecessor, task.uid());
+    }
+    QVector<QUuid> accepted;
+    for (const QUuid &predecessor : requested) {
+        if (accepted.contains(predecessor))
+            continue;
+        if (previous.contains(predecessor) || linkDependency(predecessor, row))
+            accepted.append(predecessor);
+    }
+    if (accepted.size() != requested.size())
+        task.setDependencies(accepted);
+}
+
+void TaskModel::emitDependencyChanges()
+{
+    const QSet<QUuid> changed = m_dependencies.takeChanged();
+    for (const QUuid &uid : changed) {
+        const int row = findTask(uid);
+        if (row >= 0) {
+            emit dataChanged(createIndex(row, 0), createIndex(row, ColumnCount - 1),
+                             {EarliestStartRole, SlackMinutesRole, CriticalPathRole, DependencyConflictRole,
+                              Qt::ToolTipRole, FullTaskRole});
         }
     }
-    return -1;
+}
+
+bool TaskModel::addDependency(const QUuid &predecessor, const QUuid &successor)
+{
+    const int row = findTask(successor);
+    if (row < 0)
+        return false;
+    QVector<QUuid> dependencies = m_tasks[row].dependencies();
+    if (dependencies.contains(predecessor))
+        return true;
+    if (!linkDependency(predecessor, row)) {
+        emitDependencyChanges();
+        return false;
+    }
+    const Task before = m_tasks[row];
+    dependencies.append(predecessor);
+    m_tasks[row].setDependencies(dependencies);
+    emit dataChanged(createIndex(row, 0), createIndex(row, ColumnCount - 1));
+    emitDependencyChanges();
+    stampFields(row, before);
+    emit taskUpdated(row, before);
+    return true;
+}
+
+void TaskModel::removeDependency(const QUuid &predecessor, const QUuid &successor)
+{
+    const int row = findTask(successor);
+    if (row < 0)
+        return;
+    QVector<QUuid> dependencies = m_tasks[row].dependencies();
+    if (!dependencies.removeOne(predecessor))
+        return;
+    const Task before = m_tasks[row];
+    m_tasks[row].setDependencies(dependencies);
+    m_dependencies.removeEdge(predecessor, successor);
+    emit dataChanged(createIndex(row, 0), createIndex(row, ColumnCount - 1));
+    emitDependencyChanges();
+    stampFields(row, before);
+    emit taskUpdated(row, before);
+}
+
+const RowBitmap &TaskModel::rowsWithTag(int tagId) const
+{
+    static const RowBitmap empty;
+    const auto it = m_rowsByTag.constFind(tagId);
+    return it == m_rowsByTag.constEnd() ? empty : it.value();
+}
+
+void TaskModel::retagRow(int row, const QVector<int> &before, const QVector<int> &after)
+{
+    if (before == after)
+        return;
+    for (int tag : before) {
+        auto it = m_rowsByTag.find(tag);
+        if (it == m_rowsByTag.end())
+            continue;
+        it->setBit(row, false);
+        if (!it->any())
+            m_rowsByTag.erase(it);
+    }
+    for (int tag : after)
+        m_rowsByTag[tag].setBit(row);
+    ++m_tagRevision;
 }
 
 QVector<int> TaskModel::findTasksUsingProject(const QString &projectName) const
@@ -264,9 +733,14 @@ void TaskModel::replaceProjectInTasks(const QVector<int> &taskIndices, const QSt
 {
     for (int index : taskIndices) {
         if (index >= 0 && index < m_tasks.size()) {
+            const Task before = m_tasks[index];
+            accountTask(m_tasks[index], -1);
             m_tasks[index].setProjectType(newProject);
+            accountTask(m_tasks[index], +1);
             m_tasks[index].setWasModified(true);
             emit dataChanged(createIndex(index, 0), createIndex(index, columnCount() - 1));
+            stampFields(index, before);
+            emit taskUpdated(index, before);
         }
     }
 }
@@ -275,9 +749,13 @@ void TaskModel::replaceStatusInTasks(const QVector<int> &taskIndices, const QStr
 {
     for (int index : taskIndices) {
         if (index >= 0 && index < m_tasks.size()) {
+            const Task before = m_tasks[index];
             m_tasks[index].setStatus(newStatus);
             m_tasks[index].setWasModified(true);
+            relinkTask(before, m_tasks[index]);
             emit dataChanged(createIndex(index, 0), createIndex(index, columnCount() - 1));
+            stampFields(index, before);
+            emit taskUpdated(index, before);
         }
     }
 }
@@ -286,90 +764,667 @@ void TaskModel::replacePriorityInTasks(const QVector<int> &taskIndices, const QS
 {
     for (int index : taskIndices) {
         if (index >= 0 && index < m_tasks.size()) {
+            const Task before = m_tasks[index];
             m_tasks[index].setPriority(newPriority);
             m_tasks[index].setWasModified(true);
             emit dataChanged(createIndex(index, 0), createIndex(index, columnCount() - 1));
+            stampFields(index, before);
+            emit taskUpdated(index, before);
         }
     }
 }
 
-bool TaskModel::saveTasks() const
+void TaskModel::remapTags(const QHash<int, int> &ids)
 {
+    if (ids.isEmpty())
+        return;
+    auto remap = [&ids](const QVector<int> &tagIds) {
+        QVector<int> result;
+        result.reserve(tagIds.size());
+        for (int id : tagIds)
+            result.append(ids.value(id, id));
+        return result;
+    };
+    for (int row = 0; row < m_tasks.size(); ++row) {
+        const QVector<int> before = m_tasks[row].tagIds();
+        const QVector<int> after = remap(before);
+        if (after == before)
+            continue;
+        m_tasks[row].setTagIds(after);
+        retagRow(row, before, after);
+        emit dataChanged(createIndex(row, 0), createIndex(row, columnCount() - 1));
+    }
+    for (DeletedTask &deleted : m_trash)
+        deleted.task.setTagIds(remap(deleted.task.tagIds()));
+}
+
+/**
+ * @brief Обходит дни, на которые приходится задача, с числом занятых в каждом минут.
+ * @return true, если у задачи есть интервал времени.
+ */
+template <typename Visit>
+static bool visitTaskDays(const Task &task, Visit visit)
+{
+    const QDateTime start = task.startDateTime();
+    const QDateTime end = task.endDateTime();
+    if (!task.isProjectTask() || !start.isValid() || !end.isValid() || start >= end) {
+        // Задача без интервала учитывается только в день срока
+        QDateTime due = task.dueDateTime();
+        if (due.isValid())
+            visit(due.date(), 0);
+        return false;
+    }
+
+    for (QDate day = start.date(); day <= end.date(); day = day.addDays(1)) {
+        const QDateTime dayStart(day, QTime(0, 0));
+        const QDateTime dayEnd(day.addDays(1), QTime(0, 0));
+        int minutes = static_cast<int>(std::max(start, dayStart).secsTo(std::min(end, dayEnd)) / 60);
+        // Окончание ровно в полночь не занимает следующий день
+        if (minutes <= 0 && day != start.date())
+            break;
+        visit(day, std::max(0, minutes));
+    }
+    return true;
+}
+
+TaskModel::DayStats TaskModel::dayStats(const QDate &date) const
+{
+    DayStats stats = m_dayStats.value(date);
+    if (m_seriesUids.isEmpty())
+        return stats;
+
+    // Серий немного, а разворачивание одной на один день — O(1)
+    for (const Task &occurrence : occurrences(date, date)) {
+        visitTaskDays(occurrence, [&stats, &date, &occurrence](const QDate &day, int minutes) {
+            if (day != date)
+                return;
+            ++stats.taskCount;
+            if (minutes > 0) {
+                stats.bookedMinutes += minutes;
+                stats.minutesByProject[occurrence.projectType()] += minutes;
+            }
+        });
+    }
+    return stats;
+}
+
+void TaskModel::accountTask(const Task &task, int sign)
+{
+    if (task.isRecurring()) {
+        if (sign > 0)
+            m_seriesUids.insert(task.uid());
+        else
+            m_seriesUids.remove(task.uid());
+        return;
+    }
+
+    const bool timed = visitTaskDays(task, [this, sign, &task](const QDate &day, int minutes) {
+        adjustDay(day, sign, minutes, task.projectType());
+    });
+    if (!timed)
+        return;
+
+    if (sign > 0)
+        m_intervalIndex.insert(task.uid(), task.startDateTime(), task.endDateTime());
+    else
+        m_intervalIndex.remove(task.uid(), task.startDateTime(), task.endDateTime());
+}
+
+QVector<Task> TaskModel::occurrences(const QDate &from, const QDate &to) const
+{
+    QVector<Task> result;
+    for (const QUuid &uid : m_seriesUids) {
+        const int row = findTask(uid);
+        if (row >= 0)
+            result += Recurrence::expand(m_tasks[row], from, to);
+    }
+    return result;
+}
+
+QVector<TaskIntervalIndex::Interval> TaskModel::overlapping(const QDateTime &start, const QDateTime &end,
+                                                            const QUuid &exclude) const
+{
+    QVector<TaskIntervalIndex::Interval> result = m_intervalIndex.overlapping(start, end, exclude);
+    if (m_seriesUids.isEmpty() || start >= end)
+        return result;
+
+    const qint64 startMs = start.toMSecsSinceEpoch();
+    const qint64 endMs = end.toMSecsSinceEpoch();
+    for (const Task &occurrence : occurrences(start.date(), end.date())) {
+        if (occurrence.uid() == exclude || !occurrence.isProjectTask())
+            continue;
+        const qint64 occurrenceStart = occurrence.startDateTime().toMSecsSinceEpoch();
+        const qint64 occurrenceEnd = occurrence.endDateTime().toMSecsSinceEpoch();
+        if (occurrenceStart < endMs && occurrenceEnd > startMs)
+            result.append(TaskIntervalIndex::Interval{occurrenceStart, occurrenceEnd, occurrence.uid()});
+    }
+    std::sort(result.begin(), result.end(), [](const TaskIntervalIndex::Interval &a, const TaskIntervalIndex::Interval &b) {
+        return a.startMs < b.startMs;
+    });
+    return result;
+}
+
+void TaskModel::setOccurrenceOverride(const QUuid &seriesUid, const QDate &date, const Task &occurrence)
+{
+    const int row = findTask(seriesUid);
+    if (row < 0 || !m_tasks[row].isRecurring())
+        return;
+
+    Task series = m_tasks[row];
+    Recurrence rule = series.recurrence();
+    rule.removeOverride(date);
+    series.setRecurrence(rule);
+
+    // Храним только отличия от вхождения по правилу
+    Task base;
+    bool found = false;
+    for (const Task &candidate : Recurrence::expand(series, date, date)) {
+        if (candidate.occurrenceDate() == date) {
+            base = candidate;
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+        return;
+
+    OccurrenceOverride change;
+    if (occurrence.startDateTime() != base.startDateTime())
+        change.start = occurrence.startDateTime();
+    if (occurrence.endDateTime() != base.endDateTime())
+        change.end = occurrence.endDateTime();
+    if (occurrence.title() != base.title())
+        change.title = occurrence.title();
+    if (occurrence.status() != base.status())
+        change.status = occurrence.status();
+    if (occurrence.description() != base.description())
+        change.description = occurrence.description();
+    if (change.start.isValid() || change.end.isValid() || !change.title.isEmpty()
+        || !change.status.isEmpty() || !change.description.isEmpty()) {
+        rule.setOverride(date, change);
+    }
+    series.setRecurrence(rule);
+    updateTask(row, series);
+}
+
+void TaskModel::skipOccurrence(const QUuid &seriesUid, const QDate &date)
+{
+    const int row = findTask(seriesUid);
+    if (row < 0 || !m_tasks[row].isRecurring())
+        return;
+    Task series = m_tasks[row];
+    Recurrence rule = series.recurrence();
+    rule.addException(date);
+    series.setRecurrence(rule);
+    updateTask(row, series);
+}
+
+QVector<FreeSlot> TaskModel::findFreeSlots(int durationMinutes, const QDate &from, const QDate &to,
+                                           const QTime &workStart, const QTime &workEnd, int maxResults) const
+{
+    TRACE_SCOPE("TaskModel::findFreeSlots");
+    QVector<FreeSlot> result;
+    if (durationMinutes <= 0 || !from.isValid() || !to.isValid() || to < from || maxResults <= 0)
+        return result;
+
+    const qint64 durationMs = static_cast<qint64>(durationMinutes) * 60 * 1000;
+    const bool useWorkHours = workStart.isValid() && workEnd.isValid() && workStart < workEnd;
+    const qint64 fromMs = QDateTime(from, QTime(0, 0)).toMSecsSinceEpoch();
+    const qint64 toMs = QDateTime(to.addDays(1), QTime(0, 0)).toMSecsSinceEpoch();
+    QVector<QPair<qint64, qint64>> busy = m_intervalIndex.busy(fromMs, toMs);
+    if (!m_seriesUids.isEmpty()) {
+        // Вхождения серий разворачиваются только для окна поиска и сливаются с индексом
+        for (const Task &occurrence : occurrences(from, to)) {
+            if (!occurrence.isProjectTask())
+                continue;
+            const qint64 start = std::max(fromMs, occurrence.startDateTime().toMSecsSinceEpoch());
+            const qint64 end = std::min(toMs, occurrence.endDateTime().toMSecsSinceEpoch());
+            if (start < end)
+                busy.append(qMakePair(start, end));
+        }
+        std::sort(busy.begin(), busy.end());
+        QVector<QPair<qint64, qint64>> merged;
+        for (const auto &interval : std::as_const(busy)) {
+            if (!merged.isEmpty() && interval.first <= merged.last().second)
+                merged.last().second = std::max(merged.last().second, interval.second);
+            else
+                merged.append(interval);
+        }
+        busy = merged;
+    }
+
+    auto appendSlot = [&result](qint64 startMs, qint64 endMs) {
+        result.append(FreeSlot{QDateTime::fromMSecsSinceEpoch(startMs), QDateTime::fromMSecsSinceEpoch(endMs)});
+    };
+
+    // Занятые промежутки и окна дней идут по возрастанию — один проход двумя указателями
+    int b = 0;
+    for (QDate day = from; day <= to && result.size() < maxResults; day = day.addDays(1)) {
+        const qint64 windowStart = QDateTime(day, useWorkHours ? workStart : QTime(0, 0)).toMSecsSinceEpoch();
+        const qint64 windowEnd = useWorkHours ? QDateTime(day, workEnd).toMSecsSinceEpoch()
+                                              : QDateTime(day.addDays(1), QTime(0, 0)).toMSecsSinceEpoch();
+        while (b < busy.size() && busy[b].second <= windowStart)
+            ++b;
+
+        qint64 cursor = windowStart;
+        for (int k = b; k < busy.size() && busy[k].first < windowEnd && result.size() < maxResults; ++k) {
+            if (busy[k].first - cursor >= durationMs)
+                appendSlot(cursor, busy[k].first);
+            cursor = std::max(cursor, busy[k].second);
+        }
+        if (windowEnd - cursor >= durationMs && result.size() < maxResults)
+            appendSlot(cursor, windowEnd);
+    }
+    return result;
+}
+
+void TaskModel::adjustDay(const QDate &day, int sign, int minutes, const QString &project)
+{
+    DayStats &stats = m_dayStats[day];
+    stats.taskCount += sign;
+    if (minutes > 0) {
+        stats.bookedMinutes += sign * minutes;
+        int &projectMinutes = stats.minutesByProject[project];
+        projectMinutes += sign * minutes;
+        if (projectMinutes <= 0)
+            stats.minutesByProject.remove(project);
+    }
+    if (stats.taskCount <= 0)
+        m_dayStats.remove(day);
+}
+
+void TaskModel::rebuildIndexes()
+{
+    TRACE_SCOPE("TaskModel::rebuildIndexes");
+    m_dayStats.clear();
+    m_intervalIndex.clear();
+    m_rowByUid.clear();
+    m_seriesUids.clear();
+    m_childUids.clear();
+    m_parentByUid.clear();
+    m_progress.clear();
+    m_dependencies.clear();
+    m_rowsByTag.clear();
+    ++m_tagRevision;
+    m_rowByUid.reserve(m_tasks.size());
+    for (const Task &task : m_tasks)
+        accountTask(task, +1);
+    reindexRows(0);
+    for (int row = 0; row < m_tasks.size(); ++row) {
+        for (int tag : m_tasks[row].tagIds())
+            m_rowsByTag[tag].setBit(row);
+    }
+    // После индекса UID: родитель может стоять в файле позже подзадачи
+    for (const Task &task : m_tasks)
+        linkTask(task);
+    for (int row = 0; row < m_tasks.size(); ++row)
+        syncDependencies(QVector<QUuid>(), row);
+    m_dependencies.takeChanged(); // после сброса модели представления перечитают всё
+}
+
+QJsonObject TaskModel::taskToJson(const Task &task)
+{
+    QJsonObject taskObj;
+    taskObj["uid"] = task.uid().toString();
+    taskObj["title"] = task.title();
+    taskObj["description"] = task.description();
+    taskObj["projectType"] = task.projectType();
+    taskObj["status"] = task.status();
+    taskObj["priority"] = task.priority();
+    taskObj["estimatedMinutes"] = task.estimatedMinutes();
+    taskObj["isProjectTask"] = task.isProjectTask();
+    taskObj["wasModified"] = task.wasModified();
+    taskObj["creationDateTime"] = task.creationDateTime().toString(Qt::ISODate);
+    taskObj["startDateTime"] = task.startDateTime().toString(Qt::ISODate);
+    taskObj["endDateTime"] = task.endDateTime().toString(Qt::ISODate);
+    if (!task.parentUid().isNull())
+        taskObj["parentUid"] = task.parentUid().toString();
+    if (!task.tagIds().isEmpty()) {
+        QJsonArray tags;
+        for (int tag : task.tagIds())
+            tags.append(tag);
+        taskObj["tags"] = tags;
+    }
+    if (!task.dependencies().isEmpty()) {
+        QJsonArray dependsOn;
+        for (const QUuid &uid : task.dependencies())
+            dependsOn.append(uid.toString());
+        taskObj["dependsOn"] = dependsOn;
+    }
+    if (task.isRecurring())
+        taskObj["recurrence"] = task.recurrence().toJson();
+    const QHash<QString, qint64> fieldStamps = task.fieldStamps();
+    if (!fieldStamps.isEmpty()) {
+        QJsonObject stamps;
+        for (auto it = fieldStamps.constBegin(); it != fieldStamps.constEnd(); ++it)
+            stamps.insert(it.key(), it.value());
+        taskObj["stamps"] = stamps;
+    }
+    return taskObj;
+}
+
+Task TaskModel::taskFromJson(const QJsonObject &object)
+{
+    const QJsonObject &obj = object;
+    Task task;
+    task.setUid(QUuid(obj["uid"].toString()));
+    task.setTitle(obj["title"].toString());
+    task.setDescription(obj["description"].toString());
+    task.setProjectType(obj["projectType"].toString());
+    task.setStatus(obj["status"].toString());
+    task.setPriority(obj["priority"].toString());
+    task.setEstimatedMinutes(obj["estimatedMinutes"].toInt(60));
+    task.setIsProjectTask(obj["isProjectTask"].toBool());
+    task.setWasModified(obj["wasModified"].toBool());
+    task.setCreationDateTime(QDateTime::fromString(obj["creationDateTime"].toString(), Qt::ISODate));
+    task.setStartDateTime(QDateTime::fromString(obj["startDateTime"].toString(), Qt::ISODate));
+    task.setEndDateTime(QDateTime::fromString(obj["endDateTime"].toString(), Qt::ISODate));
+    task.setParentUid(QUuid(obj["parentUid"].toString()));
+    QVector<QUuid> dependencies;
+    for (const QJsonValue &dependency : obj["dependsOn"].toArray())
+        dependencies.append(QUuid(dependency.toString()));
+    task.setDependencies(dependencies);
+    QVector<int> tagIds;
+    for (const QJsonValue &tag : obj["tags"].toArray())
+        tagIds.append(tag.toInt());
+    task.setTagIds(tagIds);
+    if (obj.contains("recurrence"))
+        task.setRecurrence(Recurrence::fromJson(obj["recurrence"].toObject()));
+    const QJsonObject stamps = obj["stamps"].toObject();
+    for (auto it = stamps.constBegin(); it != stamps.constEnd(); ++it)
+        task.setFieldStamp(it.key(), it.value().toInteger());
+    return task;
+}
+
+QString TaskModel::tasksFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/tasks.json";
+}
+
+bool TaskModel::saveTasks()
+{
+    TRACE_SCOPE("TaskModel::saveTasks");
     QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir dir(path);
     if (!dir.exists()) {
         dir.mkpath(".");
     }
-    QString filePath = path + "/tasks.json";
+    QString filePath = tasksFilePath();
 
-    QJsonArray tasksArray;
-    for (const Task &task : m_tasks) {
-        QJsonObject taskObj;
-        taskObj["uid"] = task.uid().toString();
-        taskObj["title"] = task.title();
-        taskObj["description"] = task.description();
-        taskObj["projectType"] = task.projectType();
-        taskObj["status"] = task.status();
-        taskObj["priority"] = task.priority();
-        taskObj["isProjectTask"] = task.isProjectTask();
-        taskObj["wasModified"] = task.wasModified();
-        taskObj["creationDateTime"] = task.creationDateTime().toString(Qt::ISODate);
-        taskObj["startDateTime"] = task.startDateTime().toString(Qt::ISODate);
-        taskObj["endDateTime"] = task.endDateTime().toString(Qt::ISODate);
-        tasksArray.append(taskObj);
-    }
+    for (int attempt = 0; attempt < MaxSaveAttempts; ++attempt) {
+        // Файл записал кто-то другой — сначала его изменения, потом наша запись поверх
+        const qint64 diskVersion = readTasksFileVersion(filePath);
+        if (m_fileKnown && diskVersion != m_fileVersion)
+            applyTasksFile(readTasksFile(filePath));
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
-        return false;
-    }
+        QJsonArray tasksArray;
+        for (const Task &task : m_tasks)
+            tasksArray.append(taskToJson(task));
+        // Корзина хранится в том же массиве: надгробие — запись с временем удаления
+        for (const DeletedTask &deleted : m_trash) {
+            QJsonObject taskObj = taskToJson(deleted.task);
+            taskObj["deletedAt"] = deleted.deletedAt.toString(Qt::ISODate);
+            tasksArray.append(taskObj);
+        }
+        // Номер записи идёт первым, чтобы его можно было прочитать, не разбирая файл;
+        // за ним — контрольная сумма массива задач: по ней при загрузке узнаётся испорченный файл
+        const qint64 version = std::max(diskVersion, m_fileVersion) + 1;
+        const QByteArray tasksJson = QJsonDocument(tasksArray).toJson();
+        const QByteArray data = "{\n    \"version\": " + QByteArray::number(version)
+                              + ",\n    \"checksum\": \"" + QCryptographicHash::hash(tasksJson, QCryptographicHash::Sha1).toHex()
+                              + "\",\n    \"tasks\": " + tasksJson + "}\n";
 
-    file.write(QJsonDocument(tasksArray).toJson());
-    file.close();
-    return true;
+        const LockedSaveFile::Result result = LockedSaveFile::write(filePath, data, [&]() {
+            return readTasksFileVersion(filePath) == diskVersion;
+        });
+        if (result == LockedSaveFile::Stale)
+            continue;
+        if (result == LockedSaveFile::Failed) {
+            qWarning("Couldn't open save file.");
+            return false;
+        }
+
+        TaskFile written;
+        written.version = version;
+        written.digest = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+        written.tasks = m_tasks;
+        setFileBase(written);
+        return true;
+    }
+    qWarning("Tasks file keeps changing, giving up on save.");
+    return false;
 }
 
-bool TaskModel::loadTasks()
+qint64 TaskModel::readTasksFileVersion(const QString &filePath)
 {
-    QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QString filePath = path + "/tasks.json";
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+    static const QRegularExpression header(R"(^\s*\{\s*"version"\s*:\s*(\d+))");
+    const QRegularExpressionMatch match = header.match(QString::fromUtf8(file.read(64)));
+    return match.hasMatch() ? match.captured(1).toLongLong() : 0;
+}
 
+TaskModel::TaskFile TaskModel::readTasksFile(const QString &filePath)
+{
+    TRACE_SCOPE("TaskModel::readTasksFile");
+    TaskFile result;
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
         qWarning("Couldn't open tasks file.");
-        return false;
+        return result;
     }
 
     QByteArray data = file.readAll();
     QJsonDocument doc(QJsonDocument::fromJson(data));
 
-    if (!doc.isArray()) {
-        qWarning("Tasks file is not a valid JSON array.");
-        return false;
+    // Старый формат — просто массив задач без номера записи
+    QJsonArray tasksArray;
+    if (doc.isObject()) {
+        tasksArray = doc.object()["tasks"].toArray();
+        result.version = doc.object()["version"].toInteger();
+    } else if (doc.isArray()) {
+        tasksArray = doc.array();
+    } else {
+        qWarning("Tasks file is not valid JSON.");
+        result.damaged = true;
+        return result;
     }
 
-    beginResetModel();
-    m_tasks.clear();
+    // Сумма считается по байтам массива задач между заголовком и закрывающей скобкой файла
+    static const QRegularExpression checksumHeader(
+        R"(^\s*\{\s*"version"\s*:\s*\d+\s*,\s*"checksum"\s*:\s*"([0-9a-f]+)"\s*,\s*"tasks"\s*:\s*)");
+    const QRegularExpressionMatch match = checksumHeader.match(QString::fromLatin1(data.left(160)));
+    if (match.hasMatch()) {
+        const qsizetype from = match.capturedEnd();
+        const QByteArray tasksJson = data.mid(from, data.lastIndexOf('}') - from);
+        if (QCryptographicHash::hash(tasksJson, QCryptographicHash::Sha1).toHex() != match.captured(1).toLatin1()) {
+            qWarning("Tasks file checksum mismatch.");
+            result.damaged = true;
+            return result;
+        }
+    }
 
-    QJsonArray tasksArray = doc.array();
     for (const QJsonValue &value : tasksArray) {
-        QJsonObject obj = value.toObject();
-        Task task;
-        task.setUid(QUuid(obj["uid"].toString()));
-        task.setTitle(obj["title"].toString());
-        task.setDescription(obj["description"].toString());
-        task.setProjectType(obj["projectType"].toString());
-        task.setStatus(obj["status"].toString());
-        task.setPriority(obj["priority"].toString());
-        task.setIsProjectTask(obj["isProjectTask"].toBool());
-        task.setWasModified(obj["wasModified"].toBool());
-        task.setCreationDateTime(QDateTime::fromString(obj["creationDateTime"].toString(), Qt::ISODate));
-        task.setStartDateTime(QDateTime::fromString(obj["startDateTime"].toString(), Qt::ISODate));
-        task.setEndDateTime(QDateTime::fromString(obj["endDateTime"].toString(), Qt::ISODate));
-        m_tasks.append(task);
+        const QJsonObject obj = value.toObject();
+        const Task task = taskFromJson(obj);
+        if (obj.contains("deletedAt"))
+            result.deleted.append(DeletedTask{task, QDateTime::fromString(obj["deletedAt"].toString(), Qt::ISODate)});
+        else
+            result.tasks.append(task);
+    }
+    result.digest = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    result.ok = true;
+    return result;
+}
+
+bool TaskModel::loadTasks()
+{
+    TRACE_SCOPE("TaskModel::loadTasks");
+    // Даже отсутствующий файл — известное состояние: появившийся позже чужой файл будет влит, а не затёрт
+    m_fileKnown = true;
+    const QString filePath = tasksFilePath();
+    TaskFile contents = readTasksFile(filePath);
+    m_loadStatus = FileLoaded;
+    if (!contents.ok) {
+        // Файл испорчен или пропал — выручает предыдущее поколение. Испорченный файл
+        // убирается в .damaged: иначе следующее сохранение сделало бы предыдущим поколением его
+        const bool damaged = contents.damaged;
+        if (damaged) {
+            QFile::remove(filePath + ".damaged");
+            QFile::rename(filePath, filePath + ".damaged");
+        }
+        contents = readTasksFile(LockedSaveFile::previousPath(filePath));
+        m_loadStatus = contents.ok ? (damaged ? PreviousLoaded : PreviousLoadedMissing)
+                                   : damaged ? FileDamaged : FileMissing;
     }
+    if (!contents.ok)
+        return false;
+
+    beginResetModel();
+    m_tasks = contents.tasks;
+    m_trash.clear();
+    for (const DeletedTask &deleted : contents.deleted)
+        m_trash.insert(deleted.task.uid(), deleted);
+    setFileBase(contents);
+    rebuildIndexes();
 
     endResetModel();
+    emit trashChanged();
     return true;
 }
+
+void TaskModel::setFileBase(const TaskFile &contents)
+{
+    m_fileKnown = true;
+    m_fileVersion = contents.version;
+    m_fileDigest = contents.digest;
+    m_fileBase.clear();
+    m_fileBase.reserve(contents.tasks.size());
+    for (const Task &task : contents.tasks)
+        m_fileBase.insert(task.uid(), taskToJson(task));
+}
+
+int TaskModel::applyTasksFile(const TaskFile &contents)
+{
+    TRACE_SCOPE("TaskModel::applyTasksFile");
+    if (!contents.ok || contents.digest == m_fileDigest)
+        return 0;
+
+    m_applyingFile = true;
+    int changes = 0;
+    QHash<QUuid, QJsonObject> theirs;
+    theirs.reserve(contents.tasks.size());
+    for (const Task &task : contents.tasks)
+        theirs.insert(task.uid(), taskToJson(task));
+    QSet<QUuid> theirTrash;
+    for (const DeletedTask &deleted : contents.deleted)
+        theirTrash.insert(deleted.task.uid());
+
+    // Задачи, которых в файле нет: удалены там, если у нас их с прочтения не меняли.
+    // С конца, чтобы номера ещё не просмотренных строк не сдвигались
+    for (int row = m_tasks.size() - 1; row >= 0; --row) {
+        const QUuid uid = m_tasks[row].uid();
+        if (theirs.contains(uid))
+            continue;
+        const auto base = m_fileBase.constFind(uid);
+        const bool keep = base == m_fileBase.constEnd() ? !theirTrash.contains(uid)
+                                                        : base.value() != taskToJson(m_tasks[row]);
+        if (!keep) {
+            // В корзину — только если она есть и в файле; иначе задачу там удалили насовсем
+            removeTask(row, theirTrash.contains(uid));
+            ++changes;
+        }
+    }
+
+    // Новые задачи встают в конец списка. Родитель и зависимости могут оказаться
+    // среди ещё не добавленных задач, поэтому они проставляются вторым проходом
+    QVector<Task> linkLater;
+    QVector<Task> merged;
+    for (const Task &task : contents.tasks) {
+        const QUuid uid = task.uid();
+        const auto base = m_fileBase.constFind(uid);
+        const int row = findTask(uid);
+        if (row >= 0) {
+            if (base == m_fileBase.constEnd()) {
+                merged.append(task);
+                continue;
+            }
+            // Поля, изменённые после прочтения только у нас, берутся наши. Изменённые по обе
+            // стороны решают отметки полей — так же, как при синхронизации (TaskSync::mergeTask)
+            QJsonObject result = theirs.value(uid);
+            const QJsonObject ours = taskToJson(m_tasks[row]);
+            QJsonObject byStamps;
+            QSet<QString> keys;
+            for (auto it = ours.constBegin(); it != ours.constEnd(); ++it)
+                keys.insert(it.key());
+            for (auto it = base->constBegin(); it != base->constEnd(); ++it)
+                keys.insert(it.key());
+            keys.remove("stamps");
+            for (const QString &key : std::as_const(keys)) {
+                QJsonValue value = ours.value(key);
+                if (value == base->value(key) || value == result.value(key))
+                    continue;
+                if (result.value(key) != base->value(key)) {
+                    if (byStamps.isEmpty())
+                        byStamps = TaskSync::mergeTask(ours, result);
+                    value = byStamps.value(key);
+                }
+                if (value.isUndefined())
+                    result.remove(key);
+                else
+                    result.insert(key, value);
+            }
+            // Отметки полей — самые поздние с обеих сторон
+            Task mergedTask = taskFromJson(result);
+            QHash<QString, qint64> stamps = task.fieldStamps();
+            const QHash<QString, qint64> ourStamps = m_tasks[row].fieldStamps();
+            for (auto it = ourStamps.constBegin(); it != ourStamps.constEnd(); ++it)
+                stamps.insert(it.key(), std::max(it.value(), stamps.value(it.key())));
+            mergedTask.setFieldStamps(stamps);
+            merged.append(mergedTask);
+            continue;
+        }
+        // Удалена у нас после прочтения, а в файле с тех пор не менялась — остаётся удалённой
+        if (base != m_fileBase.constEnd() && m_trash.contains(uid) && base.value() == theirs.value(uid))
+            continue;
+        if (task.parentUid().isNull() && task.dependencies().isEmpty()) {
+            addTask(task);
+        } else {
+            Task unlinked = task;
+            unlinked.setParentUid(QUuid());
+            unlinked.setDependencies({});
+            addTask(unlinked);
+            linkLater.append(task);
+        }
+        ++changes;
+    }
+    for (const Task &task : std::as_const(linkLater))
+        updateTask(findTask(task.uid()), task);
+
+    // Неизменённые задачи не трогаются
+    for (const Task &task : std::as_const(merged)) {
+        const int row = findTask(task.uid());
+        if (row >= 0 && taskToJson(m_tasks[row]) != taskToJson(task)) {
+            updateTask(row, task);
+            ++changes;
+        }
+    }
+
+    // Корзины объединяются; в ней только то, чего нет среди задач
+    QHash<QUuid, DeletedTask> trash;
+    for (const DeletedTask &deleted : contents.deleted) {
+        if (findTask(deleted.task.uid()) < 0)
+            trash.insert(deleted.task.uid(), deleted);
+    }
+    for (const DeletedTask &deleted : std::as_const(m_trash)) {
+        if (!trash.contains(deleted.task.uid()) && findTask(deleted.task.uid()) < 0)
+            trash.insert(deleted.task.uid(), deleted);
+    }
+    m_trash = trash;
+    setFileBase(contents);
+    m_applyingFile = false;
+    emit trashChanged();
+    emit tasksFileApplied(changes);
+    return changes;
+}
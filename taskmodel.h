@@ -4,7 +4,16 @@
 #include <QAbstractListModel>
 #include <QVector>
 #include "task.h"
+#include "taskintervalindex.h"
+#include "taskdependencygraph.h"
+#include "rowbitmap.h"
 #include <QUuid>
+#include <QHash>
+#include <QSet>
+#include <QDate>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QByteArray>
 
 class CustomDataManager;
 
@@ -30,7 +39,12 @@ public:
         StartDateRole,
         EndDateRole,
         CreationDateRole,
-        FullTaskRole
+        FullTaskRole,
+        UidRole,
+        EarliestStartRole,     ///< Раннее начало с учётом зависимостей (QDateTime)
+        SlackMinutesRole,      ///< Резерв времени в минутах (только для задач с зависимостями)
+        CriticalPathRole,      ///< Задача на критическом пути (bool)
+        DependencyConflictRole ///< Начало раньше окончания одного из предшественников (bool)
     };
     /**
      * @brief Колонки для отображения задач в таблице.
@@ -44,6 +58,64 @@ public:
         ColumnCount
     };
 
+    /**
+     * @brief Сводка по одному дню для календарной тепловой карты.
+     */
+    struct DayStats {
+        int taskCount = 0;                   ///< Задачи, приходящиеся на день
+        int bookedMinutes = 0;               ///< Минуты проектных задач внутри дня
+        QHash<QString, int> minutesByProject; ///< Те же минуты в разбивке по проектам
+    };
+
+    /**
+     * @brief Прогресс поддерева задачи: выполненные потомки из всех потомков.
+     */
+    struct Progress {
+        int done = 0;  ///< Выполненные потомки на всех уровнях
+        int total = 0; ///< Все потомки на всех уровнях
+    };
+
+    /**
+     * @brief Задача в корзине: запись-надгробие с временем удаления.
+     */
+    struct DeletedTask {
+        Task task;
+        QDateTime deletedAt;
+    };
+
+    /**
+     * @brief Содержимое tasks.json, прочитанное без участия модели.
+     */
+    struct TaskFile {
+        bool ok = false;              ///< Файл прочитан и разобран
+        qint64 version = 0;           ///< Номер записи файла; 0 — файла нет или он старого формата
+        QByteArray digest;            ///< SHA-1 содержимого: по нему узнаются собственные записи
+        bool damaged = false;         ///< Файл есть, но оборван, не разбирается или не сходится контрольная сумма
+        QVector<Task> tasks;
+        QVector<DeletedTask> deleted;
+    };
+
+    /**
+     * @brief Чем закончилась последняя загрузка (loadTasks).
+     */
+    enum LoadStatus {
+        FileLoaded,     ///< tasks.json прочитан
+        FileMissing,    ///< Файла нет — первый запуск
+        PreviousLoaded, ///< tasks.json повреждён (перенесён в tasks.json.damaged) — прочитано предыдущее поколение
+        FileDamaged,    ///< tasks.json повреждён (перенесён в tasks.json.damaged), предыдущего поколения нет или оно тоже испорчено
+        PreviousLoadedMissing ///< tasks.json пропал — прочитано предыдущее поколение
+    };
+
+    /**
+     * @brief Сколько раз saveTasks вливает чужую запись и пробует снова, прежде чем сдаться.
+     */
+    static constexpr int MaxSaveAttempts = 5;
+
+    /**
+     * @brief Сколько дней удалённая задача хранится в корзине до очистки.
+     */
+    static constexpr int TrashRetentionDays = 30;
+
     /**
      * @brief Конструктор TaskModel.
      * @param parent Родительский объект.
@@ -104,10 +176,14 @@ public:
      */
     void addTask(const Task& task);
     /**
-     * @brief Удаляет задачу по индексу.
+     * @brief Удаляет задачу по индексу в корзину.
+     *
+     * Строка уходит из модели, а задача остаётся в корзине с временем
+     * удаления, пока её не восстановят или не очистят корзину.
      * @param index Индекс задачи.
+     * @param toTrash false — задача пропадает бесследно (отмена её добавления).
      */
-    void removeTask(int index);
+    void removeTask(int index, bool toTrash = true);
     /**
      * @brief Обновляет задачу по индексу.
      * @param index Индекс задачи.
@@ -130,12 +206,40 @@ public:
      */
     void clear();
     /**
-     * @brief Находит задачу по UID.
+     * @brief Заменить все задачи одним сбросом модели (индексы строятся заново, корзина не меняется).
+     */
+    void setTasks(const QVector<Task> &tasks);
+    /**
+     * @brief Находит задачу по UID (O(1), по хэшу UID → строка).
      * @param uid Уникальный идентификатор.
      * @return Индекс задачи или -1.
      */
     int findTask(const QUuid& uid) const;
 
+    /**
+     * @brief Удалённые задачи, от недавно удалённых к давним.
+     */
+    QVector<DeletedTask> deletedTasks() const;
+    int deletedCount() const { return m_trash.size(); }
+    bool isDeleted(const QUuid &uid) const { return m_trash.contains(uid); }
+    /**
+     * @brief Вернуть задачу из корзины в конец списка (поиск по UID за O(1)).
+     *
+     * Родитель и зависимости задачи сохраняются, если их задачи на месте;
+     * подзадачи, поднятые при удалении, остаются на новом уровне.
+     * @return Строка восстановленной задачи или -1, если её нет в корзине.
+     */
+    int restoreTask(const QUuid &uid);
+    /**
+     * @brief Удалить задачу из корзины без возможности восстановления.
+     */
+    void deletePermanently(const QUuid &uid);
+    /**
+     * @brief Очистить корзину от задач, удалённых раньше deletedBefore.
+     * @return Число удалённых записей.
+     */
+    int purgeTrash(const QDateTime &deletedBefore);
+
     /**
      * @brief Находит задачи, использующие проект.
      * @param projectName Имя проекта.
@@ -173,21 +277,332 @@ public:
      * @param newPriority Новый приоритет.
      */
     void replacePriorityInTasks(const QVector<int>& taskIndices, const QString& newPriority);
+    /**
+     * @brief Перенумеровать теги в задачах и корзине (после слияния списка тегов).
+     *
+     * Смысл задач не меняется, поэтому отметки полей, отмена и журнал не затрагиваются.
+     * @param ids Старый ID → новый; не упомянутые ID остаются как есть.
+     */
+    void remapTags(const QHash<int, int> &ids);
+
+    /**
+     * @brief Сводка по дню; поддерживается при каждом изменении за O(дней задачи).
+     *
+     * Вхождения повторяющихся серий добавляются при запросе.
+     * @param date День.
+     * @return Сводка (пустая, если в этот день задач нет).
+     */
+    DayStats dayStats(const QDate &date) const;
+    /**
+     * @brief Индекс интервалов задач по времени (поддерживается вместе с дневными сводками).
+     */
+    const TaskIntervalIndex &intervalIndex() const { return m_intervalIndex; }
+    /**
+     * @brief Ищет самые ранние свободные промежутки не короче заданной длительности.
+     *
+     * Занятые интервалы берутся из индекса (и вхождений серий в пределах
+     * окна поиска) и объединяются за один проход, затем вычитаются из окон
+     * каждого дня.
+     * @param durationMinutes Длительность в минутах.
+     * @param from Первый день поиска.
+     * @param to Последний день поиска (включительно).
+     * @param workStart Начало рабочего дня (невалидное значение — весь день).
+     * @param workEnd Конец рабочего дня.
+     * @param maxResults Максимальное число промежутков.
+     * @return Свободные промежутки по возрастанию начала.
+     */
+    QVector<FreeSlot> findFreeSlots(int durationMinutes, const QDate &from, const QDate &to,
+                                    const QTime &workStart = QTime(), const QTime &workEnd = QTime(),
+                                    int maxResults = 10) const;
+    /**
+     * @brief Интервалы задач, пересекающие [start, end), включая вхождения повторяющихся серий.
+     * @param exclude Задача (или серия), которую не нужно возвращать.
+     * @return Пересечения по возрастанию начала.
+     */
+    QVector<TaskIntervalIndex::Interval> overlapping(const QDateTime &start, const QDateTime &end,
+                                                     const QUuid &exclude = QUuid()) const;
+
+    /**
+     * @brief Вхождения всех повторяющихся серий в окне дат [from, to].
+     */
+    QVector<Task> occurrences(const QDate &from, const QDate &to) const;
+    /**
+     * @brief Сохранить изменения одного вхождения серии (хранятся только отличия от серии).
+     * @param seriesUid UID серии.
+     * @param date Дата вхождения по правилу повторения.
+     * @param occurrence Изменённое вхождение.
+     */
+    void setOccurrenceOverride(const QUuid &seriesUid, const QDate &date, const Task &occurrence);
+    /**
+     * @brief Исключить одно вхождение серии.
+     */
+    void skipOccurrence(const QUuid &seriesUid, const QDate &date);
+
+    /**
+     * @brief Родитель задачи в иерархии (пустой UID — верхний уровень).
+     *
+     * Ссылка на отсутствующую задачу или на собственного потомка не учитывается:
+     * такая задача остаётся на верхнем уровне.
+     */
+    QUuid parentOf(const QUuid &uid) const { return m_parentByUid.value(uid); }
+    /**
+     * @brief Прямые подзадачи в порядке добавления; для пустого UID — задачи верхнего уровня.
+     */
+    QVector<QUuid> childUids(const QUuid &parentUid = QUuid()) const { return m_childUids.value(parentUid); }
+    /**
+     * @brief Число прямых подзадач без копирования списка.
+     */
+    int childCount(const QUuid &parentUid = QUuid()) const;
+    /**
+     * @brief Прогресс по всем потомкам задачи.
+     *
+     * Счётчики не пересчитываются обходом поддерева: каждое изменение
+     * прибавляет разницу к предкам задачи за O(глубины).
+     */
+    Progress progress(const QUuid &uid) const { return m_progress.value(uid); }
+    /**
+     * @brief Является ли ancestor предком задачи uid.
+     */
+    bool isAncestor(const QUuid &ancestor, const QUuid &uid) const;
+
+    /**
+     * @brief Добавить зависимость: successor не может начаться до окончания predecessor.
+     * @return false, если задачи нет или зависимость замкнула бы цикл.
+     */
+    bool addDependency(const QUuid &predecessor, const QUuid &successor);
+    /**
+     * @brief Удалить зависимость.
+     */
+    void removeDependency(const QUuid &predecessor, const QUuid &successor);
+    /**
+     * @brief Граф зависимостей; поддерживается при каждом изменении задач.
+     */
+    const TaskDependencyGraph &dependencyGraph() const { return m_dependencies; }
+
+    /**
+     * @brief Строки задач с тегом tagId (пустая карта, если таких задач нет).
+     */
+    const RowBitmap &rowsWithTag(int tagId) const;
+    /**
+     * @brief Номер версии карт тегов: меняется при любом изменении тегов или номеров строк.
+     *
+     * По нему прокси-модель понимает, что посчитанный фильтр по тегам устарел.
+     */
+    quint64 tagIndexRevision() const { return m_tagRevision; }
+
+    /**
+     * @brief Задача в виде JSON-объекта, как в tasks.json.
+     *
+     * Необязательные поля (родитель, теги, зависимости, повторение, отметки
+     * изменения полей stamps) пишутся, только если заданы.
+     */
+    static QJsonObject taskToJson(const Task &task);
+    /**
+     * @brief Задача из JSON-объекта формата tasks.json; отсутствующие поля получают значения по умолчанию.
+     */
+    static Task taskFromJson(const QJsonObject &object);
+    /**
+     * @brief Поля задачи, изменившиеся между двумя версиями.
+     */
+    struct FieldDiff {
+        QJsonObject before; ///< Старые значения; null — поля не было
+        QJsonObject after;  ///< Новые значения; null — поле убрано
+        bool isEmpty() const { return after.isEmpty(); }
+    };
+    /**
+     * @brief Сравнить две версии задачи по полям формата tasks.json.
+     *
+     * Отметки stamps в разницу не входят: их модель ставит сама.
+     */
+    static FieldDiff diffFields(const Task &before, const Task &after);
+    /**
+     * @brief Записать поля в JSON-объект задачи; null убирает поле.
+     */
+    static void applyFields(QJsonObject &target, const QJsonObject &fields);
+    /**
+     * @brief Применить правку из диалога: только поля, которые пользователь изменил.
+     *
+     * Остальные поля берутся из модели, поэтому изменения, влитые из файла,
+     * пока диалог был открыт, не откатываются к снимку original.
+     * @param original Задача, с которой открывался диалог.
+     * @param edited Результат диалога.
+     * @return Строка задачи или -1, если задачи больше нет.
+     */
+    int applyEdit(const Task &original, const Task &edited);
+
+    /**
+     * @brief Путь к tasks.json.
+     */
+    static QString tasksFilePath();
+    /**
+     * @brief Прочитать и разобрать файл задач; не трогает модель, поэтому годится для фонового потока.
+     *
+     * Файл с контрольной суммой, которая не сходится с массивом задач,
+     * считается повреждённым (TaskFile::damaged), даже если JSON разбирается.
+     */
+    static TaskFile readTasksFile(const QString &filePath);
+    /**
+     * @brief Номер записи файла задач по первым байтам, без разбора всего файла.
+     * @return 0, если файла нет или он старого формата (массив без номера).
+     */
+    static qint64 readTasksFileVersion(const QString &filePath);
+    /**
+     * @brief Влить в модель файл, записанный другим процессом.
+     *
+     * Слияние трёхстороннее, по UID и по полям: база — файл в том виде, в каком
+     * модель его последний раз читала или писала. Поле, изменённое в модели
+     * после этого, остаётся как в модели (она пишет последней), остальные поля
+     * берутся из файла. Задача, исчезнувшая из файла, удаляется, если в модели
+     * её с тех пор не меняли; удалённая в модели не возвращается, если в файле
+     * её не меняли. Без базы (модель файла ещё не видела) прав файл.
+     *
+     * Модель меняется поштучными вставками, удалениями и заменами без сброса,
+     * поэтому выделение и прокрутка в представлениях сохраняются. Корзины
+     * объединяются. Файл, совпадающий с последним прочитанным или записанным
+     * моделью, пропускается.
+     * @return Число добавленных, удалённых и изменённых задач.
+     */
+    int applyTasksFile(const TaskFile &contents);
+    /**
+     * @brief Идёт applyTasksFile: изменения пришли из файла, а не от пользователя.
+     */
+    bool isApplyingTasksFile() const { return m_applyingFile; }
+    /**
+     * @brief Идёт restoreTask: добавленная задача вернулась из корзины.
+     */
+    bool isRestoringTask() const { return m_restoring; }
 
     /**
-     * @brief Сохраняет задачи в файл.
+     * @brief Сохраняет задачи в файл (вместе с корзиной: записи с полем deletedAt).
+     *
+     * Если с последнего чтения файл записал кто-то другой (номер записи на диске
+     * другой), его изменения сначала вливаются в модель (applyTasksFile). Файл
+     * заменяется атомарно под блокировкой tasks.json.lock (LockedSaveFile);
+     * запись, опередившая нас между чтением и переименованием, вливается
+     * следующей попыткой. Модель, ни разу не читавшая файл, перезаписывает его.
+     * Вслед за номером записи пишется SHA-1 массива задач (checksum), прежний
+     * файл остаётся предыдущим поколением (LockedSaveFile::previousPath).
      * @return true если успешно.
      */
-    bool saveTasks() const;
+    bool saveTasks();
     /**
      * @brief Загружает задачи из файла.
-     * @return true если успешно.
+     *
+     * Если tasks.json повреждён или пропал посреди записи, читается предыдущее
+     * поколение, а испорченный файл переносится в tasks.json.damaged.
+     * @return true если успешно; подробности — loadStatus.
      */
     bool loadTasks();
+    LoadStatus loadStatus() const { return m_loadStatus; }
+
+signals:
+    /**
+     * @brief Задача добавлена в строку row.
+     */
+    void taskInserted(int row);
+    /**
+     * @brief Задача в строке row сейчас будет удалена (её подзадачи уже перенесены).
+     */
+    void taskAboutToBeRemoved(int row);
+    /**
+     * @brief Задача в строке row заменена; before — её состояние до изменения.
+     */
+    void taskUpdated(int row, const Task &before);
+    /**
+     * @brief Изменилось содержимое корзины.
+     */
+    void trashChanged();
+    /**
+     * @brief Модель приведена к изменённому извне файлу (см. applyTasksFile).
+     */
+    void tasksFileApplied(int changes);
 
 private:
     QVector<Task> m_tasks;
     CustomDataManager *m_dataManager;
+    QHash<QDate, DayStats> m_dayStats; // только дни, на которые приходится хотя бы одна задача
+    TaskIntervalIndex m_intervalIndex;  // интервалы проектных задач
+    QHash<QUuid, int> m_rowByUid;       // строка задачи по UID
+    QSet<QUuid> m_seriesUids;           // повторяющиеся серии: в сводки и индекс не разворачиваются
+    QHash<QUuid, QVector<QUuid>> m_childUids; // подзадачи по родителю; QUuid() — верхний уровень
+    QHash<QUuid, QUuid> m_parentByUid;        // родитель, под которым задача учтена в иерархии
+    QHash<QUuid, Progress> m_progress;        // только задачи, у которых есть потомки
+    TaskDependencyGraph m_dependencies;       // рёбра хранятся у последователя в Task::dependencies
+    QHash<int, RowBitmap> m_rowsByTag;        // только теги, которые есть хотя бы у одной задачи
+    quint64 m_tagRevision = 0;
+    QHash<QUuid, DeletedTask> m_trash;        // удалённые задачи: в строки и индексы не входят
+    QByteArray m_fileDigest;                  // SHA-1 файла после последней загрузки или сохранения
+    qint64 m_fileVersion = 0;                 // номер записи этого файла
+    bool m_fileKnown = false;                 // модель читала или писала файл: есть база для слияния
+    QHash<QUuid, QJsonObject> m_fileBase;     // задачи файла в том виде — база трёхстороннего слияния
+    bool m_applyingFile = false;
+    bool m_restoring = false;
+    LoadStatus m_loadStatus = FileMissing;
+
+    /**
+     * @brief Учесть задачу в дневных сводках и индексе интервалов (sign = +1) или убрать её оттуда (sign = -1).
+     *
+     * Повторяющаяся серия только регистрируется в m_seriesUids.
+     */
+    void accountTask(const Task &task, int sign);
+    void adjustDay(const QDate &day, int sign, int minutes, const QString &project);
+    void rebuildIndexes();
+    /**
+     * @brief Включить задачу в иерархию и прибавить её поддерево к прогрессу предков.
+     */
+    void linkTask(const Task &task);
+    /**
+     * @brief Исключить задачу из иерархии и вычесть её поддерево из прогресса предков.
+     */
+    void unlinkTask(const Task &task);
+    /**
+     * @brief Учесть в иерархии замену задачи before на after (смену родителя, UID или выполненности).
+     */
+    void relinkTask(const Task &before, const Task &after);
+    /**
+     * @brief Прибавить разницу к прогрессу задачи from и всех её предков.
+     */
+    void adjustProgress(const QUuid &from, int doneDelta, int totalDelta);
+    /**
+     * @brief Добавить в граф ребро от predecessor к задаче в строке row (время обоих узлов обновляется).
+     * @return false, если предшественника нет или ребро замкнуло бы цикл.
+     */
+    bool linkDependency(const QUuid &predecessor, int row);
+    /**
+     * @brief Учесть в графе задачу в строке row: её время и изменившийся список зависимостей.
+     *
+     * Отвергнутые зависимости (цикл, отсутствующая задача) убираются из задачи.
+     * @param previous Зависимости, уже учтённые в графе для этой задачи.
+     */
+    void syncDependencies(const QVector<QUuid> &previous, int row);
+    /**
+     * @brief Сообщить об изменении расчётных значений графа для затронутых задач.
+     */
+    void emitDependencyChanges();
+    /**
+     * @brief Учесть смену тегов задачи в строке row в картах тегов.
+     */
+    void retagRow(int row, const QVector<int> &before, const QVector<int> &after);
+    /**
+     * @brief Отметить время изменения полей задачи в строке row, отличающихся от before (Task::fieldStamps).
+     *
+     * Отметка поля не уменьшается: если часы отстают от отметки, пришедшей
+     * с другой машины, берётся отметка на единицу больше. Во время
+     * applyTasksFile отметки приходят из файла и не трогаются.
+     */
+    void stampFields(int row, const Task &before);
+    /**
+     * @brief Заново проставить строки в m_rowByUid, начиная с from (после удаления).
+     */
+    void reindexRows(int from);
+    /**
+     * @brief Учесть смену UID задачи в строке row.
+     */
+    void renameUid(const QUuid &oldUid, const QUuid &newUid, int row);
+    /**
+     * @brief Запомнить содержимое файла как базу для следующего слияния.
+     */
+    void setFileBase(const TaskFile &contents);
 };
 
 #endif // TASKMODEL_H
@@ -18,13 +18,18 @@
 #include <QPoint>
 #include "taskfilterproxymodel.h"
 #include "taskmodel.h"
+#include "recurrence.h"
 #include <QDebug>
 #include <QSet>
 #include <QApplication>
-#include <numeric>
 #include "customdatamanager.h"
 #include <QTimer>
 #include <QTime>
+#include <QPaintEvent>
+#include <QPixmap>
+#include "perfmonitor.h"
+#include "tracing.h"
+#include "schedulelayout.h"
 
 /**
  * @struct PositionedTask
@@ -38,82 +43,56 @@ struct PositionedTask {
     int width;
     int column;
     int columnsCount;
+    int overflowFirst = -1; // агрегированный блок: диапазон в списке скрытых задач
+    int overflowCount = 0;
 };
 
 /**
  * @brief Вычисляет позиции задач для отображения на оверлее.
+ *
+ * Если колонок больше, чем помещается при минимальной ширине, или блоки
+ * слишком низкие, включается упрощённый уровень детализации: лишние колонки
+ * сворачиваются в последнюю, а пересекающиеся в ней (и слишком низкие)
+ * задачи объединяются в агрегированные блоки со счётчиком. Задачи вне
+ * видимой области не порождают блоков, поэтому объём работы на отрисовку
+ * ограничен числом видимых блоков.
  * @param tasks Список задач.
  * @param table Таблица для отображения.
  * @param minWidth Минимальная ширина колонки.
  * @param overlayWidth Ширина оверлея.
+ * @param overflow Сюда добавляются задачи, скрытые в агрегированных блоках.
  * @return Вектор позиций задач.
  */
 static QVector<PositionedTask> calculateTaskPositions(
-    const QVector<Task>& tasks, QTableWidget* table, int minWidth, int overlayWidth)
+    const QVector<Task>& tasks, QTableWidget* table, int minWidth, int overlayWidth, QList<Task> *overflow)
 {
-    const int totalMinutes = 24 * 60;
-
-    // 1. Сортируем задачи по времени начала
-    QVector<int> taskIndices(tasks.size());
-    std::iota(taskIndices.begin(), taskIndices.end(), 0);
-    std::sort(taskIndices.begin(), taskIndices.end(), [&](int a, int b) {
-        if (tasks[a].startDateTime() != tasks[b].startDateTime()) {
-            return tasks[a].startDateTime() < tasks[b].startDateTime();
-        }
-        return tasks[a].endDateTime() < tasks[b].endDateTime();
-    });
-
-    // 2. Распределяем задачи по колонкам
-    QVector<int> taskColumns(tasks.size(), -1);
-    QVector<QDateTime> columnEndTimes; // Хранит время окончания последней задачи в колонке
+    TRACE_SCOPE("calculateTaskPositions");
+    const int totalMinutes = ScheduleLayout::kMinutesPerDay;
+    const int minBlockHeight = 10;
 
-    for (int i : taskIndices) {
-        if (!tasks[i].isProjectTask() || !tasks[i].startDateTime().isValid() || !tasks[i].endDateTime().isValid() || tasks[i].startDateTime() >= tasks[i].endDateTime()) {
-            continue;
-        }
+    // 1-2. Сортировка и распределение по колонкам — общий движок раскладки дня
+    const QVector<ScheduleBlock> blocks = ScheduleLayout::layoutDay(tasks);
+    int globalMaxColumns = blocks.isEmpty() ? 0 : blocks.first().columnsCount;
 
-        QDateTime currentTaskStart = tasks[i].startDateTime();
-        int freeCol = -1;
-
-        // Ищем первую свободную колонку
-        for (int col = 0; col < columnEndTimes.size(); ++col) {
-            if (currentTaskStart >= columnEndTimes[col]) {
-                freeCol = col;
-                break;
-            }
-        }
-
-        if (freeCol == -1) {
-            // Если свободной колонки нет, создаем новую
-            freeCol = columnEndTimes.size();
-            columnEndTimes.append(QDateTime());
-        }
-
-        taskColumns[i] = freeCol;
-        columnEndTimes[freeCol] = tasks[i].endDateTime();
-    }
-
-    int globalMaxColumns = columnEndTimes.size();
+    // Уровень детализации: сколько колонок помещается без сужения ниже minWidth
+    const int fitColumns = std::max(1, overlayWidth / minWidth);
+    const bool lod = globalMaxColumns > fitColumns;
+    const int shownColumns = lod ? fitColumns : globalMaxColumns;
+    const int aggregateColumn = lod ? shownColumns - 1 : -1;
 
     // 3. Рассчитываем позиции и размеры задач
     QVector<PositionedTask> result;
     int viewportWidth = overlayWidth;
-    int totalWidth = std::max(viewportWidth, globalMaxColumns * minWidth);
-    int columnWidth = (globalMaxColumns > 0) ? (totalWidth / globalMaxColumns) : totalWidth;
-
-    for (int i = 0; i < tasks.size(); ++i) {
-        if (!tasks[i].isProjectTask() || taskColumns[i] == -1) continue;
+    int totalWidth = std::max(viewportWidth, shownColumns * minWidth);
+    int columnWidth = (shownColumns > 0) ? (totalWidth / shownColumns) : totalWidth;
 
-        if (!tasks[i].startDateTime().isValid() || !tasks[i].endDateTime().isValid()) continue;
-        if (tasks[i].startDateTime() >= tasks[i].endDateTime()) continue;
+    // Кандидаты в агрегаты по колонкам: верх, низ, задача
+    struct Pending { int top; int bottom; Task task; };
+    QVector<QVector<Pending>> pending(std::max(0, shownColumns));
 
-        int s = tasks[i].startDateTime().time().hour() * 60 +
-                tasks[i].startDateTime().time().minute();
-        int e = tasks[i].endDateTime().time().hour() * 60 +
-                tasks[i].endDateTime().time().minute();
-        s = std::max(0, s);
-        e = std::min(totalMinutes, e);
-        if (e <= s) e = s + 1;
+    for (const ScheduleBlock &block : blocks) {
+        int s = block.startMinute;
+        int e = block.endMinute;
 
         // Рассчитываем вертикальную позицию
         int startRow = s / 60;
@@ -145,11 +124,19 @@ static QVector<PositionedTask> calculateTaskPositions(
         int visibleBottom = std::min(table->viewport()->height(), yEnd);
         int visibleHeight = visibleBottom - visibleTop;
 
-        // Пропускаем слишком маленькие задачи
-        if (visibleHeight < 10) continue;
+        // Задачи вне экрана пропускаем, низкие и лишние колонки уходят в агрегаты
+        if (visibleHeight <= 0) continue;
+        int col = block.column;
+        if (lod && col >= aggregateColumn) {
+            pending[aggregateColumn].append({visibleTop, visibleBottom, block.task});
+            continue;
+        }
+        if (visibleHeight < minBlockHeight) {
+            pending[col].append({visibleTop, visibleBottom, block.task});
+            continue;
+        }
 
         // Рассчитываем горизонтальную позицию
-        int col = taskColumns[i];
         int left = col * columnWidth;
         int width = columnWidth;
 
@@ -157,10 +144,38 @@ static QVector<PositionedTask> calculateTaskPositions(
         if (width < minWidth) width = minWidth;
 
         result.append(PositionedTask{
-            tasks[i], visibleTop, visibleHeight, left, width, col, globalMaxColumns
+            block.task, visibleTop, visibleHeight, left, width, col, shownColumns
         });
     }
 
+    // 4. Объединяем пересекающиеся кандидаты колонки в агрегированные блоки
+    for (int col = 0; col < pending.size(); ++col) {
+        QVector<Pending> &items = pending[col];
+        std::sort(items.begin(), items.end(), [](const Pending &a, const Pending &b) {
+            return a.top < b.top;
+        });
+        for (int i = 0; i < items.size();) {
+            int top = items[i].top;
+            int bottom = std::max(items[i].bottom, top + minBlockHeight);
+            int j = i + 1;
+            while (j < items.size() && items[j].top < bottom) {
+                bottom = std::max(bottom, std::max(items[j].bottom, items[j].top + minBlockHeight));
+                ++j;
+            }
+
+            PositionedTask pt{items[i].task, top, bottom - top, col * columnWidth,
+                              std::max(columnWidth, minWidth), col, shownColumns};
+            if (j - i > 1) {
+                pt.overflowFirst = overflow->size();
+                pt.overflowCount = j - i;
+                for (int k = i; k < j; ++k)
+                    overflow->append(items[k].task);
+            }
+            result.append(pt);
+            i = j;
+        }
+    }
+
     return result;
 }
 
@@ -181,6 +196,10 @@ TaskScheduleOverlay::TaskScheduleOverlay(QTableWidget *table, TaskModel *model,
     if (m_model) {
         connect(m_model, &QAbstractItemModel::rowsInserted, this, [this]() { updateOverlay(); });
         connect(m_model, &QAbstractItemModel::rowsRemoved, this, [this]() { updateOverlay(); });
+        connect(m_model, &QAbstractItemModel::modelReset, this, [this]() {
+            m_titleLayouts.clear();
+            updateOverlay();
+        });
         connect(m_model, &QAbstractItemModel::dataChanged, this, [this]() { updateOverlay(); });
     }
     if (m_table && m_table->viewport()) {
@@ -208,7 +227,7 @@ TaskScheduleOverlay::TaskScheduleOverlay(QTableWidget *table, TaskModel *model,
     updateOverlay();
 
     m_timelineTimer = new QTimer(this);
-    connect(m_timelineTimer, &QTimer::timeout, this, QOverload<>::of(&TaskScheduleOverlay::update));
+    connect(m_timelineTimer, &QTimer::timeout, this, &TaskScheduleOverlay::updateNowLine);
     m_timelineTimer->start(60000); // Update every minute
 }
 
@@ -221,6 +240,14 @@ void TaskScheduleOverlay::updateOverlay() {
     update();
 }
 
+void TaskScheduleOverlay::setPreviewTasks(const QVector<Task> &tasks) {
+    m_previewTasks = tasks;
+    m_previewUids.clear();
+    for (const Task &task : tasks)
+        m_previewUids.insert(task.uid());
+    updateOverlay();
+}
+
 void TaskScheduleOverlay::setSelectedDate(const QDate& date) {
     if (m_selectedDate != date) {
         m_selectedDate = date;
@@ -237,42 +264,46 @@ void TaskScheduleOverlay::resizeEvent(QResizeEvent *event) {
 }
 
 void TaskScheduleOverlay::paintEvent(QPaintEvent *event) {
-    Q_UNUSED(event);
+    TRACE_SCOPE("TaskScheduleOverlay::paintEvent");
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    // Отрисовка временной сетки
-    int w = width();
-    for (int hour = 0; hour < 24; ++hour) {
-        int yHour = m_table->rowViewportPosition(hour);
-        int rowHeight = m_table->rowHeight(hour);
-
-        // Основные линии часов
-        painter.setPen(QPen(QColor(180,180,180), 2));
-        painter.drawLine(0, yHour, w, yHour);
-
-        // Подписи часов (Убрано, так как есть в заголовке)
-        // painter.setPen(QPen(QColor(200,200,200), 1));
-        // painter.drawText(5, yHour + 15, QString("%1:00").arg(hour, 2, 10, QChar('0')));
-
-        // Линии 15-минутных интервалов
-        for (int m = 15; m < 60; m += 15) {
-            int y = yHour + static_cast<int>((m / 60.0) * rowHeight);
-            painter.setPen(QPen(QColor(100,100,100), 1, Qt::DashLine));
-            painter.drawLine(0, y, w, y);
+    const QRect dirty = event->rect();
+
+    // Временная сетка берётся из заранее отрисованного изображения
+    const QPixmap &grid = gridPixmap();
+    if (!grid.isNull()) {
+        const qreal dpr = grid.devicePixelRatio();
+        const int gridTop = m_table->rowViewportPosition(0);
+        QRect gridRect(0, gridTop, qRound(grid.width() / dpr), qRound(grid.height() / dpr));
+        QRect area = dirty.intersected(gridRect);
+        if (!area.isEmpty()) {
+            QRectF source(area.x() * dpr, (area.y() - gridTop) * dpr, area.width() * dpr, area.height() * dpr);
+            painter.drawPixmap(QRectF(area), grid, source);
         }
     }
 
+    painter.setRenderHint(QPainter::Antialiasing);
 
+    // Шрифт заголовков общий для всех блоков
+    QFont font = painter.font();
+    font.setPointSize(9);
+    font.setBold(true);
+    painter.setFont(font);
 
-    // Отрисовка задач
+    // Отрисовка задач, попадающих в перерисовываемую область
     for (int i = 0; i < m_taskRects.size(); ++i) {
         const auto &rectTask = m_taskRects[i];
-        
-        QColor color = m_dataManager->getProjectColor(rectTask.task.projectType());
+        if (!rectTask.rect.intersects(dirty))
+            continue;
 
-        // Эффект при наведении
-        if (i == m_hoveredTaskIndex) {
+        const bool aggregate = rectTask.overflowCount > 0;
+        QColor color = aggregate ? QColor(110, 110, 120)
+                                 : m_dataManager->getProjectColor(rectTask.task.projectType());
+
+        // Эффект при наведении; предпросмотр — полупрозрачный с пунктирной рамкой
+        if (rectTask.preview) {
+            color.setAlpha(110);
+            painter.setPen(QPen(color.darker(150), 1.5, Qt::DashLine));
+        } else if (i == m_hoveredTaskIndex) {
             color = color.lighter(120);
             painter.setPen(QPen(QColor(220, 240, 255), 2));
         } else {
@@ -283,54 +314,188 @@ void TaskScheduleOverlay::paintEvent(QPaintEvent *event) {
         painter.setBrush(color);
         painter.drawRoundedRect(rectTask.rect.adjusted(1,1,-1,-1), 6, 6);
 
-        // Отрисовка текста
-        QFont font = painter.font();
-        font.setPointSize(9);
-        font.setBold(true);
-        painter.setFont(font);
-        painter.setPen(Qt::white);
+        // Агрегированный блок показывает только счётчик, список — по клику
+        painter.setPen(rectTask.preview ? QColor(40, 40, 40) : QColor(Qt::white));
+        if (aggregate) {
+            painter.drawText(rectTask.rect.adjusted(8, 0, -8, 0), Qt::AlignLeft | Qt::AlignVCenter,
+                             QString("+%1 задач").arg(rectTask.overflowCount));
+            continue;
+        }
 
-        // Многострочный текст с переносом
+        // Отрисовка текста: многострочная раскладка берётся из кэша
+        QRect textRect = rectTask.rect.adjusted(8, 4, -8, -4);
+        painter.save();
+        painter.setClipRect(textRect, Qt::IntersectClip);
+        painter.drawStaticText(textRect.topLeft(), titleLayout(rectTask.task, textRect.width()));
+        painter.restore();
+    }
+    // Отрисовка линии текущего времени
+    m_nowLineY = nowLineY();
+    if (m_nowLineY >= 0) {
+        painter.setPen(QPen(Qt::black, 2));
+        painter.drawLine(0, m_nowLineY, width(), m_nowLineY);
+    }
+}
+
+const QPixmap &TaskScheduleOverlay::gridPixmap() {
+    if (!m_table || m_table->rowCount() < 24) {
+        m_gridCache = QPixmap();
+        return m_gridCache;
+    }
+
+    const qreal dpr = devicePixelRatioF();
+    const int top = m_table->rowViewportPosition(0);
+    const int rowHeight = m_table->rowHeight(0);
+    const QSize size(width(), m_table->rowViewportPosition(23) + m_table->rowHeight(23) - top);
+    if (!m_gridCache.isNull() && m_gridCacheSize == size
+        && m_gridCacheRowHeight == rowHeight && qFuzzyCompare(m_gridCacheDpr, dpr)) {
+        return m_gridCache;
+    }
+    if (size.isEmpty()) {
+        m_gridCache = QPixmap();
+        return m_gridCache;
+    }
+
+    TRACE_SCOPE("TaskScheduleOverlay::renderGrid");
+    QPixmap pix(size * dpr);
+    pix.setDevicePixelRatio(dpr);
+    pix.fill(Qt::transparent);
+
+    QPainter painter(&pix);
+    painter.setRenderHint(QPainter::Antialiasing);
+    int w = size.width();
+    QPen hourPen(QColor(180,180,180), 2);
+    QPen quarterPen(QColor(100,100,100), 1, Qt::DashLine);
+    for (int hour = 0; hour < 24; ++hour) {
+        int yHour = m_table->rowViewportPosition(hour) - top;
+        int rowHeightForHour = m_table->rowHeight(hour);
+
+        // Основные линии часов
+        painter.setPen(hourPen);
+        painter.drawLine(0, yHour, w, yHour);
+
+        // Линии 15-минутных интервалов
+        painter.setPen(quarterPen);
+        for (int m = 15; m < 60; m += 15) {
+            int y = yHour + static_cast<int>((m / 60.0) * rowHeightForHour);
+            painter.drawLine(0, y, w, y);
+        }
+    }
+    painter.end();
+
+    m_gridCache = pix;
+    m_gridCacheSize = size;
+    m_gridCacheRowHeight = rowHeight;
+    m_gridCacheDpr = dpr;
+    return m_gridCache;
+}
+
+int TaskScheduleOverlay::nowLineY() const {
+    if (!m_table || m_selectedDate != QDate::currentDate())
+        return -1;
+    QTime now = QTime::currentTime();
+    int yHour = m_table->rowViewportPosition(now.hour());
+    int rowHeight = m_table->rowHeight(now.hour());
+    return yHour + static_cast<int>((now.minute() / 60.0) * rowHeight);
+}
+
+void TaskScheduleOverlay::updateNowLine() {
+    // Перерисовываем только полосы старой и новой линии времени
+    int y = nowLineY();
+    if (y == m_nowLineY)
+        return;
+    if (m_nowLineY >= 0)
+        update(QRect(0, m_nowLineY - 2, width(), 4));
+    if (y >= 0)
+        update(QRect(0, y - 2, width(), 4));
+}
+
+const QStaticText &TaskScheduleOverlay::titleLayout(const Task &task, int width) {
+    QString title = task.title();
+    size_t titleHash = qHash(title);
+    TitleLayout &layout = m_titleLayouts[task.uid()];
+    if (layout.width != width || layout.titleHash != titleHash) {
         QTextOption textOption;
         textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
         textOption.setAlignment(Qt::AlignLeft | Qt::AlignTop);
+        layout.text.setTextFormat(Qt::PlainText);
+        layout.text.setTextOption(textOption);
+        layout.text.setTextWidth(std::max(1, width));
+        layout.text.setPerformanceHint(QStaticText::AggressiveCaching);
+        layout.text.setText(title);
+        layout.width = width;
+        layout.titleHash = titleHash;
+    }
+    return layout.text;
+}
 
-        QRect textRect = rectTask.rect.adjusted(8, 4, -8, -4);
-        painter.drawText(textRect, rectTask.task.title(), textOption);
+void TaskScheduleOverlay::buildHitIndex(const QVector<PositionedTask> &positionedTasks) {
+    // m_taskRects заполняется в том же порядке, что и positionedTasks
+    for (int i = 0; i < positionedTasks.size(); ++i) {
+        const PositionedTask &pt = positionedTasks[i];
+        if (pt.column >= m_hitColumns.size())
+            m_hitColumns.resize(pt.column + 1);
+        m_hitColumns[pt.column].append(i);
+        m_hitColumnWidth = pt.width;
     }
-    // Отрисовка линии текущего времени
-    if (m_selectedDate == QDate::currentDate()) {
-        QTime now = QTime::currentTime();
-        int hour = now.hour();
-        int minute = now.minute();
-        int yHour = m_table->rowViewportPosition(hour);
-        int rowHeight = m_table->rowHeight(hour);
-        int y = yHour + static_cast<int>((minute / 60.0) * rowHeight);
+    for (QVector<int> &column : m_hitColumns) {
+        std::sort(column.begin(), column.end(), [this](int a, int b) {
+            return m_taskRects[a].rect.top() < m_taskRects[b].rect.top();
+        });
+    }
+}
 
-        painter.setPen(QPen(Qt::black, 2));
-        painter.drawLine(0, y, w, y);
+int TaskScheduleOverlay::taskIndexAt(const QPoint &pos) const {
+    if (m_hitColumnWidth <= 0 || pos.x() < 0)
+        return -1;
+    int column = pos.x() / m_hitColumnWidth;
+    if (column >= m_hitColumns.size())
+        return -1;
+
+    // Внутри колонки задачи не пересекаются по времени: ищем последнюю с top <= y
+    const QVector<int> &candidates = m_hitColumns[column];
+    auto it = std::upper_bound(candidates.begin(), candidates.end(), pos.y(), [this](int y, int index) {
+        return y < m_taskRects[index].rect.top();
+    });
+    // Из-за округления соседние прямоугольники могут касаться, поэтому проверяем два ближайших
+    for (int step = 0; step < 2 && it != candidates.begin(); ++step) {
+        --it;
+        if (m_taskRects[*it].rect.contains(pos))
+            return *it;
     }
+    return -1;
 }
 
 void TaskScheduleOverlay::mouseMoveEvent(QMouseEvent *event) {
     m_lastMousePos = event->pos();
-    int prevHovered = m_hoveredTaskIndex;
-    m_hoveredTaskIndex = -1;
 
-    for (int i = 0; i < m_taskRects.size(); ++i) {
-        if (m_taskRects[i].rect.contains(event->pos())) {
-            m_hoveredTaskIndex = i;
-            setCursor(Qt::PointingHandCursor);
-            break;
+    if (m_dragMode != NoDrag && (event->buttons() & Qt::LeftButton)) {
+        if (!m_dragActive
+            && (event->pos() - m_dragPressPos).manhattanLength() >= QApplication::startDragDistance()) {
+            m_dragActive = true;
+            m_hoveredTaskIndex = -1;
+        }
+        if (m_dragActive) {
+            updateDrag(event->pos());
+            return;
         }
     }
 
-    if (m_hoveredTaskIndex == -1) {
+    int prevHovered = m_hoveredTaskIndex;
+    m_hoveredTaskIndex = taskIndexAt(event->pos());
+    if (m_hoveredTaskIndex == -1 || m_taskRects[m_hoveredTaskIndex].preview) {
         setCursor(Qt::ArrowCursor);
+    } else {
+        setCursor(dragModeAt(m_hoveredTaskIndex, event->pos()) == DragMove ? Qt::PointingHandCursor
+                                                                           : Qt::SizeVerCursor);
     }
 
     if (prevHovered != m_hoveredTaskIndex) {
-        update();
+        // Перерисовываем только блоки, у которых сменилась подсветка
+        if (prevHovered >= 0 && prevHovered < m_taskRects.size())
+            update(m_taskRects[prevHovered].rect.adjusted(-1, -1, 1, 1));
+        if (m_hoveredTaskIndex >= 0)
+            update(m_taskRects[m_hoveredTaskIndex].rect.adjusted(-1, -1, 1, 1));
     }
 }
 
@@ -341,38 +506,229 @@ void TaskScheduleOverlay::mousePressEvent(QMouseEvent *event) {
         return;
     }
 
+    int i = taskIndexAt(event->pos());
+    if (i == -1 || event->button() != Qt::LeftButton) {
+        return;
+    }
+
+    // Агрегированный блок раскрывается существующим всплывающим списком
+    if (m_taskRects[i].overflowCount > 0) {
+        showOverflowPopup(event->globalPosition().toPoint(),
+                          m_overflowTasks.mid(m_taskRects[i].overflowFirst, m_taskRects[i].overflowCount));
+        return;
+    }
+
+    // Предпросмотр применяется только целиком из диалога автопланирования
+    if (m_taskRects[i].preview)
+        return;
+
+    const Task& task = m_taskRects[i].task;
+    QDateTime adjustedTaskEnd = QDateTime(m_selectedDate, task.endDateTime().time());
+
+    if (adjustedTaskEnd < QDateTime::currentDateTime()) {
+        return; // Не разрешать редактирование прошедших задач
+    }
+
+    // Клик или перетаскивание решается при движении/отпускании кнопки
+    m_dragMode = dragModeAt(i, event->pos());
+    m_dragActive = false;
+    m_dragIndex = i;
+    m_dragPressPos = event->pos();
+    m_dragOrigStart = m_dragStart = minuteOfDay(task.startDateTime());
+    m_dragOrigEnd = m_dragEnd = minuteOfDay(task.endDateTime());
+    m_dragCluster.clear();
+    m_dragOrigRects.clear();
+    m_dragOrigRects.reserve(m_taskRects.size());
+    for (const OverlayTaskRect &rectTask : m_taskRects)
+        m_dragOrigRects.append(rectTask.rect);
+}
+
+void TaskScheduleOverlay::mouseReleaseEvent(QMouseEvent *event) {
+    if (m_dragMode == NoDrag || event->button() != Qt::LeftButton) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+
+    const DragMode mode = m_dragMode;
+    const bool wasDragged = m_dragActive;
+    const Task task = m_taskRects.value(m_dragIndex).task;
+    m_dragMode = NoDrag;
+    m_dragActive = false;
+    m_dragCluster.clear();
+
+    if (!wasDragged) {
+        // Обычный клик — прежнее поведение: открыть редактирование
+        int proxyRow = m_proxyModel ? m_proxyModel->proxyRowForUid(task.uid()) : -1;
+        emit editTaskRequested(task, proxyRow);
+        return;
+    }
+
+    if (m_dragStart == m_dragOrigStart && m_dragEnd == m_dragOrigEnd) {
+        updateOverlay();
+        return;
+    }
+
+    // Новое время применяется к полной (не обрезанной по дню) задаче из модели: края
+    // сдвигаются на величину перетаскивания, и многодневная задача не теряет другие дни.
+    // Вхождение серии меняется отдельно: вызывающий сохранит его как исключение серии
+    if (!m_model || m_model->findTask(task.uid()) < 0) {
+        updateOverlay();
+        return;
+    }
+    Task updated = unclippedTask(task);
+    const qint64 startShift = static_cast<qint64>(m_dragStart - m_dragOrigStart) * 60;
+    const qint64 endShift = static_cast<qint64>(m_dragEnd - m_dragOrigEnd) * 60;
+    switch (mode) {
+    case DragMove:
+        updated.setStartDateTime(updated.startDateTime().addSecs(startShift));
+        updated.setEndDateTime(updated.endDateTime().addSecs(startShift));
+        break;
+    case DragResizeTop:
+        updated.setStartDateTime(updated.startDateTime().addSecs(startShift));
+        break;
+    case DragResizeBottom:
+        updated.setEndDateTime(updated.endDateTime().addSecs(endShift));
+        break;
+    case NoDrag:
+        break;
+    }
+    emit taskTimeChanged(updated);
+}
+
+TaskScheduleOverlay::DragMode TaskScheduleOverlay::dragModeAt(int index, const QPoint &pos) const {
+    const QRect &rect = m_taskRects[index].rect;
+    if (m_taskRects[index].overflowCount > 0 || rect.height() < 3 * kResizeHandle)
+        return DragMove;
+    // Край, обрезанный по дню, — не край задачи: она продолжается в соседний день
+    const bool nearTop = pos.y() - rect.top() <= kResizeHandle;
+    const bool nearBottom = !nearTop && rect.bottom() - pos.y() <= kResizeHandle;
+    if (!nearTop && !nearBottom)
+        return DragMove;
+    const Task full = unclippedTask(m_taskRects[index].task);
+    if (nearTop && full.startDateTime().date() == m_selectedDate)
+        return DragResizeTop;
+    if (nearBottom && full.endDateTime().date() == m_selectedDate)
+        return DragResizeBottom;
+    return DragMove;
+}
+
+Task TaskScheduleOverlay::unclippedTask(const Task &shown) const {
+    const int row = m_model ? m_model->findTask(shown.uid()) : -1;
+    if (row < 0)
+        return shown;
+    const Task task = m_model->getTask(row);
+    if (!shown.isOccurrence())
+        return task;
+    for (const Task &occurrence : Recurrence::expand(task, shown.occurrenceDate(), shown.occurrenceDate())) {
+        if (occurrence.occurrenceDate() == shown.occurrenceDate())
+            return occurrence;
+    }
+    return shown;
+}
+
+int TaskScheduleOverlay::minuteOfDay(const QDateTime &dateTime) const {
+    return dateTime.time().hour() * 60 + dateTime.time().minute();
+}
+
+int TaskScheduleOverlay::minuteToY(int minute) const {
+    if (minute >= ScheduleLayout::kMinutesPerDay)
+        return m_table->rowViewportPosition(23) + m_table->rowHeight(23);
+    int row = std::max(0, minute / 60);
+    return m_table->rowViewportPosition(row) + static_cast<int>((minute % 60) * (m_table->rowHeight(row) / 60.0));
+}
+
+void TaskScheduleOverlay::updateDrag(const QPoint &pos) {
+    auto snap = [](int minute) {
+        return qRound(minute / double(kSnapMinutes)) * kSnapMinutes;
+    };
+    const int rowHeight = std::max(1, m_table->rowHeight(0));
+    const int deltaMinutes = qRound((pos.y() - m_dragPressPos.y()) * 60.0 / rowHeight);
+    const int duration = m_dragOrigEnd - m_dragOrigStart;
+    const int dayMinutes = ScheduleLayout::kMinutesPerDay;
+
+    switch (m_dragMode) {
+    case DragMove:
+        m_dragStart = std::clamp(snap(m_dragOrigStart + deltaMinutes), 0, std::max(0, dayMinutes - duration));
+        m_dragEnd = m_dragStart + duration;
+        break;
+    case DragResizeTop:
+        m_dragStart = std::clamp(snap(m_dragOrigStart + deltaMinutes), 0, m_dragEnd - kSnapMinutes);
+        break;
+    case DragResizeBottom:
+        m_dragEnd = std::clamp(snap(m_dragOrigEnd + deltaMinutes), m_dragStart + kSnapMinutes, dayMinutes);
+        break;
+    case NoDrag:
+        return;
+    }
+    relayoutDragCluster();
+}
+
+void TaskScheduleOverlay::relayoutDragCluster() {
+    TRACE_SCOPE("TaskScheduleOverlay::relayoutDragCluster");
+    QRect dirty;
+
+    // Блоки прошлого кластера возвращаются на исходные места
+    for (int i : std::as_const(m_dragCluster)) {
+        dirty |= m_taskRects[i].rect;
+        m_taskRects[i].rect = m_dragOrigRects[i];
+        dirty |= m_taskRects[i].rect;
+    }
+    m_dragCluster.clear();
+
+    // Кластер — перетаскиваемый блок и все блоки, пересекающие его старое или новое место
+    const int bandTop = std::min(minuteToY(m_dragOrigStart), minuteToY(m_dragStart));
+    const int bandBottom = std::max(minuteToY(m_dragOrigEnd), minuteToY(m_dragEnd));
+    m_dragCluster.append(m_dragIndex);
     for (int i = 0; i < m_taskRects.size(); ++i) {
-        if (m_taskRects[i].rect.contains(event->pos())) {
-            if (event->button() == Qt::LeftButton) {
-                const Task& task = m_taskRects[i].task;
-                QDateTime adjustedTaskEnd = QDateTime(m_selectedDate, task.endDateTime().time());
-
-                if (adjustedTaskEnd < QDateTime::currentDateTime()) {
-                    return; // Не разрешать редактирование прошедших задач
-                }
-
-                int proxyRow = -1;
-                if (m_proxyModel) {
-                    for (int row = 0; row < m_proxyModel->rowCount(); ++row) {
-                        QModelIndex idx = m_proxyModel->index(row, 0);
-                        Task t = idx.data(TaskModel::FullTaskRole).value<Task>();
-                        if (t.uid() == m_taskRects[i].task.uid()) {
-                            proxyRow = row;
-                            break;
-                        }
-                    }
-                }
-                emit editTaskRequested(m_taskRects[i].task, proxyRow);
-            }
-            return;
+        if (i == m_dragIndex || m_taskRects[i].overflowCount > 0)
+            continue;
+        const QRect &orig = m_dragOrigRects[i];
+        if (orig.bottom() >= bandTop && orig.top() < bandBottom)
+            m_dragCluster.append(i);
+    }
+
+    auto toDateTime = [this](int minute) {
+        if (minute >= ScheduleLayout::kMinutesPerDay)
+            return QDateTime(m_selectedDate, QTime(23, 59));
+        return QDateTime(m_selectedDate, QTime(minute / 60, minute % 60));
+    };
+    QVector<Task> clusterTasks;
+    clusterTasks.reserve(m_dragCluster.size());
+    for (int i : std::as_const(m_dragCluster)) {
+        Task task = m_taskRects[i].task;
+        if (i == m_dragIndex) {
+            task.setStartDateTime(toDateTime(m_dragStart));
+            task.setEndDateTime(toDateTime(m_dragEnd));
         }
+        clusterTasks.append(task);
     }
+
+    // Заново раскладывается только кластер: он занимает всю ширину на своём отрезке времени
+    const QVector<ScheduleBlock> blocks = ScheduleLayout::layoutDay(clusterTasks);
+    if (blocks.size() == m_dragCluster.size()) {
+        const int columnWidth = width() / std::max(1, blocks.first().columnsCount);
+        for (int k = 0; k < blocks.size(); ++k) {
+            const ScheduleBlock &block = blocks[k];
+            int top = minuteToY(block.startMinute);
+            int height = std::max(10, minuteToY(block.endMinute) - top);
+            OverlayTaskRect &rectTask = m_taskRects[m_dragCluster[k]];
+            rectTask.rect = QRect(block.column * columnWidth, top, columnWidth, height);
+            dirty |= rectTask.rect;
+        }
+    }
+    update(dirty.adjusted(-2, -2, 2, 2));
 }
 
 bool TaskScheduleOverlay::event(QEvent *event) {
     if (event->type() == QEvent::ToolTip && m_hoveredTaskIndex != -1) {
         QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
-        showTaskTooltip(helpEvent->globalPos(), m_taskRects[m_hoveredTaskIndex].task);
+        const OverlayTaskRect &rectTask = m_taskRects[m_hoveredTaskIndex];
+        if (rectTask.overflowCount > 0) {
+            QToolTip::showText(helpEvent->globalPos(),
+                               QString("Задач в блоке: %1<br>Нажмите, чтобы выбрать").arg(rectTask.overflowCount), this);
+            return true;
+        }
+        showTaskTooltip(helpEvent->globalPos(), rectTask.task);
         return true;
     }
     return QWidget::event(event);
@@ -381,10 +737,8 @@ bool TaskScheduleOverlay::event(QEvent *event) {
 void TaskScheduleOverlay::mouseDoubleClickEvent(QMouseEvent *event) {
     if (!m_table || !m_proxyModel) return;
 
-    for (const auto& rectTask : m_taskRects) {
-        if (rectTask.rect.contains(event->pos())) {
-            return;
-        }
+    if (taskIndexAt(event->pos()) != -1) {
+        return;
     }
 
     setAttribute(Qt::WA_TransparentForMouseEvents, true);
@@ -397,8 +751,17 @@ void TaskScheduleOverlay::mouseDoubleClickEvent(QMouseEvent *event) {
 }
 
 void TaskScheduleOverlay::recalculateRects() {
+    PerfMonitor::Scope perfScope("recalculateRects");
+    TRACE_SCOPE("TaskScheduleOverlay::recalculateRects");
     m_taskRects.clear();
     m_overflowTasks.clear();
+    m_hitColumns.clear();
+    m_hitColumnWidth = 0;
+    m_hoveredTaskIndex = -1;
+    // Индексы блоков меняются — незавершённое перетаскивание отменяется
+    m_dragMode = NoDrag;
+    m_dragActive = false;
+    m_dragCluster.clear();
 
     if (!m_proxyModel || !m_table) {
         return;
@@ -417,46 +780,26 @@ void TaskScheduleOverlay::recalculateRects() {
             filteredTasks.append(task);
         }
     }
+    filteredTasks += m_previewTasks;
 
     // Фильтрация задач для выбранной даты
-    for (const Task& task : filteredTasks) {
-        if (!task.isProjectTask()) continue;
-        if (!task.startDateTime().isValid() || !task.endDateTime().isValid()) continue;
-        if (task.startDateTime() >= task.endDateTime()) continue;
-
-        QDate startDate = task.startDateTime().date();
-        QDate endDate = task.endDateTime().date();
-
-        if (m_selectedDate.isValid() &&
-            !(startDate <= m_selectedDate && m_selectedDate <= endDate)) {
-            continue;
-        }
-
-        // Корректировка времени для выбранной даты
-        QDateTime start = task.startDateTime();
-        QDateTime end = task.endDateTime();
-
-        if (startDate != m_selectedDate) {
-            start = QDateTime(m_selectedDate, QTime(0, 0));
-        }
-        if (endDate != m_selectedDate) {
-            end = QDateTime(m_selectedDate, QTime(23, 59));
-        }
-
-        Task adjustedTask = task;
-        adjustedTask.setStartDateTime(start);
-        adjustedTask.setEndDateTime(end);
-        tasksForDay.push_back(adjustedTask);
-    }
+    tasksForDay = ScheduleLayout::tasksForDay(filteredTasks, m_selectedDate);
 
     int minWidth = 60;
     int viewportWidth = m_table->viewport()->width();
-    auto positionedTasks = calculateTaskPositions(tasksForDay, m_table, minWidth, viewportWidth);
+    auto positionedTasks = calculateTaskPositions(tasksForDay, m_table, minWidth, viewportWidth, &m_overflowTasks);
 
     // Формируем видимые прямоугольники
     for (const auto& pt : positionedTasks) {
         QRect rect(pt.left, pt.top, pt.width, pt.height);
-        m_taskRects.append({rect, pt.task});
+        const bool preview = pt.overflowCount == 0 && m_previewUids.contains(pt.task.uid());
+        m_taskRects.append({rect, pt.task, pt.overflowFirst, pt.overflowCount, preview});
+    }
+    buildHitIndex(positionedTasks);
+
+    // Раскладки задач, ушедших с экрана, не копим бесконечно
+    if (m_titleLayouts.size() > 4 * m_taskRects.size() + 64) {
+        m_titleLayouts.clear();
     }
 
     // Рассчитываем общую ширину
@@ -492,7 +835,7 @@ void TaskScheduleOverlay::showOverflowPopup(const QPoint &pos, const QList<Task>
             .arg(task.endDateTime().toString("HH:mm"));
         QAction *action = menu.addAction(text);
         connect(action, &QAction::triggered, this, [this, task]() {
-            emit editTaskRequested(task, -1);
+            emit editTaskRequested(task, m_proxyModel ? m_proxyModel->proxyRowForUid(task.uid()) : -1);
         });
     }
     menu.exec(pos);
@@ -8,6 +8,11 @@
 #include <QWidget>
 #include <QVector>
 #include <QList> // Added
+#include <QHash>
+#include <QSet>
+#include <QStaticText>
+#include <QPixmap>
+#include <QUuid>
 #include "task.h"
 #include "taskslot.h"
 
@@ -16,6 +21,7 @@ class TaskModel;
 class TaskFilterProxyModel;
 class CustomDataManager;
 class QTimer;
+struct PositionedTask;
 
 /**
  * @struct OverlayTaskRect
@@ -24,6 +30,9 @@ class QTimer;
 struct OverlayTaskRect {
     QRect rect;
     Task task;
+    int overflowFirst = -1; ///< Для агрегированного блока — начало его задач в m_overflowTasks
+    int overflowCount = 0;  ///< Число задач в агрегированном блоке (0 — обычный блок)
+    bool preview = false;   ///< Блок предпросмотра автопланирования (не редактируется)
 };
 
 /**
@@ -47,6 +56,11 @@ public:
      * @brief Игнорировать следующий клик мыши (для предотвращения ложных срабатываний).
      */
     void ignoreNextClick();
+    /**
+     * @brief Показать предлагаемое расписание полупрозрачными блоками поверх задач.
+     * @param tasks Задачи с предлагаемым временем; пустой список снимает предпросмотр.
+     */
+    void setPreviewTasks(const QVector<Task> &tasks);
 
 signals:
     /**
@@ -55,11 +69,17 @@ signals:
      * @param proxyRow Строка в прокси-модели.
      */
     void editTaskRequested(const Task &task, int proxyRow);
+    /**
+     * @brief Время задачи изменено перетаскиванием (один раз при отпускании кнопки).
+     * @param task Задача из модели с новым временем (для повторяющейся серии — её вхождение).
+     */
+    void taskTimeChanged(const Task &task);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
     bool event(QEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
@@ -70,12 +90,87 @@ private:
     TaskFilterProxyModel *m_proxyModel;
     CustomDataManager *m_dataManager;
     QVector<OverlayTaskRect> m_taskRects;
-    QList<Task> m_overflowTasks; // Added for overflow tasks
+    QList<Task> m_overflowTasks; // задачи, свёрнутые в агрегированные блоки
+    QVector<Task> m_previewTasks; // предпросмотр автопланирования
+    QSet<QUuid> m_previewUids;
     QPoint m_lastMousePos;
     int m_hoveredTaskIndex = -1;
     QDate m_selectedDate; // новое поле
     bool m_ignoreNextClick = false;
     QTimer* m_timelineTimer;
+
+    /**
+     * @brief Закэшированная раскладка заголовка задачи.
+     */
+    struct TitleLayout {
+        size_t titleHash = 0;
+        int width = -1;
+        QStaticText text;
+    };
+    QHash<QUuid, TitleLayout> m_titleLayouts;
+    /**
+     * @brief Раскладка заголовка для заданной ширины (из кэша, если не изменилась).
+     */
+    const QStaticText &titleLayout(const Task &task, int width);
+
+    QPixmap m_gridCache;
+    QSize m_gridCacheSize;
+    int m_gridCacheRowHeight = -1;
+    qreal m_gridCacheDpr = 0.0;
+    int m_nowLineY = -1;
+    /**
+     * @brief Сетка часов и четвертей часа, отрисованная один раз на (размер, высота строки, DPR).
+     */
+    const QPixmap &gridPixmap();
+    /**
+     * @brief Координата линии текущего времени или -1, если выбран не сегодняшний день.
+     */
+    int nowLineY() const;
+    /**
+     * @brief Перерисовать полосу линии текущего времени (по таймеру).
+     */
+    void updateNowLine();
+
+    /**
+     * @brief Пространственный индекс: для каждой колонки раскладки — индексы m_taskRects по возрастанию top.
+     */
+    QVector<QVector<int>> m_hitColumns;
+    int m_hitColumnWidth = 0;
+    void buildHitIndex(const QVector<PositionedTask> &positionedTasks);
+    /**
+     * @brief Индекс задачи под точкой (O(log n)) или -1.
+     */
+    int taskIndexAt(const QPoint &pos) const;
+
+    /**
+     * @brief Перетаскивание блока: перенос целиком или изменение начала/конца.
+     */
+    enum DragMode { NoDrag, DragMove, DragResizeTop, DragResizeBottom };
+    static constexpr int kSnapMinutes = 5;
+    static constexpr int kResizeHandle = 5;
+    DragMode m_dragMode = NoDrag;
+    bool m_dragActive = false;       // кнопка нажата и сдвинута дальше порога
+    int m_dragIndex = -1;
+    QPoint m_dragPressPos;
+    int m_dragOrigStart = 0;         // минуты от начала выбранного дня
+    int m_dragOrigEnd = 0;
+    int m_dragStart = 0;
+    int m_dragEnd = 0;
+    QVector<int> m_dragCluster;      // блоки, разложенные заново на текущем шаге
+    QVector<QRect> m_dragOrigRects;  // положения блоков до начала перетаскивания
+    DragMode dragModeAt(int index, const QPoint &pos) const;
+    /**
+     * @brief Задача блока целиком — блок хранит копию, обрезанную по выбранному дню.
+     */
+    Task unclippedTask(const Task &shown) const;
+    int minuteOfDay(const QDateTime &dateTime) const;
+    int minuteToY(int minute) const;
+    void updateDrag(const QPoint &pos);
+    /**
+     * @brief Переразложить только затронутый кластер и перерисовать его область.
+     */
+    void relayoutDragCluster();
+
     void recalculateRects();
     void showTaskTooltip(const QPoint &pos, const Task &task);
     void showOverflowPopup(const QPoint &pos, const QList<Task> &tasks);
@@ -0,0 +1,430 @@
+/**
+ * @file tasksync.cpp
+ * @brief Реализация потокового слияния двух файлов задач.
+ */
+#include "tasksync.h"
+#include "lockedsavefile.h"
+#include "taskmodel.h"
+#include "tracing.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMap>
+#include <QSaveFile>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QUuid>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr qint64 ChunkSize = 1024 * 1024;
+
+/**
+ * @brief Потоковое чтение элементов массива задач без разбора всего документа.
+ *
+ * Массив — первая '[' вне строк: так читаются и конверт {"version", "tasks"},
+ * и старый формат (массив без номера записи).
+ */
+class ArrayReader
+{
+public:
+    explicit ArrayReader(QIODevice *device) : m_device(device) {}
+
+    /**
+     * @brief Следующий элемент массива в байтах, как он записан в файле.
+     * @return false — массив кончился или файл оборван (см. failed).
+     */
+    bool next(QByteArray &element);
+    bool failed() const { return m_failed; }
+
+private:
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    qsizetype m_pos = 0;
+    bool m_inArray = false;
+    bool m_done = false;
+    bool m_failed = false;
+
+    /**
+     * @brief Дочитать кусок файла; байты до keepFrom больше не нужны и отбрасываются.
+     */
+    bool fill(qsizetype &keepFrom);
+};
+
+bool ArrayReader::fill(qsizetype &keepFrom)
+{
+    const QByteArray chunk = m_device->read(ChunkSize);
+    if (chunk.isEmpty()) {
+        m_failed = true;
+        return false;
+    }
+    // Сдвиг буфера — раз на кусок, а не на элемент
+    m_buffer.remove(0, keepFrom);
+    m_pos -= keepFrom;
+    keepFrom = 0;
+    m_buffer.append(chunk);
+    return true;
+}
+
+bool ArrayReader::next(QByteArray &element)
+{
+    if (m_done || m_failed)
+        return false;
+    bool inString = false;
+    bool escaped = false;
+    while (!m_inArray) {
+        qsizetype keep = m_pos;
+        if (m_pos == m_buffer.size() && !fill(keep))
+            return false;
+        const char c = m_buffer.at(m_pos++);
+        if (inString) {
+            if (escaped)
+                escaped = false;
+            else if (c == '\\')
+                escaped = true;
+            else if (c == '"')
+                inString = false;
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '[') {
+            m_inArray = true;
+        }
+    }
+
+    for (;;) {
+        qsizetype keep = m_pos;
+        if (m_pos == m_buffer.size() && !fill(keep))
+            return false;
+        const char c = m_buffer.at(m_pos);
+        if (c == ']') {
+            m_done = true;
+            return false;
+        }
+        if (c != ',' && c != ' ' && c != '\n' && c != '\r' && c != '\t')
+            break;
+        ++m_pos;
+    }
+    if (m_buffer.at(m_pos) != '{') {
+        m_failed = true;
+        return false;
+    }
+
+    qsizetype start = m_pos;
+    int depth = 0;
+    inString = false;
+    escaped = false;
+    for (;;) {
+        if (m_pos == m_buffer.size() && !fill(start))
+            return false;
+        const char c = m_buffer.at(m_pos++);
+        if (inString) {
+            if (escaped)
+                escaped = false;
+            else if (c == '\\')
+                escaped = true;
+            else if (c == '"')
+                inString = false;
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            element = m_buffer.mid(start, m_pos - start);
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Корзина по UID: первое слово случайного UID распределено равномерно и не зависит от сборки.
+ */
+int bucketOf(const QUuid &uid)
+{
+    return int(uid.data1 % TaskSync::BucketCount);
+}
+
+QString bucketPath(const QString &dir, char side, int bucket)
+{
+    return QString("%1/%2%3.jsonl").arg(dir).arg(side).arg(bucket);
+}
+
+/**
+ * @brief Разложить задачи файла по корзинам, по строке компактного JSON на задачу.
+ *
+ * Отсутствующий файл — пустое хранилище (первая синхронизация в новое место).
+ */
+bool partition(const QString &path, const QString &dir, char side, QString *error)
+{
+    TRACE_SCOPE("TaskSync::partition");
+    QFile file(path);
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("Не удалось открыть %1").arg(path);
+        return false;
+    }
+    std::vector<std::unique_ptr<QFile>> buckets;
+    buckets.reserve(TaskSync::BucketCount);
+    for (int bucket = 0; bucket < TaskSync::BucketCount; ++bucket) {
+        buckets.push_back(std::make_unique<QFile>(bucketPath(dir, side, bucket)));
+        if (!buckets.back()->open(QIODevice::WriteOnly)) {
+            *error = "Не удалось создать временный файл";
+            return false;
+        }
+    }
+
+    ArrayReader reader(&file);
+    QByteArray element;
+    while (reader.next(element)) {
+        QJsonParseError parseError;
+        const QJsonObject object = QJsonDocument::fromJson(element, &parseError).object();
+        const QUuid uid(object["uid"].toString());
+        if (parseError.error != QJsonParseError::NoError || uid.isNull()) {
+            *error = QString("Повреждённая запись задачи в %1").arg(path);
+            return false;
+        }
+        buckets[bucketOf(uid)]->write(QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n');
+    }
+    if (reader.failed()) {
+        *error = QString("%1 оборван или не является файлом задач").arg(path);
+        return false;
+    }
+    return true;
+}
+
+QVector<QJsonObject> readBucket(const QString &path)
+{
+    QVector<QJsonObject> result;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+    while (!file.atEnd())
+        result.append(QJsonDocument::fromJson(file.readLine()).object());
+    return result;
+}
+
+QByteArray compactValue(const QJsonValue &value)
+{
+    return value.isUndefined() ? QByteArray() : QJsonDocument(QJsonArray{value}).toJson(QJsonDocument::Compact);
+}
+
+qint64 msecs(const QJsonValue &isoDate)
+{
+    return QDateTime::fromString(isoDate.toString(), Qt::ISODate).toMSecsSinceEpoch();
+}
+
+/**
+ * @brief Самая поздняя правка задачи по её отметкам; без отметок — никакой.
+ */
+qint64 latestEdit(const QJsonObject &stamps)
+{
+    qint64 latest = std::numeric_limits<qint64>::min();
+    for (auto it = stamps.constBegin(); it != stamps.constEnd(); ++it)
+        latest = std::max(latest, it.value().toInteger());
+    return latest;
+}
+
+QJsonObject conflictRecord(const QJsonObject &task, const QString &field,
+                           const QJsonValue &leftValue, qint64 leftStamp,
+                           const QJsonValue &rightValue, qint64 rightStamp, bool leftWins)
+{
+    QJsonObject record;
+    record["uid"] = task["uid"];
+    record["title"] = task["title"];
+    record["field"] = field;
+    record["left"] = leftValue.isUndefined() ? QJsonValue() : leftValue;
+    record["right"] = rightValue.isUndefined() ? QJsonValue() : rightValue;
+    record["leftAt"] = QDateTime::fromMSecsSinceEpoch(leftStamp).toString(Qt::ISODateWithMs);
+    record["rightAt"] = QDateTime::fromMSecsSinceEpoch(rightStamp).toString(Qt::ISODateWithMs);
+    record["winner"] = leftWins ? "left" : "right";
+    return record;
+}
+
+} // namespace
+
+QJsonObject TaskSync::mergeTask(const QJsonObject &left, const QJsonObject &right,
+                                const QDateTime &since, QVector<QJsonObject> *conflicts)
+{
+    const QJsonObject leftStamps = left["stamps"].toObject();
+    const QJsonObject rightStamps = right["stamps"].toObject();
+    const qint64 leftCreated = msecs(left["creationDateTime"]);
+    const qint64 rightCreated = msecs(right["creationDateTime"]);
+    const qint64 sinceMs = since.isValid() ? since.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+
+    QSet<QString> keySet;
+    for (auto it = left.constBegin(); it != left.constEnd(); ++it)
+        keySet.insert(it.key());
+    for (auto it = right.constBegin(); it != right.constEnd(); ++it)
+        keySet.insert(it.key());
+    keySet.remove("stamps");
+    keySet.remove("deletedAt");
+    QStringList keys = keySet.values();
+    std::sort(keys.begin(), keys.end());
+
+    QJsonObject result;
+    QJsonObject stamps;
+    for (const QString &key : std::as_const(keys)) {
+        const QJsonValue leftValue = left.value(key);
+        const QJsonValue rightValue = right.value(key);
+        const bool leftStamped = leftStamps.contains(key);
+        const bool rightStamped = rightStamps.contains(key);
+        const qint64 leftStamp = leftStamped ? leftStamps[key].toInteger() : leftCreated;
+        const qint64 rightStamp = rightStamped ? rightStamps[key].toInteger() : rightCreated;
+        if (leftStamped || rightStamped)
+            stamps.insert(key, std::max(leftStamp, rightStamp));
+        if (leftValue == rightValue) {
+            if (!leftValue.isUndefined())
+                result.insert(key, leftValue);
+            continue;
+        }
+        // Равные отметки решает само значение — иначе результат зависел бы от порядка хранилищ
+        const bool leftWins = leftStamp != rightStamp ? leftStamp > rightStamp
+                                                      : compactValue(leftValue) > compactValue(rightValue);
+        const QJsonValue &value = leftWins ? leftValue : rightValue;
+        if (!value.isUndefined())
+            result.insert(key, value);
+        if (conflicts && leftStamped && rightStamped && leftStamp > sinceMs && rightStamp > sinceMs)
+            conflicts->append(conflictRecord(left, key, leftValue, leftStamp, rightValue, rightStamp, leftWins));
+    }
+    if (!stamps.isEmpty())
+        result["stamps"] = stamps;
+
+    const bool leftDeleted = left.contains("deletedAt");
+    const bool rightDeleted = right.contains("deletedAt");
+    if (leftDeleted && rightDeleted) {
+        result["deletedAt"] = msecs(left["deletedAt"]) >= msecs(right["deletedAt"]) ? left["deletedAt"] : right["deletedAt"];
+    } else if (leftDeleted || rightDeleted) {
+        // Удаление против правки: задача остаётся, только если её правили после удаления
+        const QJsonValue deletedAt = leftDeleted ? left["deletedAt"] : right["deletedAt"];
+        const qint64 deletedStamp = msecs(deletedAt);
+        const qint64 editStamp = latestEdit(leftDeleted ? rightStamps : leftStamps);
+        const bool deletionWins = deletedStamp >= editStamp;
+        if (deletionWins)
+            result["deletedAt"] = deletedAt;
+        if (conflicts && editStamp > sinceMs && deletedStamp > sinceMs) {
+            const qint64 leftStamp = leftDeleted ? deletedStamp : editStamp;
+            const qint64 rightStamp = leftDeleted ? editStamp : deletedStamp;
+            conflicts->append(conflictRecord(left, "deletedAt", left.value("deletedAt"), leftStamp,
+                                             right.value("deletedAt"), rightStamp, deletionWins == leftDeleted));
+        }
+    }
+    return result;
+}
+
+TaskSync::Result TaskSync::merge(const QString &leftPath, const QString &rightPath, const QString &outputPath,
+                                 const QString &reportPath, const QDateTime &since)
+{
+    TRACE_SCOPE("TaskSync::merge");
+    Result result;
+    QTemporaryDir spill;
+    if (!spill.isValid()) {
+        result.error = "Не удалось создать временный каталог";
+        return result;
+    }
+    // Номера записи берутся до чтения: файл, заменённый позже, даст stale, а не потерю правок
+    result.leftVersion = TaskModel::readTasksFileVersion(leftPath);
+    result.rightVersion = TaskModel::readTasksFileVersion(rightPath);
+    if (!partition(leftPath, spill.path(), 'l', &result.error)
+        || !partition(rightPath, spill.path(), 'r', &result.error))
+        return result;
+
+    QFile report(reportPath);
+    if (!reportPath.isEmpty() && !report.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        result.error = QString("Не удалось открыть %1").arg(reportPath);
+        return result;
+    }
+
+    result.version = std::max(result.leftVersion, result.rightVersion) + 1;
+    // Контрольная сумма стоит в конверте перед задачами, поэтому массив сначала пишется
+    // во временный файл, а сумма считается по ходу записи
+    QFile body(spill.filePath("tasks.json"));
+    if (!body.open(QIODevice::ReadWrite)) {
+        result.error = "Не удалось создать временный файл";
+        return result;
+    }
+    QCryptographicHash checksum(QCryptographicHash::Sha1);
+    auto writeBody = [&body, &checksum](const QByteArray &bytes) {
+        body.write(bytes);
+        checksum.addData(bytes);
+    };
+    writeBody("[");
+
+    struct Entry {
+        QJsonObject object;
+        bool left = false;
+        bool right = false;
+    };
+    QVector<QJsonObject> conflicts;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        QMap<QUuid, Entry> tasks; // по UID: порядок результата не зависит от порядка во входных файлах
+        for (const QJsonObject &object : readBucket(bucketPath(spill.path(), 'l', bucket))) {
+            Entry &entry = tasks[QUuid(object["uid"].toString())];
+            entry.object = object;
+            entry.left = true;
+        }
+        for (const QJsonObject &object : readBucket(bucketPath(spill.path(), 'r', bucket))) {
+            Entry &entry = tasks[QUuid(object["uid"].toString())];
+            if (entry.object.isEmpty()) {
+                entry.object = object;
+            } else {
+                conflicts.clear();
+                entry.object = mergeTask(entry.object, object, since, &conflicts);
+                result.conflicts += conflicts.size();
+                for (const QJsonObject &conflict : std::as_const(conflicts)) {
+                    if (report.isOpen())
+                        report.write(QJsonDocument(conflict).toJson(QJsonDocument::Compact) + '\n');
+                }
+            }
+            entry.right = true;
+        }
+
+        for (const Entry &entry : std::as_const(tasks)) {
+            writeBody(result.tasks == 0 ? "\n        " : ",\n        ");
+            writeBody(QJsonDocument(entry.object).toJson(QJsonDocument::Compact));
+            ++result.tasks;
+            if (entry.left && entry.right)
+                ++result.merged;
+            else if (entry.left)
+                ++result.onlyLeft;
+            else
+                ++result.onlyRight;
+        }
+    }
+    writeBody("\n    ]\n");
+
+    // Тот же конверт, что пишет TaskModel::saveTasks: номер записи, контрольная сумма, задачи
+    QSaveFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly)) {
+        result.error = QString("Не удалось записать %1").arg(outputPath);
+        return result;
+    }
+    output.write("{\n    \"version\": " + QByteArray::number(result.version) + ",\n    \"checksum\": \""
+                 + checksum.result().toHex() + "\",\n    \"tasks\": ");
+    body.seek(0);
+    while (!body.atEnd())
+        output.write(body.read(ChunkSize));
+    output.write("}\n");
+
+    const LockedSaveFile::Result written = LockedSaveFile::commit(output, [&]() {
+        return TaskModel::readTasksFileVersion(leftPath) == result.leftVersion
+            && TaskModel::readTasksFileVersion(rightPath) == result.rightVersion;
+    });
+    if (written == LockedSaveFile::Stale) {
+        result.stale = true;
+        result.error = "Файлы задач изменились во время синхронизации";
+        return result;
+    }
+    if (written == LockedSaveFile::Failed) {
+        qWarning() << "Couldn't write" << outputPath;
+        result.error = QString("Не удалось записать %1").arg(outputPath);
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file tasksync.h
+ * @brief Двустороннее слияние двух файлов задач по UID и отметкам изменения полей.
+ */
+
+#ifndef TASKSYNC_H
+#define TASKSYNC_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class TaskSync
+ * @brief Слияние двух хранилищ задач (tasks.json с разных машин) в третий файл.
+ *
+ * Задачи сопоставляются по UID, поля — по отметкам Task::fieldStamps:
+ * побеждает значение с более поздней отметкой, при равных отметках —
+ * большее в компактной записи JSON, поэтому результат не зависит от того,
+ * какое хранилище левое. Удаление (запись корзины с deletedAt) побеждает,
+ * если после него задачу по другую сторону не правили.
+ *
+ * Файлы не читаются в память целиком: массив задач разбирается потоком
+ * и раскладывается по BucketCount временным файлам по UID, затем корзины
+ * сливаются по одной. В памяти — одна корзина обеих сторон, то есть
+ * примерно 1/BucketCount задач. Порядок задач в результате — по корзинам
+ * и UID, а не по исходным спискам.
+ */
+class TaskSync
+{
+public:
+    static constexpr int BucketCount = 64;
+
+    /**
+     * @brief Итог слияния.
+     */
+    struct Result {
+        bool ok = false;
+        bool stale = false;  ///< Входной файл изменился во время слияния — результат не записан, нужно повторить
+        QString error;       ///< Причина неудачи для показа пользователю
+        qint64 version = 0;  ///< Номер записи файла-результата
+        qint64 leftVersion = 0;  ///< Номера записи входных файлов, с которыми шло слияние
+        qint64 rightVersion = 0;
+        int tasks = 0;       ///< Записей в результате, вместе с корзиной
+        int merged = 0;      ///< Задач, найденных в обоих хранилищах
+        int onlyLeft = 0;
+        int onlyRight = 0;
+        int conflicts = 0;   ///< Полей, изменённых по обе стороны по-разному
+    };
+
+    /**
+     * @brief Слить два файла задач в outputPath.
+     *
+     * Результат записывается через LockedSaveFile, так что outputPath может
+     * совпадать с одним из входных файлов. Если за время слияния номер записи
+     * входного файла сменился, результат не пишется и возвращается stale:
+     * иначе чужая запись потерялась бы. Номер записи — больший из двух плюс один.
+     * @param reportPath Файл отчёта о конфликтах (по строке JSON на поле); пустой — без отчёта.
+     * @param since Время прошлой синхронизации: правки до него конфликтами не считаются.
+     */
+    static Result merge(const QString &leftPath, const QString &rightPath, const QString &outputPath,
+                        const QString &reportPath = QString(), const QDateTime &since = QDateTime());
+
+    /**
+     * @brief Слить две версии одной задачи (JSON-объекты формата tasks.json).
+     * @param conflicts Сюда добавляются записи о конфликтующих полях; nullptr — не собирать.
+     */
+    static QJsonObject mergeTask(const QJsonObject &left, const QJsonObject &right,
+                                 const QDateTime &since = QDateTime(),
+                                 QVector<QJsonObject> *conflicts = nullptr);
+};
+
+#endif // TASKSYNC_H
@@ -0,0 +1,249 @@
+/**
+ * @file tasktreemodel.cpp
+ * @brief Реализация дерева задач с ленивой загрузкой уровней.
+ */
+#include "tasktreemodel.h"
+#include "taskmodel.h"
+#include "tracing.h"
+#include <algorithm>
+#include <utility>
+
+TaskTreeModel::TaskTreeModel(TaskModel *model, QObject *parent)
+    : QAbstractItemModel(parent), m_model(model)
+{
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &TaskTreeModel::onRowsInserted);
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &TaskTreeModel::onRowsAboutToBeRemoved);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, [this]() {
+        // Прогресс бывших родителей уже пересчитан моделью
+        const QVector<QUuid> ancestors = std::exchange(m_pendingAncestors, {});
+        for (const QUuid &uid : ancestors)
+            emitChangedWithAncestors(uid);
+    });
+    connect(m_model, &QAbstractItemModel::dataChanged, this, &TaskTreeModel::onDataChanged);
+    connect(m_model, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+        beginResetModel();
+        deleteChildren(&m_root);
+        m_pendingAncestors.clear();
+    });
+    connect(m_model, &QAbstractItemModel::modelReset, this, [this]() { endResetModel(); });
+}
+
+TaskTreeModel::~TaskTreeModel()
+{
+    deleteChildren(&m_root);
+}
+
+TaskTreeModel::Node *TaskTreeModel::nodeForIndex(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return const_cast<Node *>(&m_root);
+    return static_cast<Node *>(index.internalPointer());
+}
+
+QModelIndex TaskTreeModel::indexForNode(Node *node, int column) const
+{
+    if (!node || node == &m_root)
+        return QModelIndex();
+    return createIndex(node->parent->children.indexOf(node), column, node);
+}
+
+QModelIndex TaskTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column < 0 || column >= TaskModel::ColumnCount || parent.column() > 0)
+        return QModelIndex();
+    const Node *parentNode = nodeForIndex(parent);
+    if (row >= parentNode->children.size())
+        return QModelIndex();
+    return createIndex(row, column, parentNode->children[row]);
+}
+
+QModelIndex TaskTreeModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid())
+        return QModelIndex();
+    return indexForNode(nodeForIndex(child)->parent);
+}
+
+int TaskTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return 0;
+    return nodeForIndex(parent)->children.size();
+}
+
+int TaskTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return TaskModel::ColumnCount;
+}
+
+bool TaskTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return false;
+    // Стрелка разворачивания видна и у незагруженного уровня
+    return m_model->childCount(nodeForIndex(parent)->uid) > 0;
+}
+
+bool TaskTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return false;
+    const Node *node = nodeForIndex(parent);
+    return m_model->childCount(node->uid) > node->children.size();
+}
+
+void TaskTreeModel::fetchMore(const QModelIndex &parent)
+{
+    TRACE_SCOPE("TaskTreeModel::fetchMore");
+    if (parent.column() > 0)
+        return;
+    Node *node = nodeForIndex(parent);
+    const QVector<QUuid> uids = m_model->childUids(node->uid);
+    const int first = node->children.size();
+    const int last = std::min<int>(uids.size(), first + FetchBatch) - 1;
+    if (last < first)
+        return;
+
+    beginInsertRows(indexForNode(node), first, last);
+    for (int i = first; i <= last; ++i) {
+        Node *child = new Node{uids[i], node, {}};
+        node->children.append(child);
+        m_nodes.insert(child->uid, child);
+    }
+    endInsertRows();
+}
+
+QVariant TaskTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    const QUuid uid = nodeForIndex(index)->uid;
+    const int row = m_model->findTask(uid);
+    if (row < 0)
+        return QVariant();
+
+    const QVariant value = m_model->data(m_model->index(row, index.column()), role);
+    if (role == Qt::DisplayRole && index.column() == TaskModel::TitleColumn) {
+        const TaskModel::Progress progress = m_model->progress(uid);
+        if (progress.total > 0)
+            return QString("%1 (%2/%3)").arg(value.toString()).arg(progress.done).arg(progress.total);
+    }
+    return value;
+}
+
+QVariant TaskTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    return m_model->headerData(section, orientation, role);
+}
+
+Qt::ItemFlags TaskTreeModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+}
+
+QUuid TaskTreeModel::uidForIndex(const QModelIndex &index) const
+{
+    return index.isValid() ? nodeForIndex(index)->uid : QUuid();
+}
+
+QModelIndex TaskTreeModel::indexForUid(const QUuid &uid, int column) const
+{
+    return indexForNode(m_nodes.value(uid), column);
+}
+
+void TaskTreeModel::deleteChildren(Node *node)
+{
+    for (Node *child : std::as_const(node->children)) {
+        deleteChildren(child);
+        m_nodes.remove(child->uid);
+        delete child;
+    }
+    node->children.clear();
+}
+
+void TaskTreeModel::removeNode(const QUuid &uid)
+{
+    Node *node = m_nodes.value(uid);
+    if (!node)
+        return;
+    Node *parentNode = node->parent;
+    const int row = parentNode->children.indexOf(node);
+    beginRemoveRows(indexForNode(parentNode), row, row);
+    parentNode->children.removeAt(row);
+    deleteChildren(node);
+    m_nodes.remove(uid);
+    delete node;
+    endRemoveRows();
+}
+
+void TaskTreeModel::insertNodeIfFetched(const QUuid &uid)
+{
+    const QUuid parentUid = m_model->parentOf(uid);
+    Node *parentNode = parentUid.isNull() ? &m_root : m_nodes.value(parentUid);
+    if (!parentNode)
+        return;
+    // Задача должна стать сразу за последним загруженным узлом; иначе её подгрузит fetchMore
+    const QVector<QUuid> siblings = m_model->childUids(parentUid);
+    const int row = parentNode->children.size();
+    if (siblings.size() != row + 1 || siblings.last() != uid)
+        return;
+
+    beginInsertRows(indexForNode(parentNode), row, row);
+    Node *node = new Node{uid, parentNode, {}};
+    parentNode->children.append(node);
+    m_nodes.insert(uid, node);
+    endInsertRows();
+}
+
+void TaskTreeModel::emitChangedWithAncestors(const QUuid &uid)
+{
+    for (QUuid current = uid; !current.isNull(); current = m_model->parentOf(current)) {
+        Node *node = m_nodes.value(current);
+        if (!node)
+            continue;
+        const QModelIndex left = indexForNode(node);
+        emit dataChanged(left, left.siblingAtColumn(TaskModel::ColumnCount - 1));
+    }
+}
+
+void TaskTreeModel::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    for (int row = first; row <= last; ++row) {
+        const QUuid uid = m_model->tasks()[row].uid();
+        insertNodeIfFetched(uid);
+        emitChangedWithAncestors(m_model->parentOf(uid));
+    }
+}
+
+void TaskTreeModel::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    for (int row = first; row <= last; ++row) {
+        const QUuid uid = m_model->tasks()[row].uid();
+        m_pendingAncestors.append(m_model->parentOf(uid));
+        removeNode(uid);
+    }
+}
+
+void TaskTreeModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const QUuid uid = m_model->tasks()[row].uid();
+        const QUuid parentUid = m_model->parentOf(uid);
+        Node *node = m_nodes.value(uid);
+        if (node && node->parent->uid != parentUid) {
+            // Перенос к другому родителю: узел уходит со старого места вместе с загруженным поддеревом
+            const QUuid oldParentUid = node->parent->uid;
+            removeNode(uid);
+            emitChangedWithAncestors(oldParentUid);
+            node = nullptr;
+        }
+        if (!node)
+            insertNodeIfFetched(uid);
+        emitChangedWithAncestors(uid);
+    }
+}
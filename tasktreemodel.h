@@ -0,0 +1,111 @@
+/**
+ * @file tasktreemodel.h
+ * @brief Дерево задач и подзадач с ленивой загрузкой уровней.
+ */
+
+#ifndef TASKTREEMODEL_H
+#define TASKTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QUuid>
+#include <QVector>
+
+class TaskModel;
+
+/**
+ * @class TaskTreeModel
+ * @brief Иерархическое представление плоской TaskModel по Task::parentUid.
+ *
+ * Узлы дерева создаются только для развёрнутых уровней: уровень
+ * материализуется через canFetchMore/fetchMore порциями по FetchBatch
+ * строк, а hasChildren отвечает по индексу подзадач TaskModel, не создавая
+ * узлов. Изменения TaskModel переносятся точечно — вставкой, удалением
+ * или переносом одного узла.
+ */
+class TaskTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Сколько подзадач материализуется за один вызов fetchMore.
+     */
+    static constexpr int FetchBatch = 100;
+
+    /**
+     * @brief Конструктор TaskTreeModel.
+     * @param model Плоская модель задач (источник данных и иерархии).
+     * @param parent Родительский объект.
+     */
+    explicit TaskTreeModel(TaskModel *model, QObject *parent = nullptr);
+    ~TaskTreeModel() override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    /**
+     * @brief Данные задачи из TaskModel; к названию добавляется прогресс подзадач.
+     */
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    /**
+     * @brief Исходная плоская модель.
+     */
+    TaskModel *taskModel() const { return m_model; }
+    /**
+     * @brief UID задачи в узле index.
+     */
+    QUuid uidForIndex(const QModelIndex &index) const;
+    /**
+     * @brief Индекс уже материализованного узла задачи (невалидный, если уровень не загружен).
+     */
+    QModelIndex indexForUid(const QUuid &uid, int column = 0) const;
+    /**
+     * @brief Число созданных узлов (для диагностики ленивой загрузки).
+     */
+    int materializedCount() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        QUuid uid;
+        Node *parent = nullptr;
+        QVector<Node *> children;
+    };
+
+    TaskModel *m_model;
+    Node m_root;
+    QHash<QUuid, Node *> m_nodes; // только материализованные узлы
+
+    Node *nodeForIndex(const QModelIndex &index) const;
+    QModelIndex indexForNode(Node *node, int column = 0) const;
+    void deleteChildren(Node *node);
+    /**
+     * @brief Убрать узел задачи (с поддеревом) из дерева, если он материализован.
+     */
+    void removeNode(const QUuid &uid);
+    /**
+     * @brief Добавить узел задачи, если её новый родитель уже полностью загружен.
+     *
+     * Подзадачи TaskModel добавляются в конец списка родителя, поэтому
+     * загруженные узлы всегда остаются префиксом этого списка.
+     */
+    void insertNodeIfFetched(const QUuid &uid);
+    /**
+     * @brief Сообщить об изменении задачи и прогресса её загруженных предков.
+     */
+    void emitChangedWithAncestors(const QUuid &uid);
+
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+    QVector<QUuid> m_pendingAncestors; // родители удаляемых строк до rowsRemoved
+};
+
+#endif // TASKTREEMODEL_H
@@ -0,0 +1,219 @@
+/**
+ * @file taskundostack.cpp
+ * @brief Реализация стека отмены и повтора изменений задач.
+ */
+#include "taskundostack.h"
+#include "taskmodel.h"
+#include "tracing.h"
+#include <QJsonDocument>
+#include <utility>
+
+/**
+ * @brief Перенести поля в объект задачи; null означает, что поля нет.
+ */
+/**
+ * @brief UID, под которым задача была в модели до изменения.
+ */
+static QUuid uidBefore(const QJsonObject &before, const QUuid &uidAfter)
+{
+    return before.contains("uid") ? QUuid(before["uid"].toString()) : uidAfter;
+}
+
+TaskUndoStack::TaskUndoStack(TaskModel *model, QObject *parent)
+    : QObject(parent), m_model(model)
+{
+    connect(m_model, &TaskModel::taskInserted, this, &TaskUndoStack::onTaskInserted);
+    connect(m_model, &TaskModel::taskAboutToBeRemoved, this, &TaskUndoStack::onTaskAboutToBeRemoved);
+    connect(m_model, &TaskModel::taskUpdated, this, &TaskUndoStack::onTaskUpdated);
+    // После загрузки файла UID из истории могут ничего не значить
+    connect(m_model, &QAbstractItemModel::modelReset, this, &TaskUndoStack::clear);
+}
+
+void TaskUndoStack::beginGroup(const QString &text)
+{
+    if (m_groupDepth++ == 0)
+        m_open = Step{text, {}, 0};
+}
+
+void TaskUndoStack::endGroup()
+{
+    if (m_groupDepth == 0 || --m_groupDepth > 0)
+        return;
+    Step step = std::exchange(m_open, Step());
+    if (!step.changes.isEmpty())
+        push(std::move(step));
+}
+
+QString TaskUndoStack::undoText() const
+{
+    return m_undo.isEmpty() ? QString() : m_undo.last().text;
+}
+
+QString TaskUndoStack::redoText() const
+{
+    return m_redo.isEmpty() ? QString() : m_redo.last().text;
+}
+
+void TaskUndoStack::undo()
+{
+    if (m_undo.isEmpty())
+        return;
+    TRACE_SCOPE("TaskUndoStack::undo");
+    Step step = m_undo.takeLast();
+    apply(step, false);
+    m_redo.append(std::move(step));
+    emit changed();
+}
+
+void TaskUndoStack::redo()
+{
+    if (m_redo.isEmpty())
+        return;
+    TRACE_SCOPE("TaskUndoStack::redo");
+    Step step = m_redo.takeLast();
+    apply(step, true);
+    m_undo.append(std::move(step));
+    emit changed();
+}
+
+void TaskUndoStack::clear()
+{
+    if (m_undo.isEmpty() && m_redo.isEmpty())
+        return;
+    m_undo.clear();
+    m_redo.clear();
+    m_bytesUsed = 0;
+    emit changed();
+}
+
+void TaskUndoStack::setByteBudget(qint64 bytes)
+{
+    m_byteBudget = bytes;
+    enforceBudget();
+    emit changed();
+}
+
+void TaskUndoStack::onTaskInserted(int row)
+{
+    const Task task = m_model->getTask(row);
+    record(Change{Change::Insert, task.uid(), {}, TaskModel::taskToJson(task), m_model->isRestoringTask()},
+           QString("Добавление «%1»").arg(task.title()));
+}
+
+void TaskUndoStack::onTaskAboutToBeRemoved(int row)
+{
+    const Task task = m_model->getTask(row);
+    record(Change{Change::Remove, task.uid(), TaskModel::taskToJson(task), {}},
+           QString("Удаление «%1»").arg(task.title()));
+}
+
+void TaskUndoStack::onTaskUpdated(int row, const Task &before)
+{
+    if (m_applying || m_pauseDepth > 0 || m_model->isApplyingTasksFile())
+        return;
+    const Task task = m_model->getTask(row);
+    const TaskModel::FieldDiff diff = TaskModel::diffFields(before, task);
+    if (!diff.isEmpty())
+        record(Change{Change::Update, task.uid(), diff.before, diff.after},
+               QString("Изменение «%1»").arg(task.title()));
+}
+
+void TaskUndoStack::record(const Change &change, const QString &text)
+{
+    // Изменения, пришедшие из файла другого процесса, отменять нечем и незачем
+    if (m_applying || m_pauseDepth > 0 || m_model->isApplyingTasksFile())
+        return;
+    if (m_groupDepth == 0) {
+        push(Step{text, {change}, 0});
+        return;
+    }
+
+    // Правки одной задачи подряд внутри шага сливаются в одну запись
+    if (change.kind == Change::Update && !m_open.changes.isEmpty()) {
+        Change &last = m_open.changes.last();
+        if (last.kind == Change::Insert && last.uid == uidBefore(change.before, change.uid)) {
+            TaskModel::applyFields(last.after, change.after);
+            last.uid = change.uid;
+            return;
+        }
+        if (last.kind == Change::Update && last.uid == uidBefore(change.before, change.uid)) {
+            for (auto it = change.before.constBegin(); it != change.before.constEnd(); ++it) {
+                if (!last.before.contains(it.key()))
+                    last.before.insert(it.key(), it.value());
+            }
+            for (auto it = change.after.constBegin(); it != change.after.constEnd(); ++it)
+                last.after.insert(it.key(), it.value());
+            const QStringList keys = last.after.keys();
+            for (const QString &key : keys) {
+                if (last.before.value(key) == last.after.value(key)) {
+                    last.before.remove(key);
+                    last.after.remove(key);
+                }
+            }
+            last.uid = change.uid;
+            if (last.before.isEmpty())
+                m_open.changes.removeLast();
+            return;
+        }
+    }
+    m_open.changes.append(change);
+}
+
+void TaskUndoStack::push(Step step)
+{
+    step.bytes = sizeOf(step);
+    for (const Step &dropped : std::as_const(m_redo))
+        m_bytesUsed -= dropped.bytes;
+    m_redo.clear();
+    m_bytesUsed += step.bytes;
+    m_undo.append(std::move(step));
+    enforceBudget();
+    emit changed();
+}
+
+void TaskUndoStack::enforceBudget()
+{
+    // Сначала уходят самые старые шаги отмены, затем самые дальние шаги повтора
+    while (m_bytesUsed > m_byteBudget && m_undo.size() + m_redo.size() > 1) {
+        QVector<Step> &from = m_undo.isEmpty() ? m_redo : m_undo;
+        m_bytesUsed -= from.first().bytes;
+        from.removeFirst();
+    }
+}
+
+void TaskUndoStack::apply(const Step &step, bool forward)
+{
+    m_applying = true;
+    for (int i = 0; i < step.changes.size(); ++i) {
+        const Change &change = step.changes[forward ? i : step.changes.size() - 1 - i];
+        const bool insert = (change.kind == Change::Insert) == forward;
+        if (change.kind != Change::Update) {
+            // Восстановленная задача встаёт в конец списка. Отменённое добавление
+            // не оставляет задачу в корзине, если она пришла не оттуда
+            if (insert)
+                m_model->addTask(TaskModel::taskFromJson(forward ? change.after : change.before));
+            else
+                m_model->removeTask(m_model->findTask(change.uid),
+                                    change.kind == Change::Remove || change.fromTrash);
+            continue;
+        }
+        const int row = m_model->findTask(forward ? uidBefore(change.before, change.uid) : change.uid);
+        if (row < 0)
+            continue;
+        QJsonObject object = TaskModel::taskToJson(m_model->getTask(row));
+        TaskModel::applyFields(object, forward ? change.after : change.before);
+        m_model->updateTask(row, TaskModel::taskFromJson(object));
+    }
+    m_applying = false;
+}
+
+qint64 TaskUndoStack::sizeOf(const Step &step)
+{
+    qint64 bytes = sizeof(Step) + step.text.size() * sizeof(QChar);
+    for (const Change &change : step.changes) {
+        bytes += sizeof(Change);
+        bytes += QJsonDocument(change.before).toJson(QJsonDocument::Compact).size();
+        bytes += QJsonDocument(change.after).toJson(QJsonDocument::Compact).size();
+    }
+    return bytes;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file taskundostack.h
+ * @brief Стек отмены и повтора изменений задач.
+ */
+
+#ifndef TASKUNDOSTACK_H
+#define TASKUNDOSTACK_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QString>
+#include <QUuid>
+#include <QVector>
+
+class TaskModel;
+class Task;
+
+/**
+ * @class TaskUndoStack
+ * @brief Отмена и повтор изменений TaskModel по сигналам модели.
+ *
+ * Для изменения задачи хранится только разница: поля JSON-представления
+ * (TaskModel::taskToJson), значения которых изменились, до и после, по UID
+ * задачи. Полная запись хранится лишь для добавленной или удалённой задачи.
+ * Отмена применяет старые значения полей к текущему состоянию задачи,
+ * поэтому не затирает поля, изменённые позже другими шагами.
+ *
+ * Изменения между beginGroup и endGroup образуют один шаг; повторные правки
+ * одной задачи внутри шага сливаются. Размер истории ограничен бюджетом
+ * в байтах: при превышении отбрасываются самые старые шаги.
+ */
+class TaskUndoStack : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr qint64 DefaultByteBudget = 4 * 1024 * 1024;
+
+    /**
+     * @brief Один шаг на время жизни объекта (beginGroup/endGroup).
+     */
+    class Group
+    {
+    public:
+        Group(TaskUndoStack *stack, const QString &text) : m_stack(stack) { m_stack->beginGroup(text); }
+        ~Group() { m_stack->endGroup(); }
+        Group(const Group &) = delete;
+        Group &operator=(const Group &) = delete;
+
+    private:
+        TaskUndoStack *m_stack;
+    };
+
+    /**
+     * @brief Изменения на время жизни объекта не записываются (служебные правки вроде просрочки).
+     */
+    class Pause
+    {
+    public:
+        explicit Pause(TaskUndoStack *stack) : m_stack(stack) { ++m_stack->m_pauseDepth; }
+        ~Pause() { --m_stack->m_pauseDepth; }
+        Pause(const Pause &) = delete;
+        Pause &operator=(const Pause &) = delete;
+
+    private:
+        TaskUndoStack *m_stack;
+    };
+
+    /**
+     * @brief Конструктор TaskUndoStack.
+     * @param model Модель, изменения которой записываются.
+     * @param parent Родительский объект.
+     */
+    explicit TaskUndoStack(TaskModel *model, QObject *parent = nullptr);
+
+    /**
+     * @brief Начать шаг из нескольких изменений; вложенные группы входят во внешнюю.
+     * @param text Название шага для меню «Отменить».
+     */
+    void beginGroup(const QString &text);
+    void endGroup();
+
+    bool canUndo() const { return !m_undo.isEmpty(); }
+    bool canRedo() const { return !m_redo.isEmpty(); }
+    QString undoText() const;
+    QString redoText() const;
+    int count() const { return m_undo.size(); }
+
+    /**
+     * @brief Отменить последний шаг.
+     */
+    void undo();
+    /**
+     * @brief Повторить последний отменённый шаг.
+     */
+    void redo();
+    /**
+     * @brief Забыть всю историю.
+     */
+    void clear();
+
+    /**
+     * @brief Ограничить память истории (отмена и повтор вместе); последний шаг сохраняется всегда.
+     * @param bytes Бюджет в байтах.
+     */
+    void setByteBudget(qint64 bytes);
+    qint64 byteBudget() const { return m_byteBudget; }
+    /**
+     * @brief Оценка памяти, занятой историей.
+     */
+    qint64 bytesUsed() const { return m_bytesUsed; }
+
+signals:
+    /**
+     * @brief Изменилась доступность отмены или повтора.
+     */
+    void changed();
+
+private:
+    struct Change {
+        enum Kind { Insert, Remove, Update };
+        Kind kind = Update;
+        QUuid uid;          // UID задачи после изменения (для удаления — удалённой)
+        QJsonObject before; // для Update — только изменившиеся поля; null — поля не было
+        QJsonObject after;
+        bool fromTrash = false; // Insert: задача возвращена из корзины, отмена кладёт её обратно
+    };
+    struct Step {
+        QString text;
+        QVector<Change> changes;
+        qint64 bytes = 0;
+    };
+
+    TaskModel *m_model;
+    QVector<Step> m_undo; // последний элемент — следующий для отмены
+    QVector<Step> m_redo; // последний элемент — следующий для повтора
+    Step m_open;          // шаг открытой группы
+    int m_groupDepth = 0;
+    int m_pauseDepth = 0;
+    bool m_applying = false;
+    qint64 m_byteBudget = DefaultByteBudget;
+    qint64 m_bytesUsed = 0;
+
+    void onTaskInserted(int row);
+    void onTaskAboutToBeRemoved(int row);
+    void onTaskUpdated(int row, const Task &before);
+    void record(const Change &change, const QString &text);
+    void push(Step step);
+    void enforceBudget();
+    /**
+     * @brief Применить шаг: назад (отмена) или вперёд (повтор).
+     */
+    void apply(const Step &step, bool forward);
+    static qint64 sizeOf(const Step &step);
+};
+
+#endif // TASKUNDOSTACK_H
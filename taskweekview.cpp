@@ -0,0 +1,461 @@
+/**
+ * @file taskweekview.cpp
+ * @brief Реализация недельного вида задач по времени.
+ */
+#include "taskweekview.h"
+#include "taskmodel.h"
+#include "customdatamanager.h"
+#include "perfmonitor.h"
+#include "tracing.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QSignalBlocker>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QLocale>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+QDate weekStart(const QDate &date)
+{
+    return date.addDays(1 - date.dayOfWeek());
+}
+
+/**
+ * @brief Раскладки набора дней; выполняется в пуле потоков над копией списка задач.
+ */
+QHash<QDate, QVector<ScheduleBlock>> computeLayouts(const QVector<Task> &tasks, const QVector<QDate> &days)
+{
+    TRACE_SCOPE("TaskWeekView::prefetch");
+    QHash<QDate, QVector<ScheduleBlock>> result;
+    if (days.isEmpty())
+        return result;
+    auto range = std::minmax_element(days.begin(), days.end());
+    const QHash<QDate, QVector<Task>> byDay = ScheduleLayout::tasksByDay(tasks, *range.first, *range.second);
+    for (const QDate &day : days)
+        result.insert(day, ScheduleLayout::layoutDay(byDay.value(day)));
+    return result;
+}
+
+} // namespace
+
+TaskWeekView::TaskWeekView(TaskModel *model, CustomDataManager *dataManager, QWidget *parent)
+    : QAbstractScrollArea(parent), m_model(model), m_dataManager(dataManager)
+{
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    m_prefetchWatcher = new QFutureWatcher<DayLayouts>(this);
+    connect(m_prefetchWatcher, &QFutureWatcherBase::finished, this, &TaskWeekView::onPrefetchFinished);
+    connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, &TaskWeekView::onHorizontalScroll);
+
+    if (m_model) {
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, &TaskWeekView::invalidateLayouts);
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, &TaskWeekView::invalidateLayouts);
+        connect(m_model, &QAbstractItemModel::dataChanged, this, &TaskWeekView::invalidateLayouts);
+        connect(m_model, &QAbstractItemModel::modelReset, this, &TaskWeekView::invalidateLayouts);
+        connect(m_model, &QAbstractItemModel::layoutChanged, this, &TaskWeekView::invalidateLayouts);
+    }
+
+    updateScrollBars();
+    setWeek(QDate::currentDate());
+    verticalScrollBar()->setValue(8 * m_hourHeight); // начало рабочего дня
+}
+
+TaskWeekView::~TaskWeekView()
+{
+    m_prefetchWatcher->waitForFinished();
+}
+
+void TaskWeekView::setWeek(const QDate &date)
+{
+    if (!date.isValid())
+        return;
+    {
+        QSignalBlocker blocker(horizontalScrollBar());
+        horizontalScrollBar()->setValue(kVisibleDays * m_dayWidth);
+    }
+    const QDate newStart = weekStart(date).addDays(-kVisibleDays);
+    if (m_windowStart.isValid()) {
+        shiftWindow(static_cast<int>(m_windowStart.daysTo(newStart)));
+    } else {
+        m_windowStart = newStart;
+        schedulePrefetch();
+    }
+    emitVisibleWeek();
+    viewport()->update();
+}
+
+QDate TaskWeekView::visibleWeekStart() const
+{
+    // Неделя, которой принадлежит средний видимый день
+    int middle = (horizontalScrollBar()->value() + kVisibleDays * m_dayWidth / 2) / m_dayWidth;
+    return weekStart(m_windowStart.addDays(middle));
+}
+
+void TaskWeekView::scrollWeeks(int weeks)
+{
+    // Окно перецентрируется в onHorizontalScroll, поэтому шаг больше недели делаем по одной
+    for (int i = 0; i < std::abs(weeks); ++i) {
+        QScrollBar *bar = horizontalScrollBar();
+        bar->setValue(bar->value() + (weeks > 0 ? 1 : -1) * kVisibleDays * m_dayWidth);
+    }
+}
+
+void TaskWeekView::invalidateLayouts()
+{
+    m_dayLayouts.clear();
+    ++m_revision;
+    schedulePrefetch();
+    viewport()->update();
+}
+
+void TaskWeekView::ensureLayouts(const QVector<QDate> &days)
+{
+    QVector<QDate> missing;
+    for (const QDate &day : days) {
+        if (!m_dayLayouts.contains(day))
+            missing.append(day);
+    }
+    if (missing.isEmpty() || !m_model)
+        return;
+
+    PerfMonitor::Scope perfScope("weekLayout");
+    TRACE_SCOPE("TaskWeekView::ensureLayouts");
+    // Задачи распределяются по дням за один проход, затем дни раскладываются параллельно
+    const QHash<QDate, QVector<Task>> byDay =
+        ScheduleLayout::tasksByDay(m_model->tasks(), missing.first(), missing.last());
+    const QList<QVector<ScheduleBlock>> layouts =
+        QtConcurrent::blockingMapped<QList<QVector<ScheduleBlock>>>(missing, [&byDay](const QDate &day) {
+            return ScheduleLayout::layoutDay(byDay.value(day));
+        });
+    for (int i = 0; i < missing.size(); ++i)
+        m_dayLayouts.insert(missing[i], layouts[i]);
+}
+
+void TaskWeekView::schedulePrefetch()
+{
+    if (!m_model || !m_windowStart.isValid())
+        return;
+    if (m_prefetchWatcher->isRunning()) {
+        m_prefetchAgain = true;
+        return;
+    }
+
+    // Видимые дни посчитает отрисовка, в фоне готовим только соседние недели
+    int firstVisible = 0;
+    int lastVisible = -1;
+    visibleDayRange(&firstVisible, &lastVisible);
+    QVector<QDate> days;
+    for (int i = 0; i < kWindowDays; ++i) {
+        QDate day = m_windowStart.addDays(i);
+        if ((i < firstVisible || i > lastVisible) && !m_dayLayouts.contains(day))
+            days.append(day);
+    }
+    if (days.isEmpty())
+        return;
+
+    m_prefetchRevision = m_revision;
+    // Копия вектора неявно разделяемая: модель может меняться, фоновая задача увидит снимок
+    const QVector<Task> tasks = m_model->tasks();
+    m_prefetchWatcher->setFuture(QtConcurrent::run(computeLayouts, tasks, days));
+}
+
+void TaskWeekView::onPrefetchFinished()
+{
+    // Результат по устаревшей версии модели отбрасываем
+    if (m_prefetchWatcher->future().resultCount() > 0 && m_prefetchRevision == m_revision) {
+        const DayLayouts layouts = m_prefetchWatcher->result();
+        const QDate windowEnd = m_windowStart.addDays(kWindowDays - 1);
+        for (auto it = layouts.constBegin(); it != layouts.constEnd(); ++it) {
+            if (it.key() >= m_windowStart && it.key() <= windowEnd && !m_dayLayouts.contains(it.key()))
+                m_dayLayouts.insert(it.key(), it.value());
+        }
+    }
+    if (m_prefetchAgain) {
+        m_prefetchAgain = false;
+        schedulePrefetch();
+    }
+}
+
+void TaskWeekView::onHorizontalScroll(int value)
+{
+    QScrollBar *bar = horizontalScrollBar();
+    const int weekWidth = kVisibleDays * m_dayWidth;
+
+    // У края окна сдвигаем его на неделю и переносим позицию, не прерывая прокрутку
+    if (value < m_dayWidth / 2) {
+        {
+            QSignalBlocker blocker(bar);
+            bar->setValue(value + weekWidth);
+        }
+        shiftWindow(-kVisibleDays);
+    } else if (value > bar->maximum() - m_dayWidth / 2) {
+        {
+            QSignalBlocker blocker(bar);
+            bar->setValue(value - weekWidth);
+        }
+        shiftWindow(kVisibleDays);
+    }
+    emitVisibleWeek();
+    viewport()->update();
+}
+
+void TaskWeekView::shiftWindow(int days)
+{
+    if (days == 0 || !m_windowStart.isValid())
+        return;
+    m_windowStart = m_windowStart.addDays(days);
+
+    const QDate windowEnd = m_windowStart.addDays(kWindowDays - 1);
+    for (auto it = m_dayLayouts.begin(); it != m_dayLayouts.end();) {
+        if (it.key() < m_windowStart || it.key() > windowEnd)
+            it = m_dayLayouts.erase(it);
+        else
+            ++it;
+    }
+    schedulePrefetch();
+}
+
+void TaskWeekView::updateScrollBars()
+{
+    QScrollBar *hbar = horizontalScrollBar();
+    const int oldDayWidth = m_dayWidth;
+    const int oldValue = hbar->value();
+    m_dayWidth = std::max(kMinDayWidth, (viewport()->width() - kTimeAxisWidth) / kVisibleDays);
+    {
+        QSignalBlocker blocker(hbar);
+        hbar->setRange(0, (kWindowDays - kVisibleDays) * m_dayWidth);
+        hbar->setPageStep(kVisibleDays * m_dayWidth);
+        hbar->setSingleStep(std::max(1, m_dayWidth / 4));
+        // Сохраняем положение в днях при изменении ширины дня
+        hbar->setValue(static_cast<int>(static_cast<qint64>(oldValue) * m_dayWidth / oldDayWidth));
+    }
+
+    QScrollBar *vbar = verticalScrollBar();
+    const int bodyHeight = std::max(0, viewport()->height() - kHeaderHeight);
+    vbar->setRange(0, std::max(0, 24 * m_hourHeight - bodyHeight));
+    vbar->setPageStep(bodyHeight);
+    vbar->setSingleStep(m_hourHeight / 4);
+}
+
+void TaskWeekView::emitVisibleWeek()
+{
+    QDate monday = visibleWeekStart();
+    if (monday != m_lastVisibleWeek) {
+        m_lastVisibleWeek = monday;
+        emit visibleWeekChanged(monday);
+    }
+}
+
+void TaskWeekView::visibleDayRange(int *first, int *last) const
+{
+    const int xOffset = horizontalScrollBar()->value();
+    *first = std::clamp(xOffset / m_dayWidth, 0, kWindowDays - 1);
+    *last = std::clamp((xOffset + viewport()->width() - kTimeAxisWidth) / m_dayWidth, 0, kWindowDays - 1);
+}
+
+int TaskWeekView::dayX(int dayIndex) const
+{
+    return kTimeAxisWidth + dayIndex * m_dayWidth - horizontalScrollBar()->value();
+}
+
+int TaskWeekView::minuteY(int minute) const
+{
+    return kHeaderHeight + minute * m_hourHeight / 60 - verticalScrollBar()->value();
+}
+
+QRect TaskWeekView::blockRect(int dayIndex, const ScheduleBlock &block) const
+{
+    const int inner = m_dayWidth - 4;
+    const int columns = std::max(1, block.columnsCount);
+    const int left = dayX(dayIndex) + 2 + block.column * inner / columns;
+    const int right = dayX(dayIndex) + 2 + (block.column + 1) * inner / columns;
+    const int top = minuteY(block.startMinute);
+    const int bottom = std::max(top + 4, minuteY(block.endMinute));
+    return QRect(left, top, right - left, bottom - top);
+}
+
+const ScheduleBlock *TaskWeekView::blockAt(const QPoint &pos) const
+{
+    if (pos.x() < kTimeAxisWidth || pos.y() < kHeaderHeight)
+        return nullptr;
+    const int dayIndex = (pos.x() - kTimeAxisWidth + horizontalScrollBar()->value()) / m_dayWidth;
+    auto it = m_dayLayouts.constFind(m_windowStart.addDays(dayIndex));
+    if (it == m_dayLayouts.constEnd())
+        return nullptr;
+    for (const ScheduleBlock &block : it.value()) {
+        if (blockRect(dayIndex, block).contains(pos))
+            return &block;
+    }
+    return nullptr;
+}
+
+void TaskWeekView::paintEvent(QPaintEvent *event)
+{
+    TRACE_SCOPE("TaskWeekView::paintEvent");
+    QPainter painter(viewport());
+    const QRect dirty = event->rect();
+    const int w = viewport()->width();
+    const int h = viewport()->height();
+    painter.fillRect(dirty, palette().base());
+
+    // Раскладываются только видимые дни окна
+    int firstDay = 0;
+    int lastDay = -1;
+    visibleDayRange(&firstDay, &lastDay);
+    QVector<QDate> visibleDays;
+    for (int i = firstDay; i <= lastDay; ++i)
+        visibleDays.append(m_windowStart.addDays(i));
+    ensureLayouts(visibleDays);
+
+    // Видимые часы
+    const int yOffset = verticalScrollBar()->value();
+    const int firstHour = std::clamp(yOffset / m_hourHeight, 0, 23);
+    const int lastHour = std::clamp((yOffset + h - kHeaderHeight) / m_hourHeight, 0, 23);
+    const int firstMinute = firstHour * 60;
+    const int lastMinute = (lastHour + 1) * 60;
+
+    const QRect body(kTimeAxisWidth, kHeaderHeight, w - kTimeAxisWidth, h - kHeaderHeight);
+    painter.save();
+    painter.setClipRect(body.intersected(dirty));
+
+    // Сетка часов и границы дней
+    painter.setPen(QPen(QColor(210, 210, 210), 1));
+    for (int hour = firstHour; hour <= lastHour + 1; ++hour) {
+        int y = minuteY(hour * 60);
+        painter.drawLine(body.left(), y, body.right(), y);
+    }
+    for (int i = firstDay; i <= lastDay + 1; ++i) {
+        int x = dayX(i);
+        painter.drawLine(x, body.top(), x, body.bottom());
+    }
+
+    // Блоки задач, пересекающие видимый диапазон
+    painter.setRenderHint(QPainter::Antialiasing);
+    QFont font = painter.font();
+    font.setPointSize(8);
+    font.setBold(true);
+    painter.setFont(font);
+    const QFontMetrics metrics(font);
+    for (int i = firstDay; i <= lastDay; ++i) {
+        auto it = m_dayLayouts.constFind(m_windowStart.addDays(i));
+        if (it == m_dayLayouts.constEnd())
+            continue;
+        for (const ScheduleBlock &block : it.value()) {
+            if (block.endMinute <= firstMinute || block.startMinute >= lastMinute)
+                continue;
+            QRect rect = blockRect(i, block);
+            if (!rect.intersects(dirty))
+                continue;
+
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(m_dataManager ? m_dataManager->getProjectColor(block.task.projectType())
+                                           : QColor(100, 149, 237));
+            painter.drawRoundedRect(rect.adjusted(1, 1, -1, -1), 4, 4);
+
+            QRect textRect = rect.adjusted(4, 2, -4, -2);
+            if (textRect.height() >= metrics.height() && textRect.width() > 0) {
+                painter.setPen(Qt::white);
+                painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop,
+                                 metrics.elidedText(block.task.title(), Qt::ElideRight, textRect.width()));
+            }
+        }
+    }
+
+    // Линия текущего времени
+    const int todayIndex = static_cast<int>(m_windowStart.daysTo(QDate::currentDate()));
+    if (todayIndex >= firstDay && todayIndex <= lastDay) {
+        QTime now = QTime::currentTime();
+        int y = minuteY(now.hour() * 60 + now.minute());
+        painter.setPen(QPen(Qt::black, 2));
+        painter.drawLine(dayX(todayIndex), y, dayX(todayIndex + 1), y);
+    }
+    painter.restore();
+
+    // Шкала часов
+    const QFontMetrics axisMetrics = fontMetrics();
+    painter.save();
+    painter.setClipRect(QRect(0, kHeaderHeight, kTimeAxisWidth, h - kHeaderHeight).intersected(dirty));
+    painter.fillRect(0, kHeaderHeight, kTimeAxisWidth, h - kHeaderHeight, palette().window());
+    painter.setPen(palette().color(QPalette::WindowText));
+    for (int hour = firstHour; hour <= lastHour; ++hour) {
+        painter.drawText(QRect(0, minuteY(hour * 60), kTimeAxisWidth - 6, axisMetrics.height()),
+                         Qt::AlignRight | Qt::AlignTop, QString("%1:00").arg(hour, 2, 10, QChar('0')));
+    }
+    painter.restore();
+
+    // Заголовки дней
+    painter.save();
+    painter.setClipRect(QRect(0, 0, w, kHeaderHeight).intersected(dirty));
+    painter.fillRect(0, 0, w, kHeaderHeight, palette().window());
+    painter.setClipRect(QRect(kTimeAxisWidth, 0, w - kTimeAxisWidth, kHeaderHeight).intersected(dirty));
+    painter.setPen(palette().color(QPalette::WindowText));
+    QFont headerFont = font;
+    headerFont.setPointSize(9);
+    QLocale locale;
+    for (int i = firstDay; i <= lastDay; ++i) {
+        QDate date = m_windowStart.addDays(i);
+        headerFont.setBold(date == QDate::currentDate());
+        painter.setFont(headerFont);
+        painter.drawText(QRect(dayX(i), 0, m_dayWidth, kHeaderHeight), Qt::AlignCenter,
+                         locale.toString(date, "ddd dd.MM"));
+    }
+    painter.restore();
+}
+
+void TaskWeekView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+    emitVisibleWeek();
+}
+
+void TaskWeekView::wheelEvent(QWheelEvent *event)
+{
+    // Shift + колесо прокручивает дни
+    if (event->modifiers() & Qt::ShiftModifier) {
+        QScrollBar *bar = horizontalScrollBar();
+        bar->setValue(bar->value() - event->angleDelta().y() * m_dayWidth / 240);
+        event->accept();
+        return;
+    }
+    QAbstractScrollArea::wheelEvent(event);
+}
+
+void TaskWeekView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const ScheduleBlock *block = blockAt(event->pos());
+    if (block && event->button() == Qt::LeftButton) {
+        emit editTaskRequested(block->task.uid());
+        return;
+    }
+    QAbstractScrollArea::mouseDoubleClickEvent(event);
+}
+
+bool TaskWeekView::viewportEvent(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+        const ScheduleBlock *block = blockAt(helpEvent->pos());
+        if (block) {
+            QString text = QString("<b>%1</b><br>"
+                                   "Проект: %2<br>"
+                                   "Время: %3 - %4")
+                               .arg(block->task.title())
+                               .arg(block->task.projectType())
+                               .arg(block->task.startDateTime().toString("dd.MM.yyyy HH:mm"))
+                               .arg(block->task.endDateTime().toString("dd.MM.yyyy HH:mm"));
+            QToolTip::showText(helpEvent->globalPos(), text, viewport());
+        } else {
+            QToolTip::hideText();
+        }
+        return true;
+    }
+    return QAbstractScrollArea::viewportEvent(event);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file taskweekview.h
+ * @brief Недельный вид задач по времени с виртуализированной отрисовкой.
+ */
+
+#ifndef TASKWEEKVIEW_H
+#define TASKWEEKVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QDate>
+#include <QHash>
+#include <QFutureWatcher>
+#include <QUuid>
+#include "schedulelayout.h"
+
+class TaskModel;
+class CustomDataManager;
+
+/**
+ * @class TaskWeekView
+ * @brief Семь дней рядом, каждый раскладывается тем же движком, что и дневной оверлей.
+ *
+ * Вид держит «окно» из трёх недель (предыдущая, текущая, следующая) и
+ * прокручивается по нему горизонтально попиксельно; у края окна оно
+ * сдвигается на неделю, поэтому прокрутка между неделями непрерывна.
+ * Раскладки видимых дней считаются параллельно, соседние недели
+ * подготавливаются в фоне. Рисуются только видимые дни и часы.
+ * Показываются все проектные задачи модели, без учёта фильтров списка.
+ */
+class TaskWeekView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Конструктор TaskWeekView.
+     * @param model Модель задач.
+     * @param dataManager Менеджер пользовательских данных (цвета проектов).
+     * @param parent Родительский виджет.
+     */
+    TaskWeekView(TaskModel *model, CustomDataManager *dataManager, QWidget *parent = nullptr);
+    ~TaskWeekView() override;
+
+    /**
+     * @brief Показать неделю, содержащую дату.
+     * @param date Дата.
+     */
+    void setWeek(const QDate &date);
+    /**
+     * @brief Понедельник недели, занимающей большую часть экрана.
+     */
+    QDate visibleWeekStart() const;
+    /**
+     * @brief Прокрутить на неделю вперёд или назад.
+     * @param weeks Число недель (отрицательное — назад).
+     */
+    void scrollWeeks(int weeks);
+
+signals:
+    /**
+     * @brief Сменилась видимая неделя.
+     * @param monday Понедельник недели.
+     */
+    void visibleWeekChanged(const QDate &monday);
+    /**
+     * @brief Запрос на редактирование задачи (двойной клик по блоку).
+     * @param uid Идентификатор задачи.
+     */
+    void editTaskRequested(const QUuid &uid);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    bool viewportEvent(QEvent *event) override;
+
+private:
+    using DayLayouts = QHash<QDate, QVector<ScheduleBlock>>;
+
+    static constexpr int kWindowDays = 21;
+    static constexpr int kVisibleDays = 7;
+    static constexpr int kTimeAxisWidth = 48;
+    static constexpr int kHeaderHeight = 28;
+    static constexpr int kMinDayWidth = 90;
+
+    TaskModel *m_model;
+    CustomDataManager *m_dataManager;
+    QDate m_windowStart;   // первый день окна (понедельник предыдущей недели)
+    int m_dayWidth = kMinDayWidth;
+    int m_hourHeight = 40;
+    QDate m_lastVisibleWeek;
+
+    DayLayouts m_dayLayouts;     // раскладки дней окна
+    quint64 m_revision = 0;      // растёт при любом изменении модели
+    QFutureWatcher<DayLayouts> *m_prefetchWatcher;
+    quint64 m_prefetchRevision = 0;
+    bool m_prefetchAgain = false;
+
+    /**
+     * @brief Сбросить раскладки после изменения модели.
+     */
+    void invalidateLayouts();
+    /**
+     * @brief Посчитать недостающие раскладки дней параллельно и дождаться результата.
+     */
+    void ensureLayouts(const QVector<QDate> &days);
+    /**
+     * @brief Подготовить в фоне раскладки дней окна, которых ещё нет в кэше.
+     */
+    void schedulePrefetch();
+    void onPrefetchFinished();
+    void onHorizontalScroll(int value);
+    /**
+     * @brief Сдвинуть окно на заданное число дней, отбросив раскладки вне окна.
+     */
+    void shiftWindow(int days);
+    void updateScrollBars();
+    void emitVisibleWeek();
+    /**
+     * @brief Индексы (в окне) первого и последнего видимых дней.
+     */
+    void visibleDayRange(int *first, int *last) const;
+
+    int dayX(int dayIndex) const;
+    int minuteY(int minute) const;
+    QRect blockRect(int dayIndex, const ScheduleBlock &block) const;
+    /**
+     * @brief Блок под точкой вьюпорта или nullptr.
+     */
+    const ScheduleBlock *blockAt(const QPoint &pos) const;
+};
+
+#endif // TASKWEEKVIEW_H
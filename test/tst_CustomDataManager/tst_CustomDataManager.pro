@@ -9,9 +9,13 @@ TEMPLATE = app
 
 SOURCES +=  \
     tst_customdatamanager.cpp \
-    ../../customdatamanager.cpp
+    ../../customdatamanager.cpp \
+    ../../lockedsavefile.cpp \
+    ../../tracing.cpp
 
 HEADERS += \
-    ../../customdatamanager.h
+    ../../customdatamanager.h \
+    ../../lockedsavefile.h \
+    ../../tracing.h
 
 INCLUDEPATH += ../../
@@ -11,6 +11,9 @@ class CustomDataManagerTest : public QObject
 
 private slots:
     void initTestCase() {
+        // Файлы данных и журнал уходят в тестовый каталог, а не в данные пользователя; каждый прогон — с чистого
+        QStandardPaths::setTestModeEnabled(true);
+        QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
         // Set up a temporary directory for test files
         m_tempPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/CustomDataManagerTest";
         QDir dir(m_tempPath);
@@ -155,6 +158,62 @@ private slots:
         delete newManager;
     }
 
+    // Теги получают постоянные ID при первом использовании
+    void testTagInterning() {
+        const int urgent = m_manager->internTag("Срочно");
+        QVERIFY(urgent >= 0);
+        QCOMPARE(m_manager->internTag(" Срочно "), urgent);
+        const int report = m_manager->internTag("Отчёт");
+        QCOMPARE(report, urgent + 1);
+        QCOMPARE(m_manager->tagName(report), QString("Отчёт"));
+        QCOMPARE(m_manager->tagId("Нет такого"), -1);
+        QCOMPARE(m_manager->internTag("  "), -1);
+
+        CustomDataManager* newManager = new CustomDataManager(this);
+        QCOMPARE(newManager->tagId("Срочно"), urgent);
+        QCOMPARE(newManager->tagId("Отчёт"), report);
+        delete newManager;
+    }
+
+    // Два экземпляра пишут один файл: изменения сливаются, а не затирают друг друга
+    void testConcurrentSave() {
+        m_manager->addProject("Merge Base", QColor(Qt::gray));
+        CustomDataManager* other = new CustomDataManager(this);
+        QVERIFY(m_manager->addProject("First Writer", QColor(Qt::red)));
+        QVERIFY(other->addProject("Second Writer", QColor(Qt::blue)));
+        QVERIFY(other->removeProject("Merge Base"));
+        QVERIFY(other->getProjects().contains("First Writer"));
+
+        CustomDataManager* reloaded = new CustomDataManager(this);
+        QVERIFY(reloaded->getProjects().contains("First Writer"));
+        QVERIFY(reloaded->getProjects().contains("Second Writer"));
+        QVERIFY(!reloaded->getProjects().contains("Merge Base"));
+        delete reloaded;
+
+        // Теги, заведённые одновременно, не делят ID: наш сдвигается за чужой
+        const int next = m_manager->getTags().size();
+        QCOMPARE(other->internTag("Чужой"), next);
+        QSignalSpy remapSpy(m_manager, &CustomDataManager::tagsRemapped);
+        QCOMPARE(m_manager->internTag("Свой"), next + 1);
+        QCOMPARE(m_manager->tagName(next), QString("Чужой"));
+        QCOMPARE(remapSpy.count(), 1);
+        const QHash<int, int> remapped = remapSpy.first().first().value<QHash<int, int>>();
+        QCOMPARE(remapped.value(next), next + 1);
+        delete other;
+    }
+
+    // Пропавший файл: справочники берутся из предыдущего поколения, а не из умолчаний
+    void testMissingFileUsesPrevious() {
+        QVERIFY(m_manager->addProject("Before Loss", QColor(Qt::darkGreen)));
+        QVERIFY(m_manager->addStatus("После потери"));
+        const QString filePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/custom_data.json";
+        QVERIFY(QFile::remove(filePath));
+
+        CustomDataManager* reloaded = new CustomDataManager(this);
+        QVERIFY(reloaded->getProjects().contains("Before Loss"));
+        delete reloaded;
+    }
+
     // Test system item checks
     void testSystemItems() {
         QVERIFY(m_manager->isSystemProject("Обычная задача"));
@@ -13,12 +13,30 @@ SOURCES +=  \
     ../../taskfilterproxymodel.cpp \
     ../../taskmodel.cpp \
     ../../task.cpp \
-    ../../customdatamanager.cpp
+    ../../customdatamanager.cpp \
+    ../../perfmonitor.cpp \
+    ../../tracing.cpp \
+    ../../taskintervalindex.cpp \
+    ../../recurrence.cpp \
+    ../../tasktreemodel.cpp \
+    ../../taskdependencygraph.cpp \
+    ../../rowbitmap.cpp \
+    ../../lockedsavefile.cpp \
+    ../../tasksync.cpp
 
 HEADERS += \
     ../../taskfilterproxymodel.h \
     ../../taskmodel.h \
     ../../task.h \
-    ../../customdatamanager.h
+    ../../customdatamanager.h \
+    ../../perfmonitor.h \
+    ../../tracing.h \
+    ../../taskintervalindex.h \
+    ../../recurrence.h \
+    ../../tasktreemodel.h \
+    ../../taskdependencygraph.h \
+    ../../rowbitmap.h \
+    ../../lockedsavefile.h \
+    ../../tasksync.h
 
 INCLUDEPATH += ../../
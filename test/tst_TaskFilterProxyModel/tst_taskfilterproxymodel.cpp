@@ -4,6 +4,7 @@
 #include "../../taskmodel.h"
 #include "../../task.h"
 #include "../../customdatamanager.h"
+#include "../../tasktreemodel.h"
 #include <QStandardPaths>
 #include <QDir>
 
@@ -13,6 +14,9 @@ class TaskFilterProxyModelTest : public QObject
 
 private slots:
     void initTestCase() {
+        // Файлы данных и журнал уходят в тестовый каталог, а не в данные пользователя; каждый прогон — с чистого
+        QStandardPaths::setTestModeEnabled(true);
+        QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
         m_tempPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/TaskFilterProxyModelTest";
         QDir dir(m_tempPath);
         if (dir.exists()) {
@@ -198,6 +202,82 @@ private slots:
         QCOMPARE(count, 1);
     }
 
+    // Предок подходящей подзадачи остаётся видимым, даже если её уровень не загружен
+    void testKeepsAncestorsOfMatchingSubtasks() {
+        Task parent;
+        parent.setTitle("Родитель");
+        Task child;
+        child.setTitle("Глубокая подзадача");
+        child.setParentUid(parent.uid());
+        m_sourceModel->addTask(parent);
+        m_sourceModel->addTask(child);
+
+        TaskTreeModel tree(m_sourceModel);
+        TaskFilterProxyModel treeProxy;
+        treeProxy.setSourceModel(&tree);
+        treeProxy.setHierarchyModel(m_sourceModel);
+        tree.fetchMore(QModelIndex());
+        treeProxy.setFilterTitle("Глубокая");
+        QCOMPARE(treeProxy.rowCount(), 1);
+        QCOMPARE(tree.uidForIndex(treeProxy.mapToSource(treeProxy.index(0, 0))), parent.uid());
+
+        treeProxy.setHierarchyModel(nullptr);
+        QCOMPARE(treeProxy.rowCount(), 0);
+    }
+
+    // Фильтр по тегам: «и» между словами, «|» — «или», «-» — исключение
+    void testTagFilter() {
+        m_proxyModel->setFilterDate(QDate());
+        const int urgent = m_dataManager->internTag("срочно");
+        const int report = m_dataManager->internTag("отчёт");
+        const int home = m_dataManager->internTag("дом");
+        Task first = m_sourceModel->getTask(0);
+        first.setTagIds({report, urgent});
+        m_sourceModel->updateTask(0, first);
+        Task second = m_sourceModel->getTask(1);
+        second.setTagIds({home});
+        m_sourceModel->updateTask(1, second);
+
+        m_proxyModel->setFilterTags(TagFilter::parse("срочно отчёт", m_dataManager));
+        QCOMPARE(m_proxyModel->rowCount(), 1);
+        m_proxyModel->setFilterTags(TagFilter::parse("срочно|дом", m_dataManager));
+        QCOMPARE(m_proxyModel->rowCount(), 2);
+        m_proxyModel->setFilterTags(TagFilter::parse("-дом", m_dataManager));
+        QCOMPARE(m_proxyModel->rowCount(), 1);
+        m_proxyModel->setFilterTags(TagFilter::parse("нет-такого", m_dataManager));
+        QCOMPARE(m_proxyModel->rowCount(), 0);
+
+        // Карты тегов следуют за вставкой и удалением строк
+        m_proxyModel->setFilterTags(TagFilter::parse("срочно", m_dataManager));
+        Task added;
+        added.setTitle("Новая");
+        added.setTagIds({urgent});
+        m_sourceModel->addTask(added);
+        QCOMPARE(m_proxyModel->rowCount(), 2);
+        m_sourceModel->removeTask(0);
+        QCOMPARE(m_proxyModel->rowCount(), 1);
+        QCOMPARE(m_proxyModel->index(0, 0).data(TaskModel::UidRole).toUuid(), added.uid());
+    }
+
+    // Тест карты UID → строка прокси-модели
+    void testProxyRowForUid() {
+        m_proxyModel->setFilterDate(QDate());
+        QCOMPARE(m_proxyModel->rowCount(), 2);
+        for (int row = 0; row < m_proxyModel->rowCount(); ++row) {
+            QUuid uid = m_proxyModel->index(row, 0).data(TaskModel::UidRole).toUuid();
+            QCOMPARE(m_proxyModel->proxyRowForUid(uid), row);
+        }
+
+        // Задача, скрытая фильтром, не имеет строки в прокси-модели
+        QUuid hiddenUid = m_sourceModel->getTask(2).uid();
+        QCOMPARE(m_proxyModel->proxyRowForUid(hiddenUid), -1);
+
+        // После смены фильтра карта перестраивается
+        m_proxyModel->setFilterProjectType("Проект B");
+        QCOMPARE(m_proxyModel->proxyRowForUid(m_sourceModel->getTask(1).uid()), 0);
+        QCOMPARE(m_proxyModel->proxyRowForUid(m_sourceModel->getTask(0).uid()), -1);
+    }
+
 private:
     QString m_tempPath;
     CustomDataManager* m_dataManager;
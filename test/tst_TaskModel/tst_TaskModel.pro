@@ -12,12 +12,34 @@ SOURCES +=  \
     tst_taskmodel.cpp \
     ../../task.cpp \
     ../../taskmodel.cpp \
-    ../../customdatamanager.cpp
+    ../../customdatamanager.cpp \
+    ../../tracing.cpp \
+    ../../taskintervalindex.cpp \
+    ../../autoscheduler.cpp \
+    ../../recurrence.cpp \
+    ../../tasktreemodel.cpp \
+    ../../taskdependencygraph.cpp \
+    ../../rowbitmap.cpp \
+    ../../taskundostack.cpp \
+    ../../taskhistory.cpp \
+    ../../lockedsavefile.cpp \
+    ../../tasksync.cpp
 
 HEADERS += \
     ../../task.h \
     ../../taskmodel.h \
-    ../../customdatamanager.h
+    ../../customdatamanager.h \
+    ../../tracing.h \
+    ../../taskintervalindex.h \
+    ../../autoscheduler.h \
+    ../../recurrence.h \
+    ../../tasktreemodel.h \
+    ../../taskdependencygraph.h \
+    ../../rowbitmap.h \
+    ../../taskundostack.h \
+    ../../taskhistory.h \
+    ../../lockedsavefile.h \
+    ../../tasksync.h
 
 INCLUDEPATH += ../../
 
@@ -3,8 +3,17 @@
 #include "../../taskmodel.h"
 #include "../../task.h"
 #include "../../customdatamanager.h"
+#include "../../autoscheduler.h"
+#include "../../tasktreemodel.h"
+#include "../../taskundostack.h"
+#include "../../taskhistory.h"
+#include "../../tasksync.h"
+#include "../../lockedsavefile.h"
 #include <QStandardPaths>
 #include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
 
 class TaskModelTest : public QObject
 {
@@ -12,6 +21,9 @@ class TaskModelTest : public QObject
 
 private slots:
     void initTestCase() {
+        // Файлы данных и журнал уходят в тестовый каталог, а не в данные пользователя; каждый прогон — с чистого
+        QStandardPaths::setTestModeEnabled(true);
+        QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
         // Set up a temporary directory for test files
         m_tempPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/TaskModelTest";
         QDir dir(m_tempPath);
@@ -89,6 +101,751 @@ private slots:
         QCOMPARE(model.data(index, Qt::DisplayRole).toString(), task.projectType());
     }
 
+    void testUidRole() {
+        TaskModel model(nullptr);
+        Task task = createTestTask();
+        model.addTask(task);
+
+        QModelIndex index = model.index(0, TaskModel::DateColumn);
+        QCOMPARE(model.data(index, TaskModel::UidRole).toUuid(), task.uid());
+    }
+
+    void testDayStats() {
+        TaskModel model(nullptr);
+        QDate day(2025, 3, 10);
+
+        Task meeting("Встреча", "Работа", QDateTime(day, QTime(22, 0)), QDateTime(day.addDays(1), QTime(1, 0)));
+        meeting.setIsProjectTask(true);
+        model.addTask(meeting);
+        QCOMPARE(model.dayStats(day).taskCount, 1);
+        QCOMPARE(model.dayStats(day).bookedMinutes, 120);
+        QCOMPARE(model.dayStats(day.addDays(1)).minutesByProject.value("Работа"), 60);
+
+        // Перенос задачи обновляет только затронутые дни
+        Task moved = meeting;
+        moved.setStartDateTime(QDateTime(day.addDays(2), QTime(9, 0)));
+        moved.setEndDateTime(QDateTime(day.addDays(2), QTime(10, 30)));
+        model.updateTask(0, moved);
+        QCOMPARE(model.dayStats(day).taskCount, 0);
+        QCOMPARE(model.dayStats(day.addDays(1)).bookedMinutes, 0);
+        QCOMPARE(model.dayStats(day.addDays(2)).bookedMinutes, 90);
+
+        model.removeTask(0);
+        QCOMPARE(model.dayStats(day.addDays(2)).taskCount, 0);
+    }
+
+    void testFindFreeSlots() {
+        TaskModel model(nullptr);
+        QDate day(2025, 3, 10);
+
+        Task morning("Утро", "Работа", QDateTime(day, QTime(9, 0)), QDateTime(day, QTime(10, 0)));
+        Task overlap("Созвон", "Работа", QDateTime(day, QTime(9, 30)), QDateTime(day, QTime(11, 0)));
+        Task lunch("Обед", "Личное", QDateTime(day, QTime(12, 0)), QDateTime(day, QTime(13, 0)));
+        model.addTask(morning);
+        model.addTask(overlap);
+        model.addTask(lunch);
+
+        // Пересечения с учётом исключения собственной задачи
+        QCOMPARE(model.intervalIndex().overlapping(QDateTime(day, QTime(10, 30)), QDateTime(day, QTime(12, 30))).size(), 2);
+        QCOMPARE(model.intervalIndex().overlapping(QDateTime(day, QTime(9, 0)), QDateTime(day, QTime(9, 15)), morning.uid()).size(), 0);
+
+        // В рабочие часы 9–18 свободно 11:00–12:00 и 13:00–18:00; 90 минут помещаются только во второй
+        QVector<FreeSlot> slots = model.findFreeSlots(90, day, day, QTime(9, 0), QTime(18, 0));
+        QCOMPARE(slots.size(), 1);
+        QCOMPARE(slots.first().start, QDateTime(day, QTime(13, 0)));
+        QCOMPARE(slots.first().end, QDateTime(day, QTime(18, 0)));
+
+        slots = model.findFreeSlots(60, day, day, QTime(9, 0), QTime(18, 0));
+        QCOMPARE(slots.size(), 2);
+        QCOMPARE(slots.first().start, QDateTime(day, QTime(11, 0)));
+
+        // После удаления интервал освобождается
+        model.removeTask(model.findTask(lunch.uid()));
+        slots = model.findFreeSlots(90, day, day, QTime(9, 0), QTime(18, 0));
+        QCOMPARE(slots.first().start, QDateTime(day, QTime(11, 0)));
+    }
+
+    void testAutoSchedule() {
+        TaskModel model(nullptr);
+        QDate day(2025, 3, 10);
+        model.addTask(Task("Утро", "Работа", QDateTime(day, QTime(9, 0)), QDateTime(day, QTime(10, 0))));
+        model.addTask(Task("Обед", "Личное", QDateTime(day, QTime(12, 0)), QDateTime(day, QTime(13, 0))));
+
+        auto untimed = [day](const QString &title, int minutes, const QString &priority, int dueOffset = 0) {
+            Task task;
+            task.setTitle(title);
+            task.setPriority(priority);
+            task.setEstimatedMinutes(minutes);
+            task.setStartDateTime(QDateTime(day.addDays(dueOffset), QTime(0, 0)));
+            return task;
+        };
+
+        // Свободно 10:00–12:00: сначала важная задача, потом средняя, низкая не помещается
+        QVector<FreeSlot> slots = model.findFreeSlots(60, day, day, QTime(9, 0), QTime(13, 0), 100);
+        QVector<Task> tasks = {untimed("Низкая", 90, "Низкий"), untimed("Высокая", 60, "Высокий"),
+                               untimed("Средняя", 60, "Средний")};
+        AutoScheduleResult result = AutoScheduler::plan(tasks, slots);
+        QCOMPARE(result.scheduled.size(), 2);
+        QCOMPARE(result.scheduled[0].title(), QString("Высокая"));
+        QVERIFY(result.scheduled[0].isProjectTask());
+        QCOMPARE(result.scheduled[0].startDateTime(), QDateTime(day, QTime(10, 0)));
+        QCOMPARE(result.scheduled[1].endDateTime(), QDateTime(day, QTime(12, 0)));
+        QCOMPARE(result.unscheduled.size(), 1);
+        QCOMPARE(result.unscheduled.first().title(), QString("Низкая"));
+
+        // Жадный порядок занимает первый промежуток короткой задачей; перестановка размещает обе
+        slots = {FreeSlot{QDateTime(day, QTime(10, 0)), QDateTime(day, QTime(11, 30))},
+                 FreeSlot{QDateTime(day.addDays(1), QTime(10, 0)), QDateTime(day.addDays(1), QTime(11, 0))}};
+        tasks = {untimed("Короткая", 60, "Высокий", 1), untimed("Длинная", 90, "Низкий", 1)};
+        AutoScheduleOptions options;
+        options.localSearch = false;
+        QCOMPARE(AutoScheduler::plan(tasks, slots, options).unscheduled.size(), 1);
+        options.localSearch = true;
+        result = AutoScheduler::plan(tasks, slots, options);
+        QCOMPARE(result.unscheduled.size(), 0);
+        QCOMPARE(result.scheduled[0].title(), QString("Длинная"));
+        QCOMPARE(result.scheduled[1].startDateTime(), QDateTime(day.addDays(1), QTime(10, 0)));
+
+        // Срок соблюдается: задача со сроком в первый день не уходит во второй
+        tasks = {untimed("Срочная", 120, "Высокий")};
+        QCOMPARE(AutoScheduler::plan(tasks, slots).unscheduled.size(), 1);
+    }
+
+    void testRecurringSeries() {
+        TaskModel model(nullptr);
+        QDate monday(2025, 3, 3);
+        Task series("Планёрка", "Работа", QDateTime(monday, QTime(10, 0)), QDateTime(monday, QTime(11, 0)));
+        series.setRecurrence(Recurrence::fromRRule("FREQ=WEEKLY;COUNT=4"));
+        model.addTask(series);
+
+        // Серия хранится одной строкой, вхождения видны в сводках и при поиске свободного времени
+        QCOMPARE(model.rowCount(), 1);
+        QCOMPARE(model.intervalIndex().size(), 0);
+        QCOMPARE(model.dayStats(QDate(2025, 3, 10)).bookedMinutes, 60);
+        QCOMPARE(model.dayStats(QDate(2025, 3, 11)).taskCount, 0);
+        QVector<FreeSlot> slots = model.findFreeSlots(60, QDate(2025, 3, 17), QDate(2025, 3, 17), QTime(9, 30), QTime(12, 0));
+        QCOMPARE(slots.size(), 1);
+        QCOMPARE(slots.first().start, QDateTime(QDate(2025, 3, 17), QTime(11, 0)));
+        QCOMPARE(model.overlapping(QDateTime(QDate(2025, 3, 24), QTime(10, 30)),
+                                   QDateTime(QDate(2025, 3, 24), QTime(12, 0))).size(), 1);
+
+        // Изменение одного вхождения хранится как отличие, пропуск — как исключение
+        Task occurrence = model.occurrences(QDate(2025, 3, 10), QDate(2025, 3, 10)).first();
+        occurrence.setStartDateTime(QDateTime(QDate(2025, 3, 10), QTime(15, 0)));
+        occurrence.setEndDateTime(QDateTime(QDate(2025, 3, 10), QTime(16, 0)));
+        model.setOccurrenceOverride(series.uid(), occurrence.occurrenceDate(), occurrence);
+        OccurrenceOverride change = model.getTask(0).recurrence().overrides().value(QDate(2025, 3, 10));
+        QVERIFY(change.title.isEmpty());
+        QCOMPARE(change.start, occurrence.startDateTime());
+        QCOMPARE(model.overlapping(QDateTime(QDate(2025, 3, 10), QTime(10, 0)),
+                                   QDateTime(QDate(2025, 3, 10), QTime(11, 0))).size(), 0);
+
+        model.skipOccurrence(series.uid(), QDate(2025, 3, 17));
+        QCOMPARE(model.occurrences(QDate(2025, 3, 1), QDate(2025, 3, 31)).size(), 3);
+        QCOMPARE(model.dayStats(QDate(2025, 3, 17)).taskCount, 0);
+    }
+
+    void testSubtasks() {
+        TaskModel model(nullptr);
+        Task root = createTestTask("Релиз");
+        Task docs = createTestTask("Документация");
+        Task build = createTestTask("Сборка");
+        Task tests = createTestTask("Тесты");
+        docs.setParentUid(root.uid());
+        build.setParentUid(root.uid());
+        tests.setParentUid(build.uid());
+        tests.setStatus("Выполнено");
+        model.addTask(root);
+        model.addTask(docs);
+        model.addTask(build);
+        model.addTask(tests);
+
+        // Прогресс считается по всем потомкам и обновляется вверх по цепочке предков
+        QCOMPARE(model.childUids(), QVector<QUuid>{root.uid()});
+        QCOMPARE(model.childCount(root.uid()), 2);
+        QCOMPARE(model.progress(root.uid()).total, 3);
+        QCOMPARE(model.progress(root.uid()).done, 1);
+        docs.setStatus("Выполнено");
+        model.updateTask(model.findTask(docs.uid()), docs);
+        QCOMPARE(model.progress(root.uid()).done, 2);
+        QCOMPARE(model.progress(build.uid()).done, 1);
+
+        // Перенос поддерева и защита от цикла
+        build.setParentUid(docs.uid());
+        model.updateTask(model.findTask(build.uid()), build);
+        QCOMPARE(model.progress(docs.uid()).total, 2);
+        QCOMPARE(model.progress(root.uid()).total, 3);
+        QVERIFY(model.isAncestor(root.uid(), tests.uid()));
+        root.setParentUid(tests.uid());
+        model.updateTask(model.findTask(root.uid()), root);
+        QVERIFY(model.parentOf(root.uid()).isNull());
+
+        // Дерево материализует уровень только по fetchMore
+        TaskTreeModel tree(&model);
+        QCOMPARE(tree.rowCount(), 0);
+        QVERIFY(tree.canFetchMore(QModelIndex()));
+        tree.fetchMore(QModelIndex());
+        QCOMPARE(tree.rowCount(), 1);
+        QModelIndex rootIndex = tree.index(0, 0);
+        QVERIFY(tree.hasChildren(rootIndex));
+        QCOMPARE(tree.rowCount(rootIndex), 0);
+        QCOMPARE(tree.materializedCount(), 1);
+        QCOMPARE(tree.data(rootIndex).toString(), QString("Релиз (2/3)"));
+        tree.fetchMore(rootIndex);
+        QCOMPARE(tree.rowCount(rootIndex), 1);
+
+        // Новая подзадача загруженного уровня появляется сразу, прогресс предка обновляется
+        Task review = createTestTask("Ревью");
+        review.setParentUid(root.uid());
+        model.addTask(review);
+        QCOMPARE(tree.rowCount(rootIndex), 2);
+        QCOMPARE(tree.data(rootIndex).toString(), QString("Релиз (2/4)"));
+
+        // Удаление задачи поднимает её подзадачи на уровень выше
+        model.removeTask(model.findTask(docs.uid()));
+        QCOMPARE(model.parentOf(build.uid()), root.uid());
+        QCOMPARE(model.progress(root.uid()).total, 3);
+        QCOMPARE(tree.rowCount(rootIndex), 2);
+        QCOMPARE(tree.uidForIndex(tree.index(1, 0, rootIndex)), build.uid());
+    }
+
+    void testDependencies() {
+        TaskModel model(nullptr);
+        QDate day(2025, 4, 1);
+        auto at = [day](int hour, int minute = 0) { return QDateTime(day, QTime(hour, minute)); };
+        Task design("Проектирование", "Работа", at(9), at(11));
+        Task coding("Разработка", "Работа", at(10), at(12));
+        Task release("Выпуск", "Работа", at(13), at(14));
+        coding.setDependencies({design.uid()});
+        release.setDependencies({design.uid(), coding.uid()});
+        model.addTask(design);
+        model.addTask(coding);
+        model.addTask(release);
+
+        // Разработка запланирована до окончания проектирования — конфликт и сдвиг раннего начала
+        QModelIndex codingIndex = model.index(model.findTask(coding.uid()), 0);
+        QModelIndex releaseIndex = model.index(model.findTask(release.uid()), 0);
+        QVERIFY(codingIndex.data(TaskModel::DependencyConflictRole).toBool());
+        QCOMPARE(codingIndex.data(TaskModel::EarliestStartRole).toDateTime(), at(11));
+        QVERIFY(!releaseIndex.data(TaskModel::DependencyConflictRole).toBool());
+        QVERIFY(releaseIndex.data(TaskModel::CriticalPathRole).toBool());
+        QCOMPARE(model.index(0, 0).data(TaskModel::SlackMinutesRole).toLongLong(), 0LL);
+        QCOMPARE(model.dependencyGraph().topologicalOrder(),
+                 (QVector<QUuid>{design.uid(), coding.uid(), release.uid()}));
+
+        // Цикл отвергается, граф не меняется
+        QVERIFY(!model.addDependency(release.uid(), design.uid()));
+        QVERIFY(model.getTask(0).dependencies().isEmpty());
+
+        // Перенос предшественника пересчитывает только последователей
+        design.setStartDateTime(at(8));
+        design.setEndDateTime(at(9, 30));
+        model.updateTask(model.findTask(design.uid()), design);
+        QVERIFY(!codingIndex.data(TaskModel::DependencyConflictRole).toBool());
+        QCOMPARE(codingIndex.data(TaskModel::EarliestStartRole).toDateTime(), at(10));
+        QCOMPARE(model.index(0, 0).data(TaskModel::SlackMinutesRole).toLongLong(), 90LL);
+
+        // Удалённая задача пропадает из зависимостей последователей
+        model.removeTask(model.findTask(coding.uid()));
+        QCOMPARE(model.getTask(model.findTask(release.uid())).dependencies(), QVector<QUuid>{design.uid()});
+        QCOMPARE(model.dependencyGraph().size(), 2);
+        model.removeDependency(design.uid(), release.uid());
+        QCOMPARE(model.dependencyGraph().size(), 0);
+    }
+
+    void testTagIndex() {
+        TaskModel model(nullptr);
+        for (int i = 0; i < 130; ++i) {
+            Task task = createTestTask(QString::number(i));
+            QVector<int> tags;
+            if (i % 2 == 0)
+                tags.append(1);
+            if (i >= 100)
+                tags.append(2);
+            task.setTagIds(tags);
+            model.addTask(task);
+        }
+        QCOMPARE(model.rowsWithTag(1).count(), 65);
+        QCOMPARE(model.rowsWithTag(2).count(), 30);
+        QVERIFY(!model.rowsWithTag(3).any());
+
+        // Удаление строки сдвигает биты через границу 64-битных слов
+        const quint64 revision = model.tagIndexRevision();
+        model.removeTask(10);
+        QVERIFY(model.tagIndexRevision() != revision);
+        QVERIFY(!model.rowsWithTag(1).testBit(10));
+        QVERIFY(model.rowsWithTag(1).testBit(63));
+        QVERIFY(model.rowsWithTag(1).testBit(127));
+        QCOMPARE(model.rowsWithTag(1).count(), 64);
+        QVERIFY(!model.rowsWithTag(2).testBit(98));
+        QVERIFY(model.rowsWithTag(2).testBit(99));
+
+        Task first = model.getTask(0);
+        first.setTagIds({3, 2, 3});
+        QCOMPARE(first.tagIds(), (QVector<int>{2, 3}));
+        model.updateTask(0, first);
+        QVERIFY(!model.rowsWithTag(1).testBit(0));
+        QVERIFY(model.rowsWithTag(3).testBit(0));
+
+        RowBitmap both = model.rowsWithTag(1);
+        both &= model.rowsWithTag(2);
+        QCOMPARE(both.count(), 15);
+        RowBitmap rest = RowBitmap::filled(model.rowCount());
+        rest.subtract(model.rowsWithTag(1));
+        QCOMPARE(rest.count(), model.rowCount() - 63);
+
+        // Перенумерация тегов после слияния списка переносит и биты индекса
+        model.remapTags({{3, 4}});
+        QCOMPARE(model.getTask(0).tagIds(), (QVector<int>{2, 4}));
+        QVERIFY(!model.rowsWithTag(3).any());
+        QVERIFY(model.rowsWithTag(4).testBit(0));
+    }
+
+    void testUndoRedo() {
+        TaskModel model(nullptr);
+        TaskUndoStack stack(&model);
+        Task a = createTestTask("A");
+        Task b = createTestTask("B");
+        b.setProjectType("Учёба");
+        model.addTask(a);
+        model.addTask(b);
+        QCOMPARE(stack.count(), 2);
+
+        // Отмена возвращает только изменённые поля: статус, поменянный без записи, остаётся
+        a.setTitle("A2");
+        model.updateTask(0, a);
+        {
+            TaskUndoStack::Pause pause(&stack);
+            Task done = model.getTask(0);
+            done.setStatus("Выполнено");
+            model.updateTask(0, done);
+        }
+        QCOMPARE(stack.count(), 3);
+        stack.undo();
+        QCOMPARE(model.getTask(0).title(), QString("A"));
+        QCOMPARE(model.getTask(0).status(), QString("Выполнено"));
+        QVERIFY(stack.canRedo());
+        stack.redo();
+        QCOMPARE(model.getTask(0).title(), QString("A2"));
+
+        // Массовая замена — один шаг
+        {
+            TaskUndoStack::Group group(&stack, "Удаление проекта");
+            model.replaceProjectInTasks({0, 1}, "Обычная задача");
+        }
+        QCOMPARE(stack.count(), 4);
+        QCOMPARE(stack.undoText(), QString("Удаление проекта"));
+        stack.undo();
+        QCOMPARE(model.getTask(0).projectType(), QString("Test Project"));
+        QCOMPARE(model.getTask(1).projectType(), QString("Учёба"));
+
+        // Новое изменение отменяет возможность повтора
+        model.removeTask(model.findTask(b.uid()));
+        QVERIFY(!stack.canRedo());
+        QCOMPARE(model.rowCount(), 1);
+        stack.undo();
+        QCOMPARE(model.rowCount(), 2);
+        QCOMPARE(model.getTask(model.findTask(b.uid())).projectType(), QString("Учёба"));
+
+        // Отмена добавления не кладёт задачу в корзину, отмена восстановления — кладёт обратно
+        const Task c = createTestTask("C");
+        model.addTask(c);
+        stack.undo();
+        QCOMPARE(model.findTask(c.uid()), -1);
+        QVERIFY(!model.isDeleted(c.uid()));
+        model.removeTask(model.findTask(b.uid()));
+        model.restoreTask(b.uid());
+        stack.undo();
+        QVERIFY(model.isDeleted(b.uid()));
+        stack.undo();
+        QVERIFY(!model.isDeleted(b.uid()));
+        QCOMPARE(model.rowCount(), 2);
+
+        // Бюджет памяти отбрасывает старые шаги, последний остаётся
+        const qint64 used = stack.bytesUsed();
+        QVERIFY(used > 0);
+        stack.setByteBudget(1);
+        QCOMPARE(stack.count() + (stack.canRedo() ? 1 : 0), 1);
+        QVERIFY(stack.bytesUsed() < used);
+    }
+
+    void testTrash() {
+        TaskModel model(nullptr);
+        Task a = createTestTask("A");
+        Task b = createTestTask("B");
+        b.setIsProjectTask(true);
+        model.addTask(a);
+        model.addTask(b);
+        const QDate day = b.startDateTime().date();
+        QCOMPARE(model.dayStats(day).taskCount, 2);
+
+        // Удалённая задача уходит из строк и сводок, но остаётся в корзине
+        QSignalSpy trashSpy(&model, &TaskModel::trashChanged);
+        model.removeTask(model.findTask(b.uid()));
+        QCOMPARE(model.rowCount(), 1);
+        QCOMPARE(model.findTask(b.uid()), -1);
+        QCOMPARE(model.dayStats(day).taskCount, 1);
+        QVERIFY(model.isDeleted(b.uid()));
+        QCOMPARE(model.deletedTasks().size(), 1);
+        QCOMPARE(model.deletedTasks().first().task.title(), QString("B"));
+        QCOMPARE(trashSpy.count(), 1);
+
+        // Восстановление возвращает задачу в конец списка и во все индексы
+        QCOMPARE(model.restoreTask(b.uid()), 1);
+        QVERIFY(!model.isDeleted(b.uid()));
+        QCOMPARE(model.findTask(b.uid()), 1);
+        QCOMPARE(model.dayStats(day).taskCount, 2);
+        QCOMPARE(model.restoreTask(b.uid()), -1);
+
+        // Отмена удаления тоже забирает задачу из корзины
+        TaskUndoStack stack(&model);
+        model.removeTask(0);
+        QCOMPARE(model.deletedCount(), 1);
+        stack.undo();
+        QCOMPARE(model.deletedCount(), 0);
+        QCOMPARE(model.rowCount(), 2);
+
+        // Очистка удаляет только записи старше границы
+        model.removeTask(0);
+        QCOMPARE(model.purgeTrash(QDateTime::currentDateTime().addDays(-1)), 0);
+        QCOMPARE(model.deletedCount(), 1);
+        QCOMPARE(model.purgeTrash(QDateTime::currentDateTime().addSecs(1)), 1);
+        QCOMPARE(model.deletedCount(), 0);
+        model.removeTask(0);
+        model.deletePermanently(a.uid());
+        QCOMPARE(model.deletedCount(), 0);
+        QCOMPARE(model.rowCount(), 0);
+    }
+
+    void testHistory() {
+        const QString path = m_tempPath + "/history_test.jsonl";
+        QFile::remove(path);
+        TaskModel model(nullptr);
+        TaskHistory history(&model, path);
+        Task a = createTestTask("A");
+        Task b = createTestTask("B");
+        model.addTask(a);
+        model.addTask(b);
+
+        a.setStatus("Выполнено");
+        model.updateTask(0, a);
+        model.updateTask(0, a); // без изменений — без ревизии
+        model.removeTask(0);
+
+        // Правка хранит только изменившиеся поля
+        const QVector<TaskHistory::Revision> revisions = history.revisions(a.uid());
+        QCOMPARE(revisions.size(), 3);
+        QCOMPARE(revisions[0].kind, TaskHistory::Revision::Created);
+        QCOMPARE(revisions[0].after["title"].toString(), QString("A"));
+        QCOMPARE(revisions[1].kind, TaskHistory::Revision::Updated);
+        QCOMPARE(revisions[1].after.keys(), QStringList{"status"});
+        QCOMPARE(revisions[1].before["status"].toString(), QString("Не начато"));
+        QCOMPARE(revisions[1].after["status"].toString(), QString("Выполнено"));
+        QVERIFY(revisions[1].at.isValid());
+        QCOMPARE(revisions[2].kind, TaskHistory::Revision::Deleted);
+        QCOMPARE(history.revisions(b.uid()).size(), 1);
+
+        // Журнал только дописывается: новый объект читает тот же файл
+        TaskModel otherModel(nullptr);
+        TaskHistory reopened(&otherModel, path);
+        QCOMPARE(reopened.revisions(a.uid()).size(), 3);
+    }
+
+    void testHistoryAsOf() {
+        const QString path = m_tempPath + "/history_asof.jsonl";
+        QFile::remove(path);
+        QFile::remove(path + ".idx");
+        QFile::remove(path + ".checkpoints");
+        TaskModel model(nullptr);
+        TaskHistory history(&model, path);
+        history.setCheckpointInterval(2);
+
+        Task a = createTestTask("A");
+        model.addTask(a);
+        model.addTask(createTestTask("B"));
+        QTest::qSleep(5);
+        const QDateTime twoTasks = QDateTime::currentDateTime();
+        QTest::qSleep(5);
+        a.setTitle("A2");
+        model.updateTask(0, a); // перед этой записью пишется контрольная точка
+        model.removeTask(1);
+        QTest::qSleep(5);
+        const QDateTime renamed = QDateTime::currentDateTime();
+        QTest::qSleep(5);
+        model.removeTask(0); // вторая контрольная точка
+        model.addTask(createTestTask("C"));
+        QVERIFY(QFile::exists(path + ".idx"));
+        QVERIFY(QFile::exists(path + ".checkpoints"));
+
+        QVector<Task> tasks = history.tasksAsOf(twoTasks);
+        QCOMPARE(tasks.size(), 2);
+        QCOMPARE(tasks[0].title(), QString("A"));
+        QCOMPARE(tasks[1].title(), QString("B"));
+
+        tasks = history.tasksAsOf(renamed);
+        QCOMPARE(tasks.size(), 1);
+        QCOMPARE(tasks[0].title(), QString("A2"));
+        QCOMPARE(tasks[0].uid(), a.uid());
+
+        tasks = history.tasksAsOf(QDateTime::currentDateTime());
+        QCOMPARE(tasks.size(), 1);
+        QCOMPARE(tasks[0].title(), QString("C"));
+        QVERIFY(history.tasksAsOf(QDateTime::currentDateTime().addYears(-1)).isEmpty());
+
+        // Контрольные точки не попадают в ревизии задачи
+        QCOMPARE(history.revisions(a.uid()).size(), 3);
+    }
+
+    void testHistoryAppliedFile() {
+        const QString path = m_tempPath + "/history_applied.jsonl";
+        QFile::remove(path);
+        QFile::remove(path + ".idx");
+        QFile::remove(path + ".checkpoints");
+        TaskModel model(nullptr);
+        TaskHistory history(&model, path);
+        Task a = createTestTask("A");
+        Task b = createTestTask("B");
+        model.addTask(a);
+        model.addTask(b);
+
+        // Изменения чужого файла журналируются с пометкой, без автора
+        TaskModel::TaskFile contents;
+        contents.ok = true;
+        contents.digest = "external";
+        a.setTitle("A2");
+        const Task c = createTestTask("C");
+        contents.tasks = {a, c};
+        contents.deleted = {TaskModel::DeletedTask{b, QDateTime::currentDateTime()}};
+        QCOMPARE(model.applyTasksFile(contents), 3);
+
+        const QVector<TaskHistory::Revision> revisions = history.revisions(a.uid());
+        QCOMPARE(revisions.size(), 2);
+        QVERIFY(!revisions[0].fromFile);
+        QVERIFY(revisions[1].fromFile);
+        QVERIFY(revisions[1].user.isEmpty());
+        QCOMPARE(revisions[1].after["title"].toString(), QString("A2"));
+        QCOMPARE(history.revisions(b.uid()).last().kind, TaskHistory::Revision::Deleted);
+        QVERIFY(history.revisions(c.uid()).first().fromFile);
+
+        QVector<Task> tasks = history.tasksAsOf(QDateTime::currentDateTime());
+        QCOMPARE(tasks.size(), 2);
+        QCOMPARE(tasks[0].title(), QString("A2"));
+        QCOMPARE(tasks[1].uid(), c.uid());
+
+        // Загрузка того же списка не плодит контрольных точек, а расходящегося с журналом — пишет одну
+        QVERIFY(!QFile::exists(path + ".checkpoints"));
+        model.setTasks(model.tasks());
+        a = model.getTask(0);
+        a.setStatus("Выполнено");
+        model.updateTask(0, a);
+        QVERIFY(!QFile::exists(path + ".checkpoints"));
+        QVector<Task> changed = model.tasks();
+        changed[1].setTitle("C2");
+        model.setTasks(changed);
+        a.setStatus("Не начато");
+        model.updateTask(0, a);
+        QVERIFY(QFile::exists(path + ".checkpoints"));
+        tasks = history.tasksAsOf(QDateTime::currentDateTime());
+        QCOMPARE(tasks.size(), 2);
+        QCOMPARE(tasks[1].title(), QString("C2"));
+    }
+
+    void testApplyTasksFile() {
+        TaskModel model(nullptr);
+        TaskUndoStack stack(&model);
+        Task a = createTestTask("A");
+        Task b = createTestTask("B");
+        Task c = createTestTask("C");
+        model.addTask(a);
+        model.addTask(b);
+        model.addTask(c);
+        const int steps = stack.count();
+
+        // Другой процесс: A переименована, B удалена в корзину, добавлены D (подзадача E, зависит от C) и E
+        TaskModel::TaskFile contents;
+        contents.ok = true;
+        contents.digest = "external";
+        a.setTitle("A2");
+        Task d = createTestTask("D");
+        Task e = createTestTask("E");
+        d.setParentUid(e.uid());
+        d.setDependencies({c.uid()});
+        contents.tasks = {a, c, d, e};
+        contents.deleted = {TaskModel::DeletedTask{b, QDateTime::currentDateTime()}};
+
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+        QSignalSpy insertSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy removeSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QCOMPARE(model.applyTasksFile(contents), 4);
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(insertSpy.count(), 2);
+        QCOMPARE(removeSpy.count(), 1);
+
+        QCOMPARE(model.rowCount(), 4);
+        QCOMPARE(model.getTask(model.findTask(a.uid())).title(), QString("A2"));
+        QCOMPARE(model.findTask(c.uid()), 1); // неизменённая задача только сдвинулась после удаления B
+        QVERIFY(model.isDeleted(b.uid()));
+        QCOMPARE(model.parentOf(d.uid()), e.uid());
+        QCOMPARE(model.dependencyGraph().predecessors(d.uid()), QVector<QUuid>{c.uid()});
+        QCOMPARE(stack.count(), steps);
+
+        // Тот же файл повторно не применяется
+        QCOMPARE(model.applyTasksFile(contents), 0);
+
+        // Поле, изменённое по обе стороны, решают отметки — так же, как при синхронизации
+        Task local = model.getTask(model.findTask(c.uid()));
+        local.setTitle("C-local");
+        model.updateTask(model.findTask(c.uid()), local);
+        Task remote = c;
+        remote.setTitle("C-remote");
+        remote.setFieldStamp("title", QDateTime::currentMSecsSinceEpoch() + 60000);
+        TaskModel::TaskFile later = contents;
+        later.digest = "external-2";
+        later.tasks = {a, remote, d, e};
+        model.applyTasksFile(later);
+        QCOMPARE(model.getTask(model.findTask(c.uid())).title(), QString("C-remote"));
+
+        // Задача, удалённая там насовсем (её нет и в корзине файла), не попадает в нашу корзину
+        TaskModel::TaskFile purged = later;
+        purged.digest = "external-3";
+        purged.tasks = {a, remote, d};
+        model.applyTasksFile(purged);
+        QCOMPARE(model.findTask(e.uid()), -1);
+        QVERIFY(!model.isDeleted(e.uid()));
+        QVERIFY(model.isDeleted(b.uid()));
+    }
+
+    void testApplyEdit() {
+        // Правка из диалога не откатывает поля, изменённые в модели, пока диалог был открыт
+        TaskModel model(nullptr);
+        const Task original = createTestTask("A");
+        model.addTask(original);
+        Task external = model.getTask(0);
+        external.setStatus("Выполнено");
+        model.updateTask(0, external);
+
+        Task edited = original;
+        edited.setTitle("A2");
+        QCOMPARE(model.applyEdit(original, edited), 0);
+        QCOMPARE(model.getTask(0).title(), QString("A2"));
+        QCOMPARE(model.getTask(0).status(), QString("Выполнено"));
+
+        model.removeTask(0);
+        QCOMPARE(model.applyEdit(original, edited), -1);
+    }
+
+    void testSync() {
+        // Правка ставит отметку времени только изменённым полям
+        TaskModel model(nullptr);
+        Task a = createTestTask("A");
+        model.addTask(a);
+        QVERIFY(model.getTask(0).fieldStamps().isEmpty());
+        Task edited = model.getTask(0);
+        edited.setTitle("A-left");
+        model.updateTask(0, edited);
+        const qint64 created = a.creationDateTime().toMSecsSinceEpoch();
+        QCOMPARE(model.getTask(0).fieldStamps().keys(), QList<QString>{"title"});
+        QVERIFY(model.getTask(0).fieldStamp("title") > created);
+        // Разница полей — общая для отметок, отмены и журнала; сами отметки в неё не входят
+        const TaskModel::FieldDiff diff = TaskModel::diffFields(a, model.getTask(0));
+        QCOMPARE(diff.after.keys(), QStringList{"title"});
+        QCOMPARE(diff.before.value("title").toString(), QString("A"));
+
+        // Два хранилища: A правили по обе стороны, B удалена справа, C и D есть только с одной стороны
+        Task left = a;
+        left.setTitle("A-left");
+        left.setDescription("x");
+        left.setFieldStamp("title", created + 1000);
+        left.setFieldStamp("description", created + 3000);
+        Task right = a;
+        right.setStatus("Выполнено");
+        right.setDescription("y");
+        right.setFieldStamp("status", created + 2000);
+        right.setFieldStamp("description", created + 4000);
+        Task b = createTestTask("B");
+        Task c = createTestTask("C");
+        Task d = createTestTask("D");
+        QJsonObject deletedB = TaskModel::taskToJson(b);
+        deletedB["deletedAt"] = QDateTime::currentDateTime().addSecs(60).toString(Qt::ISODate);
+
+        auto writeStore = [](const QString &path, const QVector<QJsonObject> &tasks) {
+            QJsonArray array;
+            for (const QJsonObject &task : tasks)
+                array.append(task);
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write("{\"version\": 3, \"tasks\": " + QJsonDocument(array).toJson() + "}");
+        };
+        const QString leftPath = m_tempPath + "/sync-left.json";
+        const QString rightPath = m_tempPath + "/sync-right.json";
+        writeStore(leftPath, {TaskModel::taskToJson(left), TaskModel::taskToJson(b), TaskModel::taskToJson(c)});
+        writeStore(rightPath, {TaskModel::taskToJson(d), deletedB, TaskModel::taskToJson(right)});
+
+        const QString outputPath = m_tempPath + "/sync-out.json";
+        const QString reportPath = m_tempPath + "/sync-conflicts.jsonl";
+        const TaskSync::Result result = TaskSync::merge(leftPath, rightPath, outputPath, reportPath);
+        QVERIFY(result.ok);
+        QCOMPARE(result.version, 4);
+        QCOMPARE(result.tasks, 4);
+        QCOMPARE(result.merged, 2);
+        QCOMPARE(result.onlyLeft, 1);
+        QCOMPARE(result.onlyRight, 1);
+        QCOMPARE(result.conflicts, 1);
+        QCOMPARE(result.leftVersion, 3);
+        QCOMPARE(result.rightVersion, 3);
+
+        // Файл, сменивший номер записи за время слияния, не затирается
+        {
+            QSaveFile stale(rightPath);
+            QVERIFY(stale.open(QIODevice::WriteOnly));
+            stale.write("{}");
+            QCOMPARE(LockedSaveFile::commit(stale, []() { return false; }), LockedSaveFile::Stale);
+            QCOMPARE(TaskModel::readTasksFileVersion(rightPath), 3);
+        }
+
+        const TaskModel::TaskFile merged = TaskModel::readTasksFile(outputPath);
+        QVERIFY(merged.ok);
+        {
+            // Результат несёт контрольную сумму, как и файл, записанный моделью
+            QFile output(outputPath);
+            QVERIFY(output.open(QIODevice::ReadOnly));
+            QVERIFY(output.read(64).contains("\"checksum\""));
+        }
+        QCOMPARE(merged.version, 4);
+        QCOMPARE(merged.tasks.size(), 3);
+        QCOMPARE(merged.deleted.size(), 1);
+        QCOMPARE(merged.deleted[0].task.uid(), b.uid());
+        for (const Task &task : merged.tasks) {
+            if (task.uid() != a.uid())
+                continue;
+            QCOMPARE(task.title(), QString("A-left"));
+            QCOMPARE(task.status(), QString("Выполнено"));
+            QCOMPARE(task.description(), QString("y"));
+            QCOMPARE(task.fieldStamp("description"), created + 4000);
+        }
+
+        QFile report(reportPath);
+        QVERIFY(report.open(QIODevice::ReadOnly));
+        const QJsonObject conflict = QJsonDocument::fromJson(report.readLine()).object();
+        QCOMPARE(conflict["field"].toString(), QString("description"));
+        QCOMPARE(conflict["winner"].toString(), QString("right"));
+        QVERIFY(report.atEnd());
+
+        // Результат не зависит от того, какое хранилище левое
+        const QString swappedPath = m_tempPath + "/sync-swapped.json";
+        QVERIFY(TaskSync::merge(rightPath, leftPath, swappedPath).ok);
+        QFile first(outputPath);
+        QFile second(swappedPath);
+        QVERIFY(first.open(QIODevice::ReadOnly) && second.open(QIODevice::ReadOnly));
+        QCOMPARE(first.readAll(), second.readAll());
+
+        // Правка после удаления возвращает задачу
+        QJsonObject editedB = TaskModel::taskToJson(b);
+        editedB["stamps"] = QJsonObject{{"title", QDateTime::currentDateTime().addSecs(120).toMSecsSinceEpoch()}};
+        QVERIFY(!TaskSync::mergeTask(editedB, deletedB).contains("deletedAt"));
+        QVERIFY(TaskSync::mergeTask(TaskModel::taskToJson(b), deletedB).contains("deletedAt"));
+    }
+
     void testHeaderData() {
         TaskModel model(nullptr);
         QCOMPARE(model.headerData(TaskModel::TitleColumn, Qt::Horizontal, Qt::DisplayRole).toString(), QString("Название"));
@@ -114,6 +871,21 @@ private slots:
         
         index = model.findTask(QUuid::createUuid());
         QCOMPARE(index, -1);
+
+        // Хэш UID → строка следует за удалением и заменой задачи
+        Task second = createTestTask("Task 2");
+        Task third = createTestTask("Task 3");
+        model.addTask(second);
+        model.addTask(third);
+        model.removeTask(0);
+        QCOMPARE(model.findTask(task.uid()), -1);
+        QCOMPARE(model.findTask(second.uid()), 0);
+        QCOMPARE(model.findTask(third.uid()), 1);
+
+        Task replacement = createTestTask("Replacement");
+        model.updateTask(0, replacement);
+        QCOMPARE(model.findTask(second.uid()), -1);
+        QCOMPARE(model.findTask(replacement.uid()), 0);
     }
 
     void testFindTasksByProject() {
@@ -237,6 +1009,164 @@ private slots:
             QCOMPARE(model.rowCount(), 2);
             QCOMPARE(model.getTask(0).title(), QString("Task 1"));
             QCOMPARE(model.getTask(1).title(), QString("Task 2"));
+            QCOMPARE(model.getTask(0).estimatedMinutes(), 60);
+        }
+
+        // Серия сохраняется одной записью с правилом повторения
+        {
+            TaskModel model(nullptr);
+            Task series = createTestTask("Series");
+            series.setIsProjectTask(true);
+            Recurrence rule = Recurrence::fromRRule("FREQ=DAILY;INTERVAL=2;COUNT=10");
+            rule.addException(series.startDateTime().date().addDays(2));
+            series.setRecurrence(rule);
+            model.addTask(series);
+            QVERIFY(model.saveTasks());
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.rowCount(), 1);
+            QCOMPARE(model.getTask(0).recurrence().toRRule(), QString("FREQ=DAILY;INTERVAL=2;COUNT=10"));
+            QCOMPARE(model.getTask(0).recurrence().exceptions().size(), 1);
+        }
+
+        // Подзадача, записанная раньше родителя, после загрузки остаётся в его поддереве
+        {
+            TaskModel model(nullptr);
+            Task parent = createTestTask("Parent");
+            Task child = createTestTask("Child");
+            child.setParentUid(parent.uid());
+            model.addTask(child);
+            model.addTask(parent);
+            QVERIFY(model.saveTasks());
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.getTask(0).parentUid(), model.getTask(1).uid());
+            QCOMPARE(model.parentOf(model.getTask(0).uid()), model.getTask(1).uid());
+            QCOMPARE(model.progress(model.getTask(1).uid()).total, 1);
+        }
+
+        // Зависимость на задачу, записанную позже, восстанавливается при загрузке
+        {
+            TaskModel model(nullptr);
+            Task first = createTestTask("First");
+            Task second = createTestTask("Second");
+            model.addTask(second);
+            model.addTask(first);
+            QVERIFY(model.addDependency(first.uid(), second.uid()));
+            QVERIFY(model.saveTasks());
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.getTask(0).dependencies(), QVector<QUuid>{model.getTask(1).uid()});
+            QVERIFY(model.dependencyGraph().contains(model.getTask(0).uid()));
+        }
+
+        // Два экземпляра меняют разные поля одной задачи — после сохранений сохранены оба изменения
+        {
+            TaskModel first(nullptr);
+            TaskModel second(nullptr);
+            first.addTask(createTestTask("Shared"));
+            QVERIFY(first.saveTasks());
+            QVERIFY(second.loadTasks());
+            Task done = first.getTask(0);
+            done.setStatus("Выполнено");
+            first.updateTask(0, done);
+            QVERIFY(first.saveTasks());
+            Task renamed = second.getTask(0);
+            renamed.setTitle("Renamed");
+            second.updateTask(0, renamed);
+            QVERIFY(second.saveTasks());
+            QCOMPARE(second.getTask(0).status(), QString("Выполнено"));
+            QVERIFY(QFile::exists(TaskModel::tasksFilePath()));
+            QVERIFY(TaskModel::readTasksFileVersion(TaskModel::tasksFilePath()) > 0);
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.rowCount(), 1);
+            QCOMPARE(model.getTask(0).title(), QString("Renamed"));
+            QCOMPARE(model.getTask(0).status(), QString("Выполнено"));
+        }
+
+        // Корзина сохраняется в том же файле и не попадает в строки
+        {
+            TaskModel model(nullptr);
+            model.addTask(createTestTask("Kept"));
+            model.addTask(createTestTask("Deleted"));
+            model.removeTask(1);
+            QVERIFY(model.saveTasks());
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.rowCount(), 1);
+            QCOMPARE(model.getTask(0).title(), QString("Kept"));
+            QCOMPARE(model.deletedCount(), 1);
+            QCOMPARE(model.deletedTasks().first().task.title(), QString("Deleted"));
+            QVERIFY(model.deletedTasks().first().deletedAt.isValid());
+        }
+
+        // Оборванная запись: загружается предыдущее поколение, испорченный файл убирается в .damaged
+        const QString filePath = TaskModel::tasksFilePath();
+        {
+            QFile file(filePath);
+            QVERIFY(file.open(QIODevice::ReadWrite));
+            QVERIFY(file.resize(file.size() / 2));
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.loadStatus(), TaskModel::PreviousLoaded);
+            QCOMPARE(model.rowCount(), 1);
+            QCOMPARE(model.getTask(0).title(), QString("Renamed"));
+            QVERIFY(QFile::exists(filePath + ".damaged"));
+            QVERIFY(!QFile::exists(filePath));
+            // Сохранение после восстановления не делает испорченный файл предыдущим поколением
+            QVERIFY(model.saveTasks());
+            QVERIFY(TaskModel::readTasksFile(LockedSaveFile::previousPath(filePath)).ok);
+        }
+
+        // Разбираемый JSON с несовпадающей контрольной суммой тоже повреждён
+        {
+            QFile previous(LockedSaveFile::previousPath(filePath));
+            QVERIFY(previous.open(QIODevice::ReadOnly));
+            QFile file(filePath);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(previous.readAll().replace("Renamed", "Renamex"));
+        }
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.loadStatus(), TaskModel::PreviousLoaded);
+            QCOMPARE(model.getTask(0).title(), QString("Renamed"));
+        }
+
+        // Пропавший файл (испорченный уже убран в .damaged) — тоже предыдущее поколение, но по другой причине
+        QVERIFY(!QFile::exists(filePath));
+        {
+            TaskModel model(nullptr);
+            QVERIFY(model.loadTasks());
+            QCOMPARE(model.loadStatus(), TaskModel::PreviousLoadedMissing);
+            QCOMPARE(model.getTask(0).title(), QString("Renamed"));
+        }
+
+        // Без целого поколения загрузка не удаётся, а не подменяет задачи пустым списком
+        QVERIFY(QFile::remove(LockedSaveFile::previousPath(filePath)));
+        {
+            TaskModel model(nullptr);
+            QVERIFY(!model.loadTasks());
+            QCOMPARE(model.loadStatus(), TaskModel::FileMissing);
+        }
+        QVERIFY(QFile::copy(filePath + ".damaged", filePath));
+        {
+            TaskModel model(nullptr);
+            QVERIFY(!model.loadTasks());
+            QCOMPARE(model.loadStatus(), TaskModel::FileDamaged);
         }
     }
 
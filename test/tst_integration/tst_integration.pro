@@ -7,11 +7,27 @@ SOURCES += tst_integration.cpp \
            ../../taskmodel.cpp \
            ../../taskfilterproxymodel.cpp \
            ../../task.cpp \
-           ../../customdatamanager.cpp
+           ../../customdatamanager.cpp \
+           ../../perfmonitor.cpp \
+           ../../tracing.cpp \
+           ../../taskintervalindex.cpp \
+           ../../recurrence.cpp \
+           ../../taskdependencygraph.cpp \
+           ../../rowbitmap.cpp \
+           ../../lockedsavefile.cpp \
+           ../../tasksync.cpp
 
 HEADERS += ../../taskmodel.h \
            ../../taskfilterproxymodel.h \
            ../../customdatamanager.h \
-           ../../task.h
+           ../../task.h \
+           ../../perfmonitor.h \
+           ../../tracing.h \
+           ../../taskintervalindex.h \
+           ../../recurrence.h \
+           ../../taskdependencygraph.h \
+           ../../rowbitmap.h \
+           ../../lockedsavefile.h \
+           ../../tasksync.h
 
 INCLUDEPATH += ../../
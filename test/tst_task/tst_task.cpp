@@ -1,6 +1,7 @@
 // tst_task.cpp
 #include <QtTest>
 #include "task.h"
+#include "schedulelayout.h"
 
 class TaskTest : public QObject
 {
@@ -18,6 +19,8 @@ private slots:
     void dateTimeTests();
     void formatDateTests();
     void uidTests();
+    void scheduleLayoutTests();
+    void recurrenceTests();
 };
 
 void TaskTest::initTestCase()
@@ -135,5 +138,106 @@ void TaskTest::uidTests()
     QCOMPARE(t1.uid(), testUid);
 }
 
+void TaskTest::scheduleLayoutTests()
+{
+    QDate day(2025, 3, 10);
+    auto makeTask = [](const QDateTime &start, const QDateTime &end) {
+        Task t;
+        t.setIsProjectTask(true);
+        t.setStartDateTime(start);
+        t.setEndDateTime(end);
+        return t;
+    };
+
+    // Две пересекающиеся задачи занимают разные колонки, третья возвращается в первую
+    QVector<Task> tasks = {
+        makeTask(QDateTime(day, QTime(9, 0)), QDateTime(day, QTime(10, 0))),
+        makeTask(QDateTime(day, QTime(9, 30)), QDateTime(day, QTime(11, 0))),
+        makeTask(QDateTime(day, QTime(10, 0)), QDateTime(day, QTime(10, 30)))
+    };
+    QVector<ScheduleBlock> blocks = ScheduleLayout::layoutDay(tasks);
+    QCOMPARE(blocks.size(), 3);
+    QCOMPARE(blocks[0].column, 0);
+    QCOMPARE(blocks[1].column, 1);
+    QCOMPARE(blocks[2].column, 0);
+    QCOMPARE(blocks[0].columnsCount, 2);
+    QCOMPARE(blocks[1].startMinute, 9 * 60 + 30);
+    QCOMPARE(blocks[1].endMinute, 11 * 60);
+
+    // Задача на несколько дней обрезается по границам каждого дня
+    Task longTask = makeTask(QDateTime(day, QTime(22, 0)), QDateTime(day.addDays(2), QTime(2, 0)));
+    QHash<QDate, QVector<Task>> byDay = ScheduleLayout::tasksByDay({longTask}, day, day.addDays(2));
+    QCOMPARE(byDay.size(), 3);
+    QCOMPARE(byDay[day.addDays(1)].first().startDateTime(), QDateTime(day.addDays(1), QTime(0, 0)));
+    QCOMPARE(byDay[day.addDays(1)].first().endDateTime(), QDateTime(day.addDays(1), QTime(23, 59)));
+    QCOMPARE(ScheduleLayout::tasksForDay({longTask}, day.addDays(3)).size(), 0);
+}
+
+void TaskTest::recurrenceTests()
+{
+    // Еженедельная серия из пяти вхождений, третье исключено
+    QDate monday(2025, 3, 3);
+    Task series;
+    series.setTitle("Планёрка");
+    series.setIsProjectTask(true);
+    series.setStartDateTime(QDateTime(monday, QTime(10, 0)));
+    series.setEndDateTime(QDateTime(monday, QTime(11, 0)));
+    Recurrence rule = Recurrence::fromRRule("FREQ=WEEKLY;COUNT=5");
+    QCOMPARE(rule.toRRule(), QString("FREQ=WEEKLY;INTERVAL=1;COUNT=5"));
+    rule.addException(QDate(2025, 3, 17));
+    OccurrenceOverride moved;
+    moved.start = QDateTime(QDate(2025, 3, 24), QTime(14, 0));
+    moved.end = QDateTime(QDate(2025, 3, 24), QTime(15, 0));
+    moved.title = "Планёрка (перенос)";
+    rule.setOverride(QDate(2025, 3, 24), moved);
+    series.setRecurrence(rule);
+    QVERIFY(series.isRecurring());
+
+    QCOMPARE(rule.occurrenceDates(monday, QDate(2025, 3, 1), QDate(2025, 4, 30)),
+             QVector<QDate>({QDate(2025, 3, 3), QDate(2025, 3, 10), QDate(2025, 3, 24), QDate(2025, 3, 31)}));
+
+    // Вхождения разворачиваются только для окна и несут UID серии
+    QVector<Task> occurrences = Recurrence::expand(series, QDate(2025, 3, 24), QDate(2025, 3, 24));
+    QCOMPARE(occurrences.size(), 1);
+    QVERIFY(occurrences.first().isOccurrence());
+    QVERIFY(!occurrences.first().isRecurring());
+    QCOMPARE(occurrences.first().uid(), series.uid());
+    QCOMPARE(occurrences.first().title(), QString("Планёрка (перенос)"));
+    QCOMPARE(occurrences.first().startDateTime(), moved.start);
+    QCOMPARE(ScheduleLayout::tasksForDay({series}, QDate(2025, 3, 10)).size(), 1);
+    QCOMPARE(ScheduleLayout::tasksForDay({series}, QDate(2025, 3, 17)).size(), 0);
+    QCOMPARE(ScheduleLayout::tasksByDay({series}, QDate(2025, 3, 1), QDate(2025, 4, 30)).size(), 4);
+
+    // Серия без времени: каждое вхождение попадает в окно своим сроком
+    Task untimed;
+    untimed.setTitle("Отчёт");
+    untimed.setIsProjectTask(false);
+    untimed.setStartDateTime(QDateTime(monday, QTime(0, 0)));
+    untimed.setEndDateTime(QDateTime(monday, QTime(0, 0)));
+    untimed.setRecurrence(Recurrence::fromRRule("FREQ=WEEKLY;COUNT=3"));
+    const QVector<Task> weekly = Recurrence::expand(untimed, QDate(2025, 3, 10), QDate(2025, 3, 10));
+    QCOMPARE(weekly.size(), 1);
+    QCOMPARE(weekly.first().dueDateTime().date(), QDate(2025, 3, 10));
+    QCOMPARE(Recurrence::expand(untimed, QDate(2025, 3, 1), QDate(2025, 3, 31)).size(), 3);
+
+    // Исключения и изменения переживают сохранение
+    Recurrence restored = Recurrence::fromJson(rule.toJson());
+    QCOMPARE(restored.toRRule(), rule.toRRule());
+    QVERIFY(restored.exceptions().contains(QDate(2025, 3, 17)));
+    QCOMPARE(restored.overrides().value(QDate(2025, 3, 24)).title, moved.title);
+
+    // Ежемесячно 31-го: месяцы без такого числа пропускаются
+    Recurrence monthly;
+    monthly.setFrequency(Recurrence::Monthly);
+    QCOMPARE(monthly.occurrenceDates(QDate(2025, 1, 31), QDate(2025, 1, 1), QDate(2025, 5, 31)),
+             QVector<QDate>({QDate(2025, 1, 31), QDate(2025, 3, 31), QDate(2025, 5, 31)}));
+
+    // Первое вхождение окна у давней серии вычисляется без перебора
+    Recurrence daily = Recurrence::fromRRule("FREQ=DAILY;INTERVAL=3;UNTIL=20251231");
+    QCOMPARE(daily.occurrenceDates(QDate(2020, 1, 1), QDate(2025, 3, 10), QDate(2025, 3, 12)),
+             QVector<QDate>({QDate(2025, 3, 11)}));
+    QVERIFY(daily.occurrenceDates(QDate(2020, 1, 1), QDate(2026, 1, 1), QDate(2026, 1, 31)).isEmpty());
+}
+
 QTEST_APPLESS_MAIN(TaskTest)
 #include "tst_task.moc"
@@ -4,6 +4,9 @@ QMAKE_LFLAGS += -fprofile-arcs -lgcov
 CONFIG += debug
 CONFIG += console c++17 cmdline
 SOURCES += ../../task.cpp \
+           ../../schedulelayout.cpp \
+           ../../tracing.cpp \
+           ../../recurrence.cpp \
            tst_task.cpp
 INCLUDEPATH += ../../
 
@@ -0,0 +1,204 @@
+/**
+ * @file tracing.cpp
+ * @brief Реализация трассировки с кольцевыми буферами на поток.
+ */
+#include "tracing.h"
+
+Q_LOGGING_CATEGORY(lcTaskHotPath, "taskm.hotpath", QtInfoMsg)
+
+#ifdef TASKM_TRACING
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char *name = nullptr;
+    qint64 startNs = 0;
+    qint64 durationNs = 0;
+};
+
+/**
+ * @brief Слот кольцевого буфера. Поля атомарные: экспорт читает слот, пока владелец
+ * может его перезаписывать, и такие слоты потом отбрасывает по head.
+ */
+struct TraceSlot {
+    std::atomic<const char *> name{nullptr};
+    std::atomic<qint64> startNs{0};
+    std::atomic<qint64> durationNs{0};
+};
+
+/**
+ * @brief Кольцевой буфер одного потока: пишет только владелец, читает экспорт.
+ *
+ * head меняет только владелец. clear() не трогает head, а сдвигает начало
+ * видимой части (clearedAt) — её меняет только clear() под registryMutex.
+ */
+struct ThreadRing {
+    static constexpr quint64 kCapacity = 1 << 14;
+    std::array<TraceSlot, kCapacity> events;
+    std::atomic<quint64> head{0};
+    std::atomic<quint64> clearedAt{0};
+    quint64 threadId = 0;
+};
+
+QElapsedTimer &traceClock()
+{
+    static QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+std::atomic<bool> g_enabled{true};
+
+QMutex &registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+std::vector<std::unique_ptr<ThreadRing>> &registry()
+{
+    static std::vector<std::unique_ptr<ThreadRing>> rings;
+    return rings;
+}
+
+ThreadRing *currentRing()
+{
+    // Регистрация — единственное место с блокировкой, один раз на поток
+    thread_local ThreadRing *ring = []() {
+        auto created = std::make_unique<ThreadRing>();
+        created->threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+        ThreadRing *raw = created.get();
+        QMutexLocker locker(&registryMutex());
+        registry().push_back(std::move(created));
+        return raw;
+    }();
+    return ring;
+}
+
+} // namespace
+
+namespace Tracing {
+
+bool isCompiledIn() { return true; }
+
+void setEnabled(bool enabled) { g_enabled.store(enabled, std::memory_order_relaxed); }
+
+bool isEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void clear()
+{
+    QMutexLocker locker(&registryMutex());
+    for (auto &ring : registry())
+        ring->clearedAt.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+bool exportChromeTrace(const QString &filePath)
+{
+    QJsonArray traceEvents;
+    {
+        QMutexLocker locker(&registryMutex());
+        for (const auto &ring : registry()) {
+            quint64 head = ring->head.load(std::memory_order_acquire);
+            quint64 first = head > ThreadRing::kCapacity ? head - ThreadRing::kCapacity : 0;
+            first = std::max(first, ring->clearedAt.load(std::memory_order_relaxed));
+            QVector<TraceEvent> copy;
+            copy.reserve(static_cast<int>(head - first));
+            for (quint64 i = first; i < head; ++i) {
+                const TraceSlot &slot = ring->events[i % ThreadRing::kCapacity];
+                copy.append({slot.name.load(std::memory_order_relaxed),
+                             slot.startNs.load(std::memory_order_relaxed),
+                             slot.durationNs.load(std::memory_order_relaxed)});
+            }
+
+            // Слоты, которые владелец успел перезаписать во время копирования, отбрасываем.
+            // Владелец пишет слот headAfter ещё до публикации headAfter + 1, а этот слот
+            // совпадает со слотом headAfter - kCapacity — он тоже может быть записан наполовину.
+            // Барьер парный барьеру в ~Span: увидев новые данные слота, увидим и head
+            std::atomic_thread_fence(std::memory_order_acquire);
+            quint64 headAfter = ring->head.load(std::memory_order_relaxed);
+            quint64 overwritten = headAfter + 1 > ThreadRing::kCapacity ? headAfter + 1 - ThreadRing::kCapacity : 0;
+            int skip = overwritten > first ? static_cast<int>(std::min(overwritten - first, head - first)) : 0;
+
+            for (int i = skip; i < copy.size(); ++i) {
+                const TraceEvent &event = copy[i];
+                if (!event.name)
+                    continue;
+                QJsonObject obj;
+                obj["name"] = QString::fromLatin1(event.name);
+                obj["ph"] = "X";
+                obj["ts"] = event.startNs / 1000.0;
+                obj["dur"] = event.durationNs / 1000.0;
+                obj["pid"] = 1;
+                obj["tid"] = static_cast<qint64>(ring->threadId);
+                traceEvents.append(obj);
+            }
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Couldn't open trace file.");
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.close();
+    return true;
+}
+
+Span::Span(const char *name)
+    : m_name(name), m_startNs(traceClock().nsecsElapsed())
+{
+}
+
+Span::~Span()
+{
+    if (!g_enabled.load(std::memory_order_relaxed))
+        return;
+    ThreadRing *ring = currentRing();
+    quint64 head = ring->head.load(std::memory_order_relaxed);
+    TraceSlot &slot = ring->events[head % ThreadRing::kCapacity];
+    // Барьер до записи слота: экспорт, увидевший новые данные, увидит и текущий head
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(m_name, std::memory_order_relaxed);
+    slot.startNs.store(m_startNs, std::memory_order_relaxed);
+    slot.durationNs.store(traceClock().nsecsElapsed() - m_startNs, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace Tracing
+
+#else // TASKM_TRACING
+
+namespace Tracing {
+
+bool isCompiledIn() { return false; }
+void setEnabled(bool) {}
+bool isEnabled() { return false; }
+void clear() {}
+bool exportChromeTrace(const QString &) { return false; }
+
+} // namespace Tracing
+
+#endif // TASKM_TRACING
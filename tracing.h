@@ -0,0 +1,86 @@
+/**
+ * @file tracing.h
+ * @brief Лёгкая трассировка горячих участков в формате Chrome Trace.
+ *
+ * Интервалы (spans) размечаются макросом TRACE_SCOPE("имя") и пишутся в
+ * кольцевой буфер своего потока без блокировок. Трассировка собирается только
+ * при определённом TASKM_TRACING (отладочная сборка), в релизе макрос пустой.
+ */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QLoggingCategory>
+
+/**
+ * @brief Категория для подробного журнала горячих путей (debug выключен по умолчанию).
+ *
+ * Включается правилом QT_LOGGING_RULES="taskm.hotpath.debug=true".
+ */
+Q_DECLARE_LOGGING_CATEGORY(lcTaskHotPath)
+
+namespace Tracing {
+
+/**
+ * @brief Собрана ли трассировка в этой сборке.
+ */
+bool isCompiledIn();
+/**
+ * @brief Включить или выключить запись интервалов во время работы.
+ * @param enabled Флаг записи.
+ */
+void setEnabled(bool enabled);
+/**
+ * @brief Включена ли запись интервалов.
+ */
+bool isEnabled();
+/**
+ * @brief Очистить буферы всех потоков.
+ *
+ * Безопасно при работающей записи: сдвигает начало видимой части буферов, а
+ * не их счётчики, которые меняет только поток-владелец.
+ */
+void clear();
+/**
+ * @brief Сохранить накопленные интервалы в JSON для chrome://tracing или Perfetto.
+ *
+ * Можно вызывать при включённой записи: интервалы, которые другие потоки
+ * перезаписывают во время копирования, отбрасываются.
+ * @param filePath Путь к файлу.
+ * @return true если успешно.
+ */
+bool exportChromeTrace(const QString &filePath);
+
+#ifdef TASKM_TRACING
+/**
+ * @class Span
+ * @brief RAII-интервал: записывается в буфер потока при выходе из области.
+ *
+ * Имя должно быть строковым литералом — указатель хранится без копирования.
+ */
+class Span
+{
+public:
+    explicit Span(const char *name);
+    ~Span();
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_startNs;
+};
+#endif
+
+} // namespace Tracing
+
+#ifdef TASKM_TRACING
+#define TASKM_TRACE_CONCAT_IMPL(a, b) a##b
+#define TASKM_TRACE_CONCAT(a, b) TASKM_TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) Tracing::Span TASKM_TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) do {} while (false)
+#endif
+
+#endif // TRACING_H